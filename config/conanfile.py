@@ -38,6 +38,9 @@ class KatanaConan(ConanFile):
         # find conan's libraries.
         #
         # According to [1], only snappy and gzip are expected to be present.
+        # Graphs can therefore only be written with the snappy, gzip and
+        # brotli codecs; PropWriteOptions and SetTopologyCompression return
+        # NotImplemented for the others.
         #
         # [1] https://arrow.apache.org/docs/r/reference/write_parquet.html
         #
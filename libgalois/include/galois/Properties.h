@@ -1,11 +1,16 @@
 #ifndef GALOIS_LIBGALOIS_GALOIS_PROPERTIES_H_
 #define GALOIS_LIBGALOIS_GALOIS_PROPERTIES_H_
 
+#include <algorithm>
 #include <cassert>
+#include <memory>
+#include <optional>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include <arrow/array.h>
+#include <arrow/chunked_array.h>
 #include <arrow/stl.h>
 #include <arrow/type_fwd.h>
 #include <arrow/type_traits.h>
@@ -104,6 +109,48 @@ struct PropertyArrowTuple<std::tuple<Args...>> {
       typename arrow::TypeTraits<galois::PropertyArrowType<Args>>::CType...>;
 };
 
+/// ChunkedViews holds a view for each chunk of a property stored as more than
+/// one arrow::Array and finds the view that holds a given row. Rows are found
+/// by binary search over the first row of each chunk.
+template <typename View>
+class ChunkedViews {
+public:
+  explicit ChunkedViews(std::vector<View> views) : views_(std::move(views)) {
+    starts_.reserve(views_.size() + 1);
+    size_t start = 0;
+    for (const View& view : views_) {
+      starts_.emplace_back(start);
+      start += view.size();
+    }
+    starts_.emplace_back(start);
+  }
+
+  /// Return the view holding row i and the position of row i in that view
+  std::pair<View*, size_t> Find(size_t i) {
+    size_t chunk = FindChunk(i);
+    return std::make_pair(&views_[chunk], i - starts_[chunk]);
+  }
+
+  std::pair<const View*, size_t> Find(size_t i) const {
+    size_t chunk = FindChunk(i);
+    return std::make_pair(&views_[chunk], i - starts_[chunk]);
+  }
+
+  size_t size() const { return starts_.back(); }
+
+private:
+  size_t FindChunk(size_t i) const {
+    assert(i < size());
+    // Empty chunks start where the next chunk starts, so searching for the
+    // last start not after i skips them
+    auto it = std::upper_bound(starts_.begin(), starts_.end() - 1, i);
+    return (it - starts_.begin()) - 1;
+  }
+
+  std::vector<View> views_;
+  std::vector<size_t> starts_;
+};
+
 }  // namespace internal
 
 /// PropertyViewTuple applies PropertyViewType to a tuple of properties.
@@ -139,23 +186,54 @@ ConstructPropertyView(arrow::Array* array) {
   return ViewType::Make(*t);
 }
 
+/// ConstructPropertyView applies a property view to an arrow::ChunkedArray.
+/// The view refers to the chunks in place; a column with more than one chunk
+/// is not combined into a single array first.
+///
+/// \tparam   Prop  A property
+/// \param    array A chunked array to apply view to
+/// \returns  The view corresponding to given array or an error if some chunk
+///   cannot be downcast to the array type for the property.
+template <typename Prop>
+Result<PropertyViewType<Prop>>
+ConstructPropertyView(arrow::ChunkedArray* array) {
+  using ArrowArrayType = PropertyArrowArrayType<Prop>;
+  using ViewType = PropertyViewType<Prop>;
+
+  if (array->num_chunks() == 1) {
+    return ConstructPropertyView<Prop>(array->chunk(0).get());
+  }
+
+  std::vector<const ArrowArrayType*> chunks;
+  chunks.reserve(array->num_chunks());
+  for (const auto& chunk : array->chunks()) {
+    auto* t = dynamic_cast<const ArrowArrayType*>(chunk.get());
+    if (!t) {
+      return galois::ErrorCode::TypeError;
+    }
+    chunks.emplace_back(t);
+  }
+
+  return ViewType::Make(chunks);
+}
+
 /// ConstructPropertyViews applies ConstructPropertyView to a tuple of
 /// properties.
 ///
 /// \tparam   PropTuple a tuple of properties
+/// \tparam   ArrayType arrow::Array or arrow::ChunkedArray
 ///
 /// \see ConstructPropertyView
-template <typename PropTuple>
+template <typename PropTuple, typename ArrayType>
 Result<std::tuple<>>
-ConstructPropertyViews(
-    const std::vector<arrow::Array*>&, std::index_sequence<>) {
+ConstructPropertyViews(const std::vector<ArrayType*>&, std::index_sequence<>) {
   return std::tuple<>();
 }
 
-template <typename PropTuple, size_t head, size_t... tail>
+template <typename PropTuple, typename ArrayType, size_t head, size_t... tail>
 Result<TupleElements<PropertyViewTuple<PropTuple>, head, tail...>>
 ConstructPropertyViews(
-    const std::vector<arrow::Array*>& arrays,
+    const std::vector<ArrayType*>& arrays,
     std::index_sequence<head, tail...>) {
   using Prop = std::tuple_element_t<head, PropTuple>;
   using View = PropertyViewType<Prop>;
@@ -175,9 +253,9 @@ ConstructPropertyViews(
       std::tuple<View>(std::move(v.value())), std::move(rest.value()));
 }
 
-template <typename PropTuple>
+template <typename PropTuple, typename ArrayType>
 Result<PropertyViewTuple<PropTuple>>
-ConstructPropertyViews(const std::vector<arrow::Array*>& arrays) {
+ConstructPropertyViews(const std::vector<ArrayType*>& arrays) {
   return ConstructPropertyViews<PropTuple>(
       arrays, std::make_index_sequence<std::tuple_size_v<PropTuple>>());
 }
@@ -261,20 +339,57 @@ public:
         array.offset());
   }
 
+  /// Make a view over a property stored as several arrays. Each access first
+  /// finds the array that holds the element; the arrays are not copied.
+  template <typename ArrowArrayType>
+  static Result<PODPropertyView> Make(
+      const std::vector<const ArrowArrayType*>& chunks) {
+    std::vector<PODPropertyView> views;
+    views.reserve(chunks.size());
+    for (const ArrowArrayType* chunk : chunks) {
+      auto view_result = Make(*chunk);
+      if (!view_result) {
+        return view_result.error();
+      }
+      views.emplace_back(std::move(view_result.value()));
+    }
+    return PODPropertyView(
+        std::make_shared<internal::ChunkedViews<PODPropertyView>>(
+            std::move(views)));
+  }
+
   bool IsValid(size_t i) const {
     assert(i < length_);
-    return null_bitmap_ == nullptr ||
-           arrow::BitUtil::GetBit(null_bitmap_, i + offset_);
+    if (values_ != nullptr) {
+      return null_bitmap_ == nullptr ||
+             arrow::BitUtil::GetBit(null_bitmap_, i + offset_);
+    }
+    auto [view, j] = std::as_const(*chunks_).Find(i);
+    return view->IsValid(j);
   }
 
-  reference GetValue(size_t i) { return values_[i + offset_]; }
+  reference GetValue(size_t i) {
+    if (values_ != nullptr) {
+      return values_[i + offset_];
+    }
+    auto [view, j] = chunks_->Find(i);
+    return view->GetValue(j);
+  }
 
-  const_reference GetValue(size_t i) const { return values_[i + offset_]; }
+  const_reference GetValue(size_t i) const {
+    if (values_ != nullptr) {
+      return values_[i + offset_];
+    }
+    auto [view, j] = std::as_const(*chunks_).Find(i);
+    return view->GetValue(j);
+  }
 
   reference operator[](size_t i) { return GetValue(i); }
 
   const_reference operator[](size_t i) const { return GetValue(i); }
 
+  size_t size() const { return length_; }
+
 private:
   PODPropertyView(
       T* values, const uint8_t* null_bitmap, size_t length, size_t offset)
@@ -283,9 +398,21 @@ private:
         length_(length),
         offset_(offset) {}
 
+  explicit PODPropertyView(
+      std::shared_ptr<internal::ChunkedViews<PODPropertyView>> chunks)
+      : values_(nullptr),
+        null_bitmap_(nullptr),
+        length_(chunks->size()),
+        offset_(0),
+        chunks_(std::move(chunks)) {}
+
+  // Null for views over more than one array, which keeps the check on the
+  // common single array path to the pointer it reads anyway
   T* values_;
   const uint8_t* null_bitmap_;
   size_t length_, offset_;
+  // Set only for views over more than one array
+  std::shared_ptr<internal::ChunkedViews<PODPropertyView>> chunks_;
 };
 
 /// BooleanPropertyReadOnlyView provides a read-only property view over
@@ -299,17 +426,38 @@ public:
 
   static Result<BooleanPropertyReadOnlyView> Make(
       const arrow::BooleanArray& array) {
-    return BooleanPropertyReadOnlyView(array);
+    return BooleanPropertyReadOnlyView(&array);
+  }
+
+  static Result<BooleanPropertyReadOnlyView> Make(
+      const std::vector<const arrow::BooleanArray*>& chunks) {
+    std::vector<BooleanPropertyReadOnlyView> views;
+    views.reserve(chunks.size());
+    for (const arrow::BooleanArray* chunk : chunks) {
+      views.emplace_back(BooleanPropertyReadOnlyView(chunk));
+    }
+    return BooleanPropertyReadOnlyView(
+        std::make_shared<
+            internal::ChunkedViews<BooleanPropertyReadOnlyView>>(
+            std::move(views)));
   }
 
   bool IsValid(size_t i) const {
-    assert(i < (size_t)array_.length());
-    return array_.IsValid(i);
+    assert(i < size());
+    if (array_ != nullptr) {
+      return array_->IsValid(i);
+    }
+    auto [view, j] = std::as_const(*chunks_).Find(i);
+    return view->IsValid(j);
   }
 
   value_type GetValue(size_t i) const {
     assert(IsValid(i));
-    return array_.Value(i);
+    if (array_ != nullptr) {
+      return array_->Value(i);
+    }
+    auto [view, j] = std::as_const(*chunks_).Find(i);
+    return view->GetValue(j);
   }
 
   value_type operator[](size_t i) const {
@@ -319,11 +467,22 @@ public:
     return GetValue(i);
   }
 
+  size_t size() const { return array_ ? array_->length() : chunks_->size(); }
+
 private:
-  BooleanPropertyReadOnlyView(const arrow::BooleanArray& array)
+  explicit BooleanPropertyReadOnlyView(const arrow::BooleanArray* array)
       : array_(array) {}
 
-  const arrow::BooleanArray& array_;
+  explicit BooleanPropertyReadOnlyView(
+      std::shared_ptr<internal::ChunkedViews<BooleanPropertyReadOnlyView>>
+          chunks)
+      : array_(nullptr), chunks_(std::move(chunks)) {}
+
+  // Null for views over more than one array
+  const arrow::BooleanArray* array_;
+  // Set only for views over more than one array
+  std::shared_ptr<internal::ChunkedViews<BooleanPropertyReadOnlyView>>
+      chunks_;
 };
 
 /// StringPropertyReadOnlyView provides a read-only property view over
@@ -335,16 +494,140 @@ public:
   using value_type = std::string;
 
   static Result<StringPropertyReadOnlyView> Make(const ArrowArrayType& array) {
-    return StringPropertyReadOnlyView(array);
+    return StringPropertyReadOnlyView(&array);
+  }
+
+  static Result<StringPropertyReadOnlyView> Make(
+      const std::vector<const ArrowArrayType*>& chunks) {
+    std::vector<StringPropertyReadOnlyView> views;
+    views.reserve(chunks.size());
+    for (const ArrowArrayType* chunk : chunks) {
+      views.emplace_back(StringPropertyReadOnlyView(chunk));
+    }
+    return StringPropertyReadOnlyView(
+        std::make_shared<internal::ChunkedViews<StringPropertyReadOnlyView>>(
+            std::move(views)));
   }
 
-  bool IsValid(size_t i) const { return array_.IsValid(i); }
+  bool IsValid(size_t i) const {
+    if (array_ != nullptr) {
+      return array_->IsValid(i);
+    }
+    auto [view, j] = std::as_const(*chunks_).Find(i);
+    return view->IsValid(j);
+  }
 
   value_type GetValue(size_t i) const {
     assert(IsValid(i));
-    return array_.GetString(i);
+    if (array_ != nullptr) {
+      return array_->GetString(i);
+    }
+    auto [view, j] = std::as_const(*chunks_).Find(i);
+    return view->GetValue(j);
+  }
+
+  value_type operator[](size_t i) const {
+    if (!IsValid(i)) {
+      return value_type{};
+    }
+    return GetValue(i);
+  }
+
+  size_t size() const { return array_ ? array_->length() : chunks_->size(); }
+
+private:
+  explicit StringPropertyReadOnlyView(const ArrowArrayType* array)
+      : array_(array) {}
+
+  explicit StringPropertyReadOnlyView(
+      std::shared_ptr<internal::ChunkedViews<StringPropertyReadOnlyView>>
+          chunks)
+      : array_(nullptr), chunks_(std::move(chunks)) {}
+
+  // Null for views over more than one array
+  const ArrowArrayType* array_;
+  // Set only for views over more than one array
+  std::shared_ptr<internal::ChunkedViews<StringPropertyReadOnlyView>> chunks_;
+};
+
+/// DictionaryPropertyReadOnlyView provides a read-only property view over
+/// arrow::DictionaryArrays, e.g., of string properties loaded with their
+/// Parquet dictionary encoding. Besides the values, it exposes the integer
+/// code of each element, so that elements can be compared or grouped by code
+/// rather than by value.
+///
+/// All arrays of a property must share one dictionary so that codes mean the
+/// same thing everywhere; properties loaded from storage do.
+///
+/// \tparam IndexType the arrow type of the codes, e.g., arrow::Int32Type
+/// \tparam ValueArrayType the arrow array type of the dictionary, e.g.,
+///   arrow::StringArray
+template <typename IndexType, typename ValueArrayType>
+class DictionaryPropertyReadOnlyView {
+public:
+  using value_type = std::string;
+  using code_type = typename IndexType::c_type;
+
+  static Result<DictionaryPropertyReadOnlyView> Make(
+      const arrow::DictionaryArray& array) {
+    auto index_type = arrow::TypeTraits<IndexType>::type_singleton();
+    if (!array.indices()->type()->Equals(*index_type)) {
+      return galois::ErrorCode::TypeError;
+    }
+    auto* dictionary =
+        dynamic_cast<const ValueArrayType*>(array.dictionary().get());
+    if (!dictionary) {
+      return galois::ErrorCode::TypeError;
+    }
+    return DictionaryPropertyReadOnlyView(
+        &array, array.indices()->data()->template GetValues<code_type>(1),
+        dictionary);
+  }
+
+  static Result<DictionaryPropertyReadOnlyView> Make(
+      const std::vector<const arrow::DictionaryArray*>& chunks) {
+    std::vector<DictionaryPropertyReadOnlyView> views;
+    views.reserve(chunks.size());
+    for (const arrow::DictionaryArray* chunk : chunks) {
+      auto view_result = Make(*chunk);
+      if (!view_result) {
+        return view_result.error();
+      }
+      if (!views.empty() && !SameDictionary(*views.front().array_, *chunk)) {
+        return galois::ErrorCode::InvalidArgument;
+      }
+      views.emplace_back(std::move(view_result.value()));
+    }
+    const ValueArrayType* dictionary =
+        views.empty() ? nullptr : views.front().dictionary_;
+    return DictionaryPropertyReadOnlyView(
+        std::make_shared<
+            internal::ChunkedViews<DictionaryPropertyReadOnlyView>>(
+            std::move(views)),
+        dictionary);
+  }
+
+  bool IsValid(size_t i) const {
+    if (chunks_) {
+      auto [view, j] = std::as_const(*chunks_).Find(i);
+      return view->IsValid(j);
+    }
+    return array_->IsValid(i);
+  }
+
+  /// The code of element i, i.e., the position of its value in the
+  /// dictionary
+  code_type GetCode(size_t i) const {
+    assert(IsValid(i));
+    if (chunks_) {
+      auto [view, j] = std::as_const(*chunks_).Find(i);
+      return view->GetCode(j);
+    }
+    return codes_[i];
   }
 
+  value_type GetValue(size_t i) const { return DictionaryValue(GetCode(i)); }
+
   value_type operator[](size_t i) const {
     if (!IsValid(i)) {
       return value_type{};
@@ -352,10 +635,62 @@ public:
     return GetValue(i);
   }
 
+  /// The value with the given code
+  value_type DictionaryValue(code_type code) const {
+    return dictionary_->GetString(code);
+  }
+
+  /// The code of value, if any element could have it
+  std::optional<code_type> FindCode(std::string_view value) const {
+    if (!dictionary_) {
+      return std::nullopt;
+    }
+    for (int64_t code = 0, n = dictionary_->length(); code < n; ++code) {
+      if (!dictionary_->IsValid(code)) {
+        continue;
+      }
+      auto view = dictionary_->GetView(code);
+      if (std::string_view(view.data(), view.size()) == value) {
+        return static_cast<code_type>(code);
+      }
+    }
+    return std::nullopt;
+  }
+
+  /// Number of distinct values (and codes)
+  size_t dictionary_size() const {
+    return dictionary_ ? dictionary_->length() : 0;
+  }
+
+  size_t size() const { return chunks_ ? chunks_->size() : array_->length(); }
+
 private:
-  StringPropertyReadOnlyView(const ArrowArrayType& array) : array_(array) {}
+  DictionaryPropertyReadOnlyView(
+      const arrow::DictionaryArray* array, const code_type* codes,
+      const ValueArrayType* dictionary)
+      : array_(array), codes_(codes), dictionary_(dictionary) {}
+
+  DictionaryPropertyReadOnlyView(
+      std::shared_ptr<internal::ChunkedViews<DictionaryPropertyReadOnlyView>>
+          chunks,
+      const ValueArrayType* dictionary)
+      : array_(nullptr),
+        codes_(nullptr),
+        dictionary_(dictionary),
+        chunks_(std::move(chunks)) {}
+
+  static bool SameDictionary(
+      const arrow::DictionaryArray& a, const arrow::DictionaryArray& b) {
+    return a.data()->dictionary == b.data()->dictionary ||
+           a.dictionary()->Equals(*b.dictionary());
+  }
 
-  const ArrowArrayType& array_;
+  const arrow::DictionaryArray* array_;
+  const code_type* codes_;
+  const ValueArrayType* dictionary_;
+  // Set only for views over more than one array
+  std::shared_ptr<internal::ChunkedViews<DictionaryPropertyReadOnlyView>>
+      chunks_;
 };
 
 template <typename T>
@@ -387,6 +722,15 @@ struct LargeStringReadOnlyProperty {
   using ViewType = StringPropertyReadOnlyView<arrow::LargeStringArray>;
 };
 
+/// A string property loaded with its dictionary encoding, which is how
+/// string properties that were arrow::DictionaryArrays when they were stored,
+/// e.g., labels or categories, are loaded
+struct DictionaryStringReadOnlyProperty {
+  using ArrowType = arrow::DictionaryType;
+  using ViewType =
+      DictionaryPropertyReadOnlyView<arrow::Int32Type, arrow::StringArray>;
+};
+
 template <typename Props>
 Result<std::shared_ptr<arrow::Table>>
 AllocateTable(uint64_t num_rows, const std::vector<std::string>& names) {
@@ -0,0 +1,131 @@
+#ifndef GALOIS_LIBGALOIS_GALOIS_GRAPHS_COMPRESSEDTOPOLOGY_H_
+#define GALOIS_LIBGALOIS_GALOIS_GRAPHS_COMPRESSEDTOPOLOGY_H_
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include <arrow/api.h>
+
+#include "galois/Result.h"
+#include "galois/config.h"
+
+namespace galois::graphs {
+
+struct GraphTopology;
+
+/// A CompressedTopology is a CSR topology whose edge destinations are gap
+/// encoded.
+///
+/// Destinations are split into blocks of kBlockSize consecutive edges. Within
+/// a block, each destination is stored as the (zigzag encoded) difference from
+/// the previous destination using one to four bytes (Stream VByte): a control
+/// byte holds the byte lengths of four values and is followed, after all the
+/// control bytes of the block, by their data. Sorted adjacency lists usually
+/// need one or two bytes per edge rather than four.
+///
+/// An index of block offsets lets any block be decoded on its own, so edges
+/// can be visited without decompressing the whole topology; see Cursor.
+class GALOIS_EXPORT CompressedTopology {
+public:
+  /// Number of edges in a block
+  static constexpr uint64_t kBlockSize = 128;
+  /// Number of zero bytes after the last block. Decoders may read, but not
+  /// use, up to this many bytes past the end of a block.
+  static constexpr uint64_t kPadding = 16;
+
+  class Cursor;
+
+  CompressedTopology() = default;
+
+  /// Encode the destinations of topology
+  static Result<CompressedTopology> Encode(const GraphTopology& topology);
+
+  /// Make a compressed topology from its parts, e.g., as read from storage.
+  /// Returns an error unless every block decodes to destinations less than
+  /// num_nodes(), so later decoding cannot fail.
+  ///
+  /// \param out_indices is the same as GraphTopology::out_indices
+  /// \param block_offsets holds num_blocks() + 1 uint64_t byte offsets of each
+  /// block in data, the last being the end of the last block
+  /// \param data holds the encoded blocks followed by kPadding bytes
+  static Result<CompressedTopology> Make(
+      std::shared_ptr<arrow::UInt64Array> out_indices, uint64_t num_edges,
+      std::shared_ptr<arrow::Buffer> block_offsets,
+      std::shared_ptr<arrow::Buffer> data);
+
+  /// Decode all destinations into an uncompressed topology
+  Result<GraphTopology> Decompress() const;
+
+  /// Decode the destinations of block into out, which must have room for
+  /// kBlockSize values. Returns the number of destinations in the block.
+  uint64_t DecodeBlock(uint64_t block, uint32_t* out) const;
+
+  uint64_t num_nodes() const {
+    return out_indices_ ? out_indices_->length() : 0;
+  }
+
+  uint64_t num_edges() const { return num_edges_; }
+
+  uint64_t num_blocks() const {
+    return (num_edges_ + kBlockSize - 1) / kBlockSize;
+  }
+
+  std::pair<uint64_t, uint64_t> edge_range(uint32_t node_id) const {
+    auto edge_start = node_id > 0 ? out_indices_->Value(node_id - 1) : 0;
+    auto edge_end = out_indices_->Value(node_id);
+    return std::make_pair(edge_start, edge_end);
+  }
+
+  const std::shared_ptr<arrow::UInt64Array>& out_indices() const {
+    return out_indices_;
+  }
+  const std::shared_ptr<arrow::Buffer>& block_offsets() const {
+    return block_offsets_;
+  }
+  const std::shared_ptr<arrow::Buffer>& data() const { return data_; }
+
+private:
+  std::shared_ptr<arrow::UInt64Array> out_indices_;
+  uint64_t num_edges_{};
+  std::shared_ptr<arrow::Buffer> block_offsets_;
+  std::shared_ptr<arrow::Buffer> data_;
+};
+
+/// A Cursor reads destinations from a CompressedTopology a block at a time and
+/// keeps the last block it decoded, so visiting edges in (mostly) increasing
+/// order decodes each block once. A Cursor is not thread safe; give each
+/// thread its own.
+class CompressedTopology::Cursor {
+public:
+  explicit Cursor(const CompressedTopology* topology) : topology_(topology) {}
+
+  /// Destination of edge
+  uint32_t edge_dest(uint64_t edge) {
+    uint64_t block = edge / kBlockSize;
+    if (block != block_) {
+      topology_->DecodeBlock(block, dests_);
+      block_ = block;
+    }
+    return dests_[edge % kBlockSize];
+  }
+
+  /// Call fn(edge, dest) for each out edge of node_id in order
+  template <typename Fn>
+  void ForEachOutEdge(uint32_t node_id, Fn fn) {
+    auto [begin, end] = topology_->edge_range(node_id);
+    for (uint64_t e = begin; e < end; ++e) {
+      fn(e, edge_dest(e));
+    }
+  }
+
+private:
+  const CompressedTopology* topology_;
+  uint64_t block_{std::numeric_limits<uint64_t>::max()};
+  alignas(16) uint32_t dests_[kBlockSize];
+};
+
+}  // namespace galois::graphs
+
+#endif
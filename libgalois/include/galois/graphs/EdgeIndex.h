@@ -0,0 +1,104 @@
+#ifndef GALOIS_LIBGALOIS_GALOIS_GRAPHS_EDGEINDEX_H_
+#define GALOIS_LIBGALOIS_GALOIS_GRAPHS_EDGEINDEX_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "galois/Result.h"
+#include "galois/config.h"
+#include "galois/graphs/PropertyFileGraph.h"
+
+namespace galois::graphs {
+
+/// An EdgeIndex finds the edge from one node to another without requiring
+/// the topology to be sorted, unlike FindEdgeSortedByDest.
+///
+/// Each node with at least hub_degree out-edges (a hub) has an open
+/// addressing hash table from destination to edge, so looking up its edges
+/// takes constant expected time. The edges of other nodes are binary
+/// searched: in place if every such node has its edges sorted by
+/// destination, and otherwise in a sorted copy of their destinations.
+///
+/// An EdgeIndex shares the arrays of the topology it was made from. It does
+/// not reflect later changes to them, e.g., by SortAllEdgesByDest.
+class GALOIS_EXPORT EdgeIndex {
+public:
+  /// Nodes with at least this many out-edges get a hash table by default
+  static constexpr uint64_t kDefaultHubDegree = 64;
+
+  EdgeIndex() = default;
+
+  /// Index the edges of topology in parallel
+  static Result<EdgeIndex> Make(
+      const GraphTopology& topology,
+      uint64_t hub_degree = kDefaultHubDegree);
+
+  /// The first edge from src to dest or, if there is none, the end of the
+  /// edges of src
+  uint64_t FindEdge(uint32_t src, uint32_t dest) const {
+    auto [begin, end] = topology_.edge_range(src);
+
+    uint64_t table_begin = table_offsets_[src];
+    uint64_t table_end = table_offsets_[src + 1];
+    if (table_begin != table_end) {
+      uint64_t mask = table_end - table_begin - 1;
+      for (uint64_t slot = Hash(dest) & mask;; slot = (slot + 1) & mask) {
+        uint64_t edge = table_edges_[table_begin + slot];
+        if (edge == kEmptySlot) {
+          return end;
+        }
+        if (table_dests_[table_begin + slot] == dest) {
+          return edge;
+        }
+      }
+    }
+
+    const uint32_t* dests =
+        sorted_dests_.empty() ? topology_.out_dests->raw_values()
+                              : sorted_dests_.data();
+    const uint32_t* found = std::lower_bound(dests + begin, dests + end, dest);
+    if (found == dests + end || *found != dest) {
+      return end;
+    }
+    uint64_t edge = found - dests;
+    return sorted_edges_.empty() ? edge : sorted_edges_[edge];
+  }
+
+  bool HasEdge(uint32_t src, uint32_t dest) const {
+    return FindEdge(src, dest) != topology_.edge_range(src).second;
+  }
+
+  uint64_t num_hubs() const { return num_hubs_; }
+
+  /// Whether the edges of nodes that are not hubs are searched in a sorted
+  /// copy rather than in place
+  bool has_sorted_copy() const { return !sorted_dests_.empty(); }
+
+private:
+  static constexpr uint64_t kEmptySlot = std::numeric_limits<uint64_t>::max();
+
+  static uint64_t Hash(uint32_t dest) {
+    return (uint64_t{dest} * 0x9E3779B97F4A7C15ULL) >> 32;
+  }
+
+  GraphTopology topology_;
+  uint64_t num_hubs_{};
+
+  /// The hash table of node n is slots [table_offsets_[n],
+  /// table_offsets_[n + 1]), which is empty unless n is a hub. Tables have a
+  /// power of two slots.
+  std::vector<uint64_t> table_offsets_;
+  std::vector<uint32_t> table_dests_;
+  std::vector<uint64_t> table_edges_;
+
+  /// If not empty, the destinations of each node that is not a hub sorted,
+  /// and the edge of each
+  std::vector<uint32_t> sorted_dests_;
+  std::vector<uint64_t> sorted_edges_;
+};
+
+}  // namespace galois::graphs
+
+#endif
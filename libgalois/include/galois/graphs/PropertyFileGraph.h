@@ -1,17 +1,26 @@
 #ifndef GALOIS_LIBGALOIS_GALOIS_GRAPHS_PROPERTYFILEGRAPH_H_
 #define GALOIS_LIBGALOIS_GALOIS_GRAPHS_PROPERTYFILEGRAPH_H_
 
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include <arrow/api.h>
+#include <arrow/array/concatenate.h>
 #include <arrow/chunked_array.h>
 #include <arrow/type_traits.h>
+#include <arrow/util/compression.h>
 
 #include "galois/ErrorCode.h"
 #include "galois/LargeArray.h"
+#include "galois/Logging.h"
 #include "galois/config.h"
+#include "galois/graphs/CompressedTopology.h"
 #include "tsuba/RDG.h"
 
 namespace galois::graphs {
@@ -38,6 +47,118 @@ struct GraphTopology {
   }
 };
 
+/// A TransposeTopology holds the in-edges of a graph. topology is the CSR
+/// topology of the transposed graph: topology.edge_range(n) are the in-edges
+/// of n, and topology.out_dests holds their sources. edge_ids maps each
+/// in-edge to the out-edge it reverses, which is also the row of its
+/// properties in the edge table, so the transpose shares edge properties with
+/// the graph. The in-edges of a node are sorted by source.
+struct TransposeTopology {
+  GraphTopology topology;
+  std::shared_ptr<arrow::UInt64Array> edge_ids;
+
+  uint64_t num_nodes() const { return topology.num_nodes(); }
+
+  uint64_t num_edges() const { return topology.num_edges(); }
+
+  std::pair<uint64_t, uint64_t> in_edge_range(uint32_t node_id) const {
+    return topology.edge_range(node_id);
+  }
+
+  uint32_t in_edge_source(uint64_t in_edge) const {
+    return topology.out_dests->Value(in_edge);
+  }
+
+  /// The out-edge, and edge table row, of in_edge
+  uint64_t out_edge(uint64_t in_edge) const {
+    return edge_ids->Value(in_edge);
+  }
+};
+
+/// An EdgeTypeTopology groups the out-edges of each node by type, so a
+/// traversal restricted to one type only visits the edges of that type. The
+/// types of an edge are the boolean edge properties named in type_names that
+/// are true for it, e.g., the edge labels made by PropertyGraphBuilder; an
+/// edge with several types appears once under each of them.
+///
+/// edge_range(n, t) are the edges of type t of node n in increasing order of
+/// their out-edge. edge_dest gives their destinations and out_edge maps them
+/// back to their out-edge, which is also the row of their properties in the
+/// edge table.
+struct EdgeTypeTopology {
+  std::vector<std::string> type_names;
+  /// End of the edges of each (node, type) pair; the pairs of a node are
+  /// consecutive
+  std::shared_ptr<arrow::UInt64Array> type_indices;
+  std::shared_ptr<arrow::UInt32Array> dests;
+  std::shared_ptr<arrow::UInt64Array> edge_ids;
+
+  uint64_t num_types() const { return type_names.size(); }
+
+  uint64_t num_nodes() const {
+    return num_types() > 0 ? type_indices->length() / num_types() : 0;
+  }
+
+  /// Number of (edge, type) pairs
+  uint64_t num_edges() const { return dests ? dests->length() : 0; }
+
+  /// The index of the named type, if any
+  std::optional<uint32_t> TypeIndex(const std::string& name) const {
+    auto it = std::find(type_names.begin(), type_names.end(), name);
+    if (it == type_names.end()) {
+      return std::nullopt;
+    }
+    return it - type_names.begin();
+  }
+
+  std::pair<uint64_t, uint64_t> edge_range(
+      uint32_t node_id, uint32_t type) const {
+    uint64_t group = uint64_t{node_id} * num_types() + type;
+    auto edge_start = group > 0 ? type_indices->Value(group - 1) : 0;
+    auto edge_end = type_indices->Value(group);
+    return std::make_pair(edge_start, edge_end);
+  }
+
+  uint32_t edge_dest(uint64_t typed_edge) const {
+    return dests->Value(typed_edge);
+  }
+
+  /// The out-edge, and edge table row, of typed_edge
+  uint64_t out_edge(uint64_t typed_edge) const {
+    return edge_ids->Value(typed_edge);
+  }
+};
+
+/// TopologyEncoding is how the edge destinations of a topology are laid out in
+/// storage
+enum class TopologyEncoding {
+  /// One uint32_t per edge; the topology can be mapped directly
+  Plain,
+  /// Gap encoded blocks; see CompressedTopology
+  GapEncoded,
+};
+
+/// A GraphSnapshot is an immutable version of the topology and properties of
+/// a PropertyFileGraph; see PropertyFileGraph::Snapshot.
+struct GraphSnapshot {
+  /// Increases each time the graph publishes a new version
+  uint64_t version{};
+  GraphTopology topology;
+  std::shared_ptr<arrow::Table> node_table;
+  std::shared_ptr<arrow::Table> edge_table;
+
+  /// The named node property or null if it is not in this version
+  std::shared_ptr<arrow::ChunkedArray> NodeProperty(
+      const std::string& name) const {
+    return node_table->GetColumnByName(name);
+  }
+
+  std::shared_ptr<arrow::ChunkedArray> EdgeProperty(
+      const std::string& name) const {
+    return edge_table->GetColumnByName(name);
+  }
+};
+
 /// A property graph is a graph that has properties associated with its nodes
 /// and edges. A property has a name and value. Its value may be a primitive
 /// type, a list of values or a composition of properties.
@@ -56,17 +177,119 @@ class GALOIS_EXPORT PropertyFileGraph {
   /// Validate performs a sanity check on the the graph after loading
   Result<void> Validate();
 
+  /// Load the named node (or edge) property if this graph was made lazily and
+  /// the property is stored but not loaded yet
+  Result<void> LoadNodePropertyIfUnloaded(const std::string& name) const;
+  Result<void> LoadEdgePropertyIfUnloaded(const std::string& name) const;
+
+  /// Like LoadNodePropertyIfUnloaded, but also look the property up while
+  /// still holding rdg_mutex_, so that a concurrent load cannot change the
+  /// table in between. Returns null if the property does not exist.
+  Result<std::shared_ptr<arrow::ChunkedArray>> FindOrLoadNodeProperty(
+      const std::string& name) const;
+  Result<std::shared_ptr<arrow::ChunkedArray>> FindOrLoadEdgeProperty(
+      const std::string& name) const;
+
+  /// Return a property as a single typed array. Properties loaded in pieces
+  /// have one chunk per piece; those chunks are concatenated.
+  template <typename T>
+  static Result<std::shared_ptr<typename arrow::CTypeTraits<T>::ArrayType>>
+  UnchunkProperty(const std::shared_ptr<arrow::ChunkedArray>& chunked_array) {
+    std::shared_ptr<arrow::Array> array;
+    if (chunked_array->num_chunks() == 1) {
+      array = chunked_array->chunk(0);
+    } else if (chunked_array->num_chunks() == 0) {
+      auto empty_result = arrow::MakeArrayOfNull(chunked_array->type(), 0);
+      if (!empty_result.ok()) {
+        GALOIS_LOG_DEBUG("arrow error: {}", empty_result.status());
+        return ErrorCode::ArrowError;
+      }
+      array = std::move(empty_result.ValueOrDie());
+    } else {
+      auto concat_result = arrow::Concatenate(chunked_array->chunks());
+      if (!concat_result.ok()) {
+        GALOIS_LOG_DEBUG("arrow error: {}", concat_result.status());
+        return ErrorCode::ArrowError;
+      }
+      array = std::move(concat_result.ValueOrDie());
+    }
+
+    auto typed =
+        std::dynamic_pointer_cast<typename arrow::CTypeTraits<T>::ArrayType>(
+            array);
+    if (!typed) {
+      return ErrorCode::TypeError;
+    }
+    return typed;
+  }
+
+  /// A commit started by CommitAsync that the graph has not waited for yet
+  struct PendingCommit {
+    std::shared_future<Result<void>> result;
+    std::shared_ptr<tsuba::RDG> snapshot;
+    /// The file committed to, if the commit had to open it
+    std::unique_ptr<tsuba::RDGFile> file;
+    std::string command_line;
+    /// Whether the topology had to be rewritten before the commit
+    bool rewrite_topology;
+    /// Whether the commit writes the topology
+    bool write_topology;
+    /// topology_version_ when the commit started
+    uint64_t topology_version;
+  };
+
+  /// Replace the topology and forget what was derived from it. Callers must
+  /// hold rdg_mutex_.
+  Result<void> DoSetTopology(const GraphTopology& topology);
+
+  /// The part of DoSetTopology that cannot fail, for callers that have
+  /// already unbound the topology file storage. Callers must hold rdg_mutex_.
+  void ResetTopology(const GraphTopology& topology);
+
+  /// Store the graph at handle. Callers must hold rdg_mutex_, since storing
+  /// to a new location loads and unbinds properties.
   Result<void> DoWrite(
       tsuba::RDGHandle handle, const std::string& command_line);
   Result<void> WriteGraph(
       const std::string& uri, const std::string& command_line);
 
-  tsuba::RDG rdg_;
+  /// Replace the version returned by Snapshot with the current state of the
+  /// graph. Does nothing until Snapshot is first called, so graphs that are
+  /// never snapshotted do not pay for it. Callers must hold rdg_mutex_.
+  void PublishSnapshot() const;
+
+  // mutable because properties of lazily made graphs are loaded by const
+  // accessors; see LoadNodePropertyIfUnloaded
+  mutable tsuba::RDG rdg_;
+  // Serializes changes to rdg_, topology_ and transpose_: lazy loads and the
+  // writers that publish snapshots
+  mutable std::mutex rdg_mutex_;
   std::unique_ptr<tsuba::RDGFile> file_;
 
+  // The latest published version; read with std::atomic_load and replaced
+  // with std::atomic_store while holding rdg_mutex_
+  mutable std::shared_ptr<const GraphSnapshot> snapshot_;
+  mutable uint64_t snapshot_version_{0};
+  mutable bool publish_snapshots_{false};
+
   // The topology is either backed by rdg_ or shared with the
   // caller of SetTopology.
   GraphTopology topology_;
+  std::shared_ptr<CompressedTopology> compressed_topology_;
+  // Built or loaded on request; guarded by rdg_mutex_
+  mutable std::shared_ptr<const TransposeTopology> transpose_;
+  mutable std::shared_ptr<const EdgeTypeTopology> edge_type_topology_;
+
+  TopologyEncoding topology_encoding_{TopologyEncoding::Plain};
+  arrow::Compression::type topology_codec_{arrow::Compression::UNCOMPRESSED};
+  int topology_compression_level_{arrow::util::kUseDefaultCompressionLevel};
+  // Set when the topology must be rewritten even if it is already stored,
+  // e.g., because its compression or encoding changed
+  bool rewrite_topology_{false};
+  // Incremented whenever topology_ is replaced; guarded by rdg_mutex_
+  uint64_t topology_version_{0};
+
+  std::optional<PendingCommit> pending_commit_;
 
 public:
   /// PropertyView provides a uniform interface when you don't need to
@@ -104,6 +327,8 @@ public:
   };
 
   PropertyFileGraph();
+  /// Waits for a commit started by CommitAsync
+  ~PropertyFileGraph();
 
   /// Make a property graph from a constructed RDG. Take ownership of the RDG
   /// and its underlying resources.
@@ -127,6 +352,40 @@ public:
       const std::vector<std::string>& node_properties,
       const std::vector<std::string>& edge_properties);
 
+  /// Make a property graph from an RDG name, but only load the topology and
+  /// the given node and edge properties. Other properties are loaded when
+  /// they are first requested by name, e.g., with NodeProperty(const
+  /// std::string&) or PropertyGraph::Make.
+  ///
+  /// Loading a property appends it to the node (edge) table, so positional
+  /// accessors such as NodeProperty(int) only refer to loaded properties.
+  /// Loading is serialized internally, but it is not safe to hold references
+  /// returned by node_table() or edge_table() while another thread may load a
+  /// property.
+  static Result<std::unique_ptr<PropertyFileGraph>> MakeLazy(
+      const std::string& rdg_name,
+      const std::vector<std::string>& prefetch_node_properties = {},
+      const std::vector<std::string>& prefetch_edge_properties = {});
+
+  /// Load the named properties if they are not loaded yet
+  Result<void> EnsureNodePropertiesLoaded(
+      const std::vector<std::string>& names) const;
+  Result<void> EnsureEdgePropertiesLoaded(
+      const std::vector<std::string>& names) const;
+
+  /// Load every property that is stored but not loaded yet
+  Result<void> EnsureAllPropertiesLoaded() const;
+
+  /// Names of properties that are stored but have not been loaded yet
+  std::vector<std::string> UnloadedNodePropertyNames() const {
+    std::lock_guard<std::mutex> lock(rdg_mutex_);
+    return rdg_.UnloadedNodePropertyNames();
+  }
+  std::vector<std::string> UnloadedEdgePropertyNames() const {
+    std::lock_guard<std::mutex> lock(rdg_mutex_);
+    return rdg_.UnloadedEdgePropertyNames();
+  }
+
   const tsuba::PartitionMetadata& partition_metadata() const {
     return rdg_.part_metadata();
   }
@@ -134,6 +393,29 @@ public:
     rdg_.set_part_metadata(meta);
   }
 
+  /// Options used for properties written by Write and Commit
+  const tsuba::PropWriteOptions& prop_write_options() const {
+    return rdg_.prop_write_options();
+  }
+  Result<void> SetPropWriteOptions(const tsuba::PropWriteOptions& options) {
+    return rdg_.SetPropWriteOptions(options);
+  }
+
+  /// SetTopologyCompression chooses the codec used to compress the topology
+  /// the next time this graph is written. An uncompressed topology is mapped
+  /// on load, while a compressed one must be decompressed into memory, so
+  /// compression trades load time CPU for less I/O. Returns
+  /// ErrorCode::NotImplemented for codecs that Arrow was built without, which
+  /// in the supported build are all but snappy, gzip and brotli.
+  Result<void> SetTopologyCompression(
+      arrow::Compression::type codec,
+      int level = arrow::util::kUseDefaultCompressionLevel);
+
+  /// SetTopologyEncoding chooses how edge destinations are encoded the next
+  /// time this graph is written. Unlike SetTopologyCompression, a gap encoded
+  /// topology stays readable in its stored form; see compressed_topology().
+  void SetTopologyEncoding(TopologyEncoding encoding);
+
   const std::shared_ptr<arrow::ChunkedArray>& local_to_global_vector() {
     return rdg_.local_to_global_vector();
   }
@@ -166,6 +448,25 @@ public:
   /// Like \ref Write(const std::string&, const std::string&) but update
   /// the original read location of the graph
   Result<void> Commit(const std::string& command_line);
+
+  /// CommitAsync is like Commit, but only takes a snapshot of the graph on the
+  /// calling thread and writes the snapshot on a background thread. The
+  /// returned future is ready when the snapshot is committed.
+  ///
+  /// While the commit is in flight, properties may be added to or removed
+  /// from the graph, but the values of existing properties must not be
+  /// modified in place, e.g., through a PODPropertyView, because the snapshot
+  /// shares them.
+  ///
+  /// At most one commit is in flight: Write, Commit and CommitAsync first
+  /// wait for the previous one. Properties written by a commit are not
+  /// written again by the next one only once the graph has waited for it,
+  /// which WaitForCommit does explicitly.
+  std::shared_future<Result<void>> CommitAsync(const std::string& command_line);
+
+  /// Wait for the commit started by CommitAsync, if any, and return its
+  /// result
+  Result<void> WaitForCommit();
   /// Tell the RDG where it's data is coming from
   Result<void> InformPath(const std::string& input_path) {
     if (!rdg_.rdg_dir().empty()) {
@@ -204,19 +505,30 @@ public:
   }
 
   /**
-   * Get a node property by name.
+   * Get a node property by name. If the graph was made lazily, the property
+   * is loaded on first use.
    *
    * @param name The name of the property to get.
    * @return The property data or NULL if the property is not found.
    */
   std::shared_ptr<arrow::ChunkedArray> NodeProperty(
       const std::string& name) const {
-    return rdg_.node_table()->GetColumnByName(name);
+    auto res = FindOrLoadNodeProperty(name);
+    if (!res) {
+      GALOIS_LOG_ERROR("loading node property {}: {}", name, res.error());
+      return nullptr;
+    }
+    return res.value();
   }
 
   std::shared_ptr<arrow::ChunkedArray> EdgeProperty(
       const std::string& name) const {
-    return rdg_.edge_table()->GetColumnByName(name);
+    auto res = FindOrLoadEdgeProperty(name);
+    if (!res) {
+      GALOIS_LOG_ERROR("loading edge property {}: {}", name, res.error());
+      return nullptr;
+    }
+    return res.value();
   }
 
   /**
@@ -224,6 +536,11 @@ public:
    * @tparam T The type of the property.
    * @param name The name of the property.
    * @return The property array or an error if the property does not exist or has a different type.
+   *
+   * A property stored in more than one chunk, e.g., any loaded property with
+   * more than one row group, is copied into a new array on every call, and
+   * writes to that array do not reach the graph. To use the chunks in place,
+   * apply ConstructPropertyView to NodeProperty(name) instead.
    */
   template <typename T>
   Result<std::shared_ptr<typename arrow::CTypeTraits<T>::ArrayType>>
@@ -232,14 +549,7 @@ public:
     if (!chunked_array) {
       return ErrorCode::PropertyNotFound;
     }
-
-    auto array =
-        std::dynamic_pointer_cast<typename arrow::CTypeTraits<T>::ArrayType>(
-            chunked_array->chunk(0));
-    if (!array) {
-      return ErrorCode::TypeError;
-    }
-    return array;
+    return UnchunkProperty<T>(chunked_array);
   }
 
   /**
@@ -247,6 +557,11 @@ public:
     * @tparam T The type of the property.
     * @param name The name of the property.
     * @return The property array or an error if the property does not exist or has a different type.
+    *
+    * Like NodePropertyTyped, this copies a property stored in more than one
+    * chunk on every call.
+    *
+    * @see NodePropertyTyped
     */
   template <typename T>
   Result<std::shared_ptr<typename arrow::CTypeTraits<T>::ArrayType>>
@@ -255,14 +570,7 @@ public:
     if (!chunked_array) {
       return ErrorCode::PropertyNotFound;
     }
-
-    auto array =
-        std::dynamic_pointer_cast<typename arrow::CTypeTraits<T>::ArrayType>(
-            chunked_array->chunk(0));
-    if (!array) {
-      return ErrorCode::TypeError;
-    }
-    return array;
+    return UnchunkProperty<T>(chunked_array);
   }
 
   void MarkAllPropertiesPersistent() {
@@ -284,8 +592,71 @@ public:
     return rdg_.MarkEdgePropertiesPersistent(persist_edge_props);
   }
 
+  /// SetNodePropertyStorageFormat chooses how a node property is laid out
+  /// when this graph is written. Properties that are mostly read in place
+  /// (e.g., fixed-width analytics outputs) load fastest as
+  /// tsuba::PropStorageFormat::ArrowIPC.
+  Result<void> SetNodePropertyStorageFormat(
+      const std::string& name, tsuba::PropStorageFormat format) {
+    return rdg_.SetNodePropertyStorageFormat(name, format);
+  }
+
+  Result<void> SetEdgePropertyStorageFormat(
+      const std::string& name, tsuba::PropStorageFormat format) {
+    return rdg_.SetEdgePropertyStorageFormat(name, format);
+  }
+
+  /// SetNodePropertyWriteOptions overrides prop_write_options() for one node
+  /// property, e.g., to use a heavier codec for a large, rarely read column
+  Result<void> SetNodePropertyWriteOptions(
+      const std::string& name, const tsuba::PropWriteOptions& options) {
+    return rdg_.SetNodePropertyWriteOptions(name, options);
+  }
+
+  Result<void> SetEdgePropertyWriteOptions(
+      const std::string& name, const tsuba::PropWriteOptions& options) {
+    return rdg_.SetEdgePropertyWriteOptions(name, options);
+  }
+
+  /// The uncompressed topology. A gap encoded topology is decompressed when
+  /// the graph is loaded.
   const GraphTopology& topology() const { return topology_; }
 
+  /// The topology as loaded from storage if it is gap encoded, and null
+  /// otherwise. Iterating over it with a CompressedTopology::Cursor reads
+  /// fewer bytes than topology(). It does not reflect in-place changes to
+  /// topology(), e.g., by SortAllEdgesByDest.
+  std::shared_ptr<const CompressedTopology> compressed_topology() const {
+    return compressed_topology_;
+  }
+
+  /// BuildTransposeTopology computes the in-edges of topology() in parallel.
+  /// The transpose is stored with the topology the next time this graph is
+  /// written, so later loads can use it without building it again.
+  Result<void> BuildTransposeTopology();
+
+  /// The in-edges of this graph. A stored transpose is loaded on first use.
+  /// Returns PropertyNotFound if the transpose was neither built nor stored.
+  Result<std::shared_ptr<const TransposeTopology>> GetTransposeTopology() const;
+
+  /// BuildEdgeTypeTopology groups the out-edges of each node by the given
+  /// types in parallel; see EdgeTypeTopology. Each type names a boolean edge
+  /// property, which is loaded if needed; a null value means the edge does
+  /// not have the type. Like the transpose, the result is stored with the
+  /// topology the next time this graph is written. It reflects the type
+  /// properties as they are when it is built.
+  Result<void> BuildEdgeTypeTopology(const std::vector<std::string>& types);
+
+  /// The out-edges of this graph grouped by type. A stored EdgeTypeTopology
+  /// is loaded on first use. Returns PropertyNotFound if it was neither built
+  /// nor stored.
+  Result<std::shared_ptr<const EdgeTypeTopology>> GetEdgeTypeTopology() const;
+
+  /// Forget topologies derived from topology(), e.g., the transpose, both in
+  /// memory and in storage. SetTopology calls this; functions that change
+  /// topology() in place must too.
+  void ClearDerivedTopologies();
+
   std::vector<std::shared_ptr<arrow::ChunkedArray>> NodeProperties() const {
     return rdg_.node_table()->columns();
   }
@@ -300,27 +671,30 @@ public:
     return rdg_.edge_table()->ColumnNames();
   }
 
+  /// Add the columns of table as properties. Fails if a property with the
+  /// same name exists, including one that is stored but not loaded yet.
   Result<void> AddNodeProperties(const std::shared_ptr<arrow::Table>& table);
   Result<void> AddEdgeProperties(const std::shared_ptr<arrow::Table>& table);
 
-  Result<void> RemoveNodeProperty(int i) { return rdg_.RemoveNodeProperty(i); }
-  Result<void> RemoveNodeProperty(const std::string& prop_name) {
-    auto col_names = NodePropertyNames();
-    auto pos = std::find(col_names.cbegin(), col_names.cend(), prop_name);
-    if (pos != col_names.cend()) {
-      return rdg_.RemoveNodeProperty(std::distance(col_names.cbegin(), pos));
-    }
-    return galois::ErrorCode::PropertyNotFound;
-  }
-  Result<void> RemoveEdgeProperty(int i) { return rdg_.RemoveEdgeProperty(i); }
-  Result<void> RemoveEdgeProperty(const std::string& prop_name) {
-    auto col_names = EdgePropertyNames();
-    auto pos = std::find(col_names.cbegin(), col_names.cend(), prop_name);
-    if (pos != col_names.cend()) {
-      return rdg_.RemoveNodeProperty(std::distance(col_names.cbegin(), pos));
-    }
-    return galois::ErrorCode::PropertyNotFound;
-  }
+  /// Remove a property. Removing by name also removes a property that is
+  /// stored but not loaded yet.
+  Result<void> RemoveNodeProperty(int i);
+  Result<void> RemoveNodeProperty(const std::string& prop_name);
+  Result<void> RemoveEdgeProperty(int i);
+  Result<void> RemoveEdgeProperty(const std::string& prop_name);
+
+  /// Snapshot returns the latest published version of the topology and the
+  /// node and edge tables. Readers on other threads can use a snapshot while
+  /// this graph is changed: adding or removing properties, loading them
+  /// lazily and SetTopology publish a new version rather than change the
+  /// ones already returned. Taking a snapshot does not lock; a version is
+  /// freed when the graph and the last reader holding it let it go.
+  ///
+  /// The first call decompresses a gap encoded topology. Properties of a
+  /// lazily made graph that are not loaded yet are not in the snapshot.
+  /// Functions that change topology() or property values in place, such as
+  /// SortAllEdgesByDest, also change the versions that share them.
+  std::shared_ptr<const GraphSnapshot> Snapshot() const;
 
   PropertyView node_property_view() {
     return PropertyView{
@@ -346,6 +720,18 @@ public:
 
   Result<void> SetTopology(const GraphTopology& topology);
 
+  /// ReplaceTopologyAndProperties replaces the topology and the values of
+  /// every node and edge property at once, e.g., to relabel nodes; see
+  /// ReorderNodes. The tables must have the schemas of node_table() and
+  /// edge_table() and a row for each node and edge of topology. A lazily made
+  /// graph must have loaded all its properties. Replaced properties are
+  /// written again by the next Write or Commit, and snapshots see either the
+  /// graph before or after the change.
+  Result<void> ReplaceTopologyAndProperties(
+      const GraphTopology& topology,
+      const std::shared_ptr<arrow::Table>& node_table,
+      const std::shared_ptr<arrow::Table>& edge_table);
+
   const std::shared_ptr<arrow::Table>& node_table() const {
     return rdg_.node_table();
   }
@@ -354,6 +740,11 @@ public:
   }
 };
 
+/// Allocate an uninitialized buffer of size bytes for a topology array, e.g.,
+/// the out indices or destinations of a GraphTopology
+GALOIS_EXPORT Result<std::shared_ptr<arrow::Buffer>> AllocateTopologyBuffer(
+    uint64_t size);
+
 /// SortAllEdgesByDest sorts edges for each node by destination
 /// ids (ascending order).
 ///
@@ -378,7 +769,8 @@ GALOIS_EXPORT uint64_t FindEdgeSortedByDest(
 ///
 /// This function modifies the PropertyFileGraph topology by in-place
 /// relabeling and sorting the node ids by their degree in the
-/// descending order.
+/// descending order. Unlike ReorderNodes, it does not permute node or edge
+/// properties.
 GALOIS_EXPORT Result<void> SortNodesByDegree(PropertyFileGraph* pfg);
 
 }  // namespace galois::graphs
@@ -1,6 +1,7 @@
 #ifndef GALOIS_LIBGALOIS_GALOIS_GRAPHS_PROPERTYGRAPH_H_
 #define GALOIS_LIBGALOIS_GALOIS_GRAPHS_PROPERTYGRAPH_H_
 
+#include <memory>
 #include <tuple>
 
 #include <arrow/type_fwd.h>
@@ -11,6 +12,7 @@
 #include "galois/Result.h"
 #include "galois/Traits.h"
 #include "galois/graphs/Details.h"
+#include "galois/graphs/EdgeIndex.h"
 #include "galois/graphs/PropertyFileGraph.h"
 #include "galois/graphs/PropertyViews.h"
 
@@ -39,6 +41,9 @@ class PropertyGraph {
   NodeView node_view_;
   EdgeView edge_view_;
 
+  /// Shared by copies of this graph; null until BuildEdgeIndex
+  std::shared_ptr<const EdgeIndex> edge_index_;
+
   PropertyGraph(PropertyFileGraph* pfg, NodeView node_view, EdgeView edge_view)
       : pfg_(pfg),
         node_view_(std::move(node_view)),
@@ -173,6 +178,51 @@ public:
    */
   const PropertyFileGraph& GetPropertyFileGraph() const { return *pfg_; }
 
+  /**
+   * Indexes the edges of this graph so that FindEdge takes constant expected
+   * time for nodes with at least hub_degree edges and logarithmic time
+   * otherwise, whether or not edges are sorted. The index is not updated by
+   * later changes to the topology, so build it again after them.
+   *
+   * @param hub_degree degree from which a node gets a hash table
+   */
+  Result<void> BuildEdgeIndex(
+      uint64_t hub_degree = EdgeIndex::kDefaultHubDegree) {
+    auto index_result = EdgeIndex::Make(pfg_->topology(), hub_degree);
+    if (!index_result) {
+      return index_result.error();
+    }
+    edge_index_ =
+        std::make_shared<const EdgeIndex>(std::move(index_result.value()));
+    return ResultSuccess();
+  }
+
+  /**
+   * Finds the first edge from some node to another. Uses the index made by
+   * BuildEdgeIndex if there is one and otherwise scans the edges of src.
+   *
+   * @param src node to find the edge from
+   * @param dest node to find the edge to
+   * @returns iterator to the edge if present else edge_end(src)
+   */
+  edge_iterator FindEdge(Node src, Node dest) const {
+    if (edge_index_) {
+      return edge_iterator(edge_index_->FindEdge(src, dest));
+    }
+    const GraphTopology& topology = pfg_->topology();
+    auto [begin_edge, end_edge] = topology.edge_range(src);
+    for (uint64_t e = begin_edge; e < end_edge; ++e) {
+      if (topology.out_dests->Value(e) == dest) {
+        return edge_iterator(e);
+      }
+    }
+    return edge_iterator(end_edge);
+  }
+
+  bool HasEdge(Node src, Node dest) const {
+    return FindEdge(src, dest) != edge_end(src);
+  }
+
   // Graph constructors
   static Result<PropertyGraph<NodeProps, EdgeProps>> Make(
       PropertyFileGraph* pfg, const std::vector<std::string>& node_properties,
@@ -204,6 +254,14 @@ Result<PropertyGraph<NodeProps, EdgeProps>>
 PropertyGraph<NodeProps, EdgeProps>::Make(
     PropertyFileGraph* pfg, const std::vector<std::string>& node_properties,
     const std::vector<std::string>& edge_properties) {
+  // fault in properties of lazily made graphs
+  if (auto res = pfg->EnsureNodePropertiesLoaded(node_properties); !res) {
+    return res.error();
+  }
+  if (auto res = pfg->EnsureEdgePropertiesLoaded(edge_properties); !res) {
+    return res.error();
+  }
+
   auto node_view_result =
       internal::MakeNodePropertyViews<NodeProps>(pfg, node_properties);
   if (!node_view_result) {
@@ -224,6 +282,9 @@ PropertyGraph<NodeProps, EdgeProps>::Make(
 template <typename NodeProps, typename EdgeProps>
 Result<PropertyGraph<NodeProps, EdgeProps>>
 PropertyGraph<NodeProps, EdgeProps>::Make(PropertyFileGraph* pfg) {
+  if (auto res = pfg->EnsureAllPropertiesLoaded(); !res) {
+    return res.error();
+  }
   return PropertyGraph<NodeProps, EdgeProps>::Make(
       pfg, pfg->node_schema()->field_names(),
       pfg->edge_schema()->field_names());
@@ -6,9 +6,10 @@
 
 namespace galois::graphs::internal {
 
-/// ExtractArrays returns the array for each column of a table. It returns an
-/// error if there is more than one array for any column.
-Result<std::vector<arrow::Array*>> GALOIS_EXPORT ExtractArrays(
+/// ExtractArrays returns the chunked array for each column of a table. The
+/// chunks of a column are used as is; views over a column with more than one
+/// chunk find the chunk of each element.
+Result<std::vector<arrow::ChunkedArray*>> GALOIS_EXPORT ExtractArrays(
     const arrow::Table* table, const std::vector<std::string>& properties);
 
 template <typename PropTuple>
@@ -38,8 +39,7 @@ MakePropertyViews(
 /// view.
 ///
 /// It returns an error if there are fewer properties than elements of the
-/// view or if the underlying arrow::ChunkedArray has more than one
-/// arrow::Array.
+/// view or if some property does not have the type of its view.
 template <typename PropTuple>
 static Result<PropertyViewTuple<PropTuple>>
 MakeNodePropertyViews(
@@ -50,8 +50,7 @@ MakeNodePropertyViews(
 /// MakeNodePropertyViews asserts a typed view on top of runtime properties.
 ///
 /// It returns an error if there are fewer properties than elements of the
-/// view or if the underlying arrow::ChunkedArray has more than one
-/// arrow::Array.
+/// view or if some property does not have the type of its view.
 template <typename PropTuple>
 static Result<PropertyViewTuple<PropTuple>>
 MakeNodePropertyViews(const PropertyFileGraph* pfg) {
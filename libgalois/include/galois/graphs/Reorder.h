@@ -0,0 +1,69 @@
+#ifndef GALOIS_LIBGALOIS_GALOIS_GRAPHS_REORDER_H_
+#define GALOIS_LIBGALOIS_GALOIS_GRAPHS_REORDER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "galois/Result.h"
+#include "galois/config.h"
+#include "galois/graphs/PropertyFileGraph.h"
+
+namespace galois::graphs {
+
+/// ReorderPolicy chooses how ComputeNodeOrder numbers nodes. Orders that
+/// place nodes that are accessed together next to each other improve the
+/// locality of kernels that read the properties of neighbors.
+///
+/// Traversal based orders only follow out-edges; on a directed graph, a node
+/// that is not reached from an earlier root starts a new traversal.
+enum class ReorderPolicy {
+  /// Decreasing out-degree, as SortNodesByDegree
+  Degree,
+  /// Hub sorting: nodes with more than the average degree (hubs) first, by
+  /// decreasing degree, then the rest in their original order
+  HubSort,
+  /// Hub clustering: hubs first, then the rest, both in their original order
+  HubCluster,
+  /// Breadth first order, starting from the node of highest degree
+  BFS,
+  /// Reverse Cuthill-McKee: breadth first from a node of lowest degree,
+  /// visiting neighbors by increasing degree, then reversed. Reduces the
+  /// bandwidth of the adjacency matrix.
+  RCM,
+  /// A greedy approximation of Gorder: the next node is the one with the most
+  /// edges and common neighbors (paths of length two) from the last
+  /// kGorderWindow placed nodes. Paths through nodes of very high degree are
+  /// not counted, which bounds the work per node.
+  GorderLite,
+};
+
+/// Number of recently placed nodes ReorderPolicy::GorderLite scores against
+constexpr uint32_t kGorderWindow = 5;
+
+/// ComputeNodeOrder returns the new id of each node of topology under policy.
+/// Degree based policies sort nodes in parallel; traversal based ones visit
+/// nodes sequentially.
+GALOIS_EXPORT Result<std::vector<uint32_t>> ComputeNodeOrder(
+    const GraphTopology& topology, ReorderPolicy policy);
+
+/// PermuteNodes relabels node n of pfg as old_to_new[n] in parallel. The
+/// out-edges of each node keep their order, so edges may need to be sorted
+/// again, e.g., with SortAllEdgesByDest. Every node and edge property is
+/// permuted to match. Properties of a lazily made graph are loaded first.
+///
+/// Local to global and mirror node arrays of a partitioned graph are not
+/// relabeled.
+///
+/// \returns InvalidArgument if old_to_new is not a permutation of the nodes
+GALOIS_EXPORT Result<void> PermuteNodes(
+    PropertyFileGraph* pfg, const std::vector<uint32_t>& old_to_new);
+
+/// ReorderNodes relabels the nodes of pfg according to policy and returns
+/// the mapping from old to new node ids; see ComputeNodeOrder and
+/// PermuteNodes.
+GALOIS_EXPORT Result<std::vector<uint32_t>> ReorderNodes(
+    PropertyFileGraph* pfg, ReorderPolicy policy);
+
+}  // namespace galois::graphs
+
+#endif
@@ -0,0 +1,334 @@
+#include "galois/graphs/CompressedTopology.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+#include "galois/Logging.h"
+#include "galois/Loops.h"
+#include "galois/graphs/PropertyFileGraph.h"
+#include "tsuba/Errors.h"
+
+namespace {
+
+using galois::graphs::CompressedTopology;
+
+static_assert(CompressedTopology::kBlockSize % 4 == 0);
+
+// Differences are taken modulo 2^32, so any sequence of destinations round
+// trips, but only small (positive or negative) differences compress well.
+uint32_t
+ZigZag(uint32_t delta) {
+  auto d = static_cast<int32_t>(delta);
+  return (static_cast<uint32_t>(d) << 1) ^ static_cast<uint32_t>(d >> 31);
+}
+
+uint32_t
+UnZigZag(uint32_t v) {
+  return (v >> 1) ^ (0U - (v & 1));
+}
+
+uint32_t
+ByteLength(uint32_t v) {
+  return 1 + (v > 0xFF) + (v > 0xFFFF) + (v > 0xFFFFFF);
+}
+
+uint64_t
+NumControlBytes(uint64_t n) {
+  return (n + 3) / 4;
+}
+
+uint64_t
+EncodedSize(const uint32_t* dests, uint64_t n) {
+  uint64_t size = NumControlBytes(n);
+  uint32_t prev = 0;
+  for (uint64_t i = 0; i < n; ++i) {
+    size += ByteLength(ZigZag(dests[i] - prev));
+    prev = dests[i];
+  }
+  return size;
+}
+
+void
+EncodeBlock(const uint32_t* dests, uint64_t n, uint8_t* out) {
+  uint8_t* control = out;
+  uint8_t* data = out + NumControlBytes(n);
+  std::memset(control, 0, NumControlBytes(n));
+
+  uint32_t prev = 0;
+  for (uint64_t i = 0; i < n; ++i) {
+    uint32_t v = ZigZag(dests[i] - prev);
+    prev = dests[i];
+    uint32_t len = ByteLength(v);
+    control[i / 4] |= (len - 1) << (2 * (i % 4));
+    // little endian
+    std::memcpy(data, &v, len);
+    data += len;
+  }
+}
+
+/// Number of data bytes used by the n values of a block according to its
+/// control bytes
+uint64_t
+DataLength(const uint8_t* control, uint64_t n) {
+  uint64_t length = 0;
+  for (uint64_t i = 0; i < n; ++i) {
+    length += ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+  }
+  return length;
+}
+
+/// Decode values [begin, n) of a block whose data for value begin starts at
+/// data and whose preceding destination is prev
+void
+DecodeScalar(
+    const uint8_t* control, const uint8_t* data, uint64_t begin, uint64_t n,
+    uint32_t prev, uint32_t* out) {
+  for (uint64_t i = begin; i < n; ++i) {
+    uint32_t len = ((control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+    uint32_t v = 0;
+    std::memcpy(&v, data, len);
+    data += len;
+    prev += UnZigZag(v);
+    out[i] = prev;
+  }
+}
+
+#if defined(__SSSE3__)
+
+struct ShuffleTable {
+  // Shuffle that moves the bytes of four values into four uint32_t lanes
+  alignas(16) uint8_t shuffle[256][16];
+  // Total number of data bytes used by the four values
+  uint8_t length[256];
+};
+
+constexpr ShuffleTable
+MakeShuffleTable() {
+  ShuffleTable table{};
+  for (int control = 0; control < 256; ++control) {
+    int pos = 0;
+    for (int lane = 0; lane < 4; ++lane) {
+      int len = ((control >> (2 * lane)) & 3) + 1;
+      for (int byte = 0; byte < 4; ++byte) {
+        // 0xFF zeroes the output byte
+        table.shuffle[control][lane * 4 + byte] =
+            byte < len ? static_cast<uint8_t>(pos + byte) : 0xFF;
+      }
+      pos += len;
+    }
+    table.length[control] = static_cast<uint8_t>(pos);
+  }
+  return table;
+}
+
+constexpr ShuffleTable kShuffleTable = MakeShuffleTable();
+
+void
+DecodeBlockImpl(const uint8_t* in, uint64_t n, uint32_t* out) {
+  const uint8_t* control = in;
+  const uint8_t* data = in + NumControlBytes(n);
+
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi32(1);
+  __m128i prev = zero;
+
+  uint64_t num_groups = n / 4;
+  for (uint64_t g = 0; g < num_groups; ++g) {
+    uint8_t c = control[g];
+    // Reads up to 16 bytes; kPadding makes this safe for the last block
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    v = _mm_shuffle_epi8(
+        v, _mm_load_si128(
+               reinterpret_cast<const __m128i*>(kShuffleTable.shuffle[c])));
+    data += kShuffleTable.length[c];
+
+    // zigzag decode
+    v = _mm_xor_si128(
+        _mm_srli_epi32(v, 1), _mm_sub_epi32(zero, _mm_and_si128(v, one)));
+
+    // prefix sum of the four lanes plus the last destination of the previous
+    // group
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+    v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+    v = _mm_add_epi32(v, prev);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * g), v);
+    prev = _mm_shuffle_epi32(v, 0xFF);
+  }
+
+  uint32_t last = num_groups > 0 ? out[4 * num_groups - 1] : 0;
+  DecodeScalar(control, data, 4 * num_groups, n, last, out);
+}
+
+#else
+
+void
+DecodeBlockImpl(const uint8_t* in, uint64_t n, uint32_t* out) {
+  DecodeScalar(in, in + NumControlBytes(n), 0, n, 0, out);
+}
+
+#endif
+
+}  // namespace
+
+galois::Result<galois::graphs::CompressedTopology>
+galois::graphs::CompressedTopology::Encode(const GraphTopology& topology) {
+  uint64_t num_edges = topology.num_edges();
+  uint64_t num_blocks = (num_edges + kBlockSize - 1) / kBlockSize;
+  const uint32_t* dests =
+      num_edges > 0 ? topology.out_dests->raw_values() : nullptr;
+
+  auto offsets_result =
+      arrow::AllocateBuffer((num_blocks + 1) * sizeof(uint64_t));
+  if (!offsets_result.ok()) {
+    return tsuba::ArrowToTsuba(offsets_result.status().code());
+  }
+  std::shared_ptr<arrow::Buffer> block_offsets =
+      std::move(offsets_result.ValueOrDie());
+  auto* offsets = reinterpret_cast<uint64_t*>(block_offsets->mutable_data());
+
+  auto block_length = [&](uint64_t block) {
+    return std::min(kBlockSize, num_edges - block * kBlockSize);
+  };
+
+  offsets[0] = 0;
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_blocks), [&](uint64_t block) {
+        offsets[block + 1] =
+            EncodedSize(dests + block * kBlockSize, block_length(block));
+      });
+  for (uint64_t block = 0; block < num_blocks; ++block) {
+    offsets[block + 1] += offsets[block];
+  }
+
+  uint64_t data_size = offsets[num_blocks];
+  auto data_result = arrow::AllocateBuffer(data_size + kPadding);
+  if (!data_result.ok()) {
+    return tsuba::ArrowToTsuba(data_result.status().code());
+  }
+  std::shared_ptr<arrow::Buffer> data = std::move(data_result.ValueOrDie());
+  std::memset(data->mutable_data() + data_size, 0, kPadding);
+
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_blocks), [&](uint64_t block) {
+        EncodeBlock(
+            dests + block * kBlockSize, block_length(block),
+            data->mutable_data() + offsets[block]);
+      });
+
+  return Make(
+      topology.out_indices, num_edges, std::move(block_offsets),
+      std::move(data));
+}
+
+galois::Result<galois::graphs::CompressedTopology>
+galois::graphs::CompressedTopology::Make(
+    std::shared_ptr<arrow::UInt64Array> out_indices, uint64_t num_edges,
+    std::shared_ptr<arrow::Buffer> block_offsets,
+    std::shared_ptr<arrow::Buffer> data) {
+  CompressedTopology topo;
+  topo.out_indices_ = std::move(out_indices);
+  topo.num_edges_ = num_edges;
+  topo.block_offsets_ = std::move(block_offsets);
+  topo.data_ = std::move(data);
+
+  uint64_t num_blocks = topo.num_blocks();
+  if (!topo.block_offsets_ || !topo.data_ ||
+      static_cast<uint64_t>(topo.block_offsets_->size()) <
+          (num_blocks + 1) * sizeof(uint64_t)) {
+    GALOIS_LOG_DEBUG("block offsets missing or too small");
+    return ErrorCode::InvalidArgument;
+  }
+
+  const auto* offsets =
+      reinterpret_cast<const uint64_t*>(topo.block_offsets_->data());
+  if (offsets[0] != 0 ||
+      offsets[num_blocks] + kPadding >
+          static_cast<uint64_t>(topo.data_->size())) {
+    GALOIS_LOG_DEBUG("block offsets do not match data");
+    return ErrorCode::InvalidArgument;
+  }
+  for (uint64_t block = 0; block < num_blocks; ++block) {
+    if (offsets[block + 1] < offsets[block]) {
+      GALOIS_LOG_DEBUG("block {} has a negative size", block);
+      return ErrorCode::InvalidArgument;
+    }
+  }
+
+  uint64_t num_nodes = topo.num_nodes();
+  uint64_t prev_index = 0;
+  for (uint64_t node = 0; node < num_nodes; ++node) {
+    uint64_t index = topo.out_indices_->Value(node);
+    if (index < prev_index || index > num_edges) {
+      GALOIS_LOG_DEBUG("out indices of node {} are out of order", node);
+      return ErrorCode::InvalidArgument;
+    }
+    prev_index = index;
+  }
+  if (num_nodes > 0 && prev_index != num_edges) {
+    GALOIS_LOG_DEBUG("out indices do not match number of edges");
+    return ErrorCode::InvalidArgument;
+  }
+
+  // Decoding trusts the control bytes to stay within the block and yield
+  // valid destinations, so check both before handing out the topology
+  std::atomic<bool> valid{true};
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_blocks), [&](uint64_t block) {
+        uint64_t n = std::min(kBlockSize, num_edges - block * kBlockSize);
+        const uint8_t* control = topo.data_->data() + offsets[block];
+        uint64_t size = offsets[block + 1] - offsets[block];
+        if (size < NumControlBytes(n) ||
+            DataLength(control, n) != size - NumControlBytes(n)) {
+          GALOIS_LOG_DEBUG("block {} does not match its size {}", block, size);
+          valid = false;
+          return;
+        }
+        alignas(16) uint32_t dests[kBlockSize];
+        topo.DecodeBlock(block, dests);
+        if (std::any_of(dests, dests + n, [&](uint32_t dest) {
+              return dest >= num_nodes;
+            })) {
+          GALOIS_LOG_DEBUG("block {} has an invalid destination", block);
+          valid = false;
+        }
+      });
+  if (!valid) {
+    return ErrorCode::InvalidArgument;
+  }
+
+  return topo;
+}
+
+uint64_t
+galois::graphs::CompressedTopology::DecodeBlock(
+    uint64_t block, uint32_t* out) const {
+  const auto* offsets =
+      reinterpret_cast<const uint64_t*>(block_offsets_->data());
+  uint64_t n = std::min(kBlockSize, num_edges_ - block * kBlockSize);
+  DecodeBlockImpl(data_->data() + offsets[block], n, out);
+  return n;
+}
+
+galois::Result<galois::graphs::GraphTopology>
+galois::graphs::CompressedTopology::Decompress() const {
+  auto dests_result = arrow::AllocateBuffer(num_edges_ * sizeof(uint32_t));
+  if (!dests_result.ok()) {
+    return tsuba::ArrowToTsuba(dests_result.status().code());
+  }
+  std::shared_ptr<arrow::Buffer> dests = std::move(dests_result.ValueOrDie());
+  auto* out = reinterpret_cast<uint32_t*>(dests->mutable_data());
+
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_blocks()),
+      [&](uint64_t block) { DecodeBlock(block, out + block * kBlockSize); });
+
+  return GraphTopology{
+      .out_indices = out_indices_,
+      .out_dests = std::make_shared<arrow::UInt32Array>(num_edges_, dests),
+  };
+}
@@ -0,0 +1,121 @@
+#include "galois/graphs/EdgeIndex.h"
+
+#include <atomic>
+#include <numeric>
+
+#include "galois/Logging.h"
+#include "galois/Loops.h"
+#include "galois/ParallelSTL.h"
+
+namespace {
+
+/// The smallest power of two that is at least twice degree, which keeps
+/// probe sequences short
+uint64_t
+TableSize(uint64_t degree) {
+  uint64_t size = 1;
+  while (size < 2 * degree) {
+    size <<= 1;
+  }
+  return size;
+}
+
+}  // namespace
+
+galois::Result<galois::graphs::EdgeIndex>
+galois::graphs::EdgeIndex::Make(
+    const GraphTopology& topology, uint64_t hub_degree) {
+  if (hub_degree == 0) {
+    GALOIS_LOG_DEBUG("hub degree must be positive");
+    return ErrorCode::InvalidArgument;
+  }
+
+  uint64_t num_nodes = topology.num_nodes();
+  uint64_t num_edges = topology.num_edges();
+  const uint32_t* dests =
+      num_edges > 0 ? topology.out_dests->raw_values() : nullptr;
+
+  EdgeIndex index;
+  index.topology_ = topology;
+
+  index.table_offsets_.resize(num_nodes + 1);
+  index.table_offsets_[0] = 0;
+  galois::do_all(galois::iterate(uint64_t{0}, num_nodes), [&](uint64_t n) {
+    auto [begin, end] = topology.edge_range(n);
+    index.table_offsets_[n + 1] =
+        end - begin >= hub_degree ? TableSize(end - begin) : 0;
+  });
+  galois::ParallelSTL::partial_sum(
+      index.table_offsets_.begin() + 1, index.table_offsets_.end(),
+      index.table_offsets_.begin() + 1);
+  for (uint64_t n = 0; n < num_nodes; ++n) {
+    index.num_hubs_ += index.table_offsets_[n + 1] != index.table_offsets_[n];
+  }
+
+  uint64_t num_slots = index.table_offsets_[num_nodes];
+  index.table_dests_.resize(num_slots);
+  index.table_edges_.assign(num_slots, kEmptySlot);
+
+  // Fill the tables of hubs and check if the edges of the other nodes are
+  // sorted. Inserting edges in order keeps the first of parallel edges.
+  std::atomic<bool> sorted{true};
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_nodes),
+      [&](uint64_t n) {
+        auto [begin, end] = topology.edge_range(n);
+        uint64_t table_begin = index.table_offsets_[n];
+        uint64_t table_end = index.table_offsets_[n + 1];
+        if (table_begin == table_end) {
+          if (sorted.load(std::memory_order_relaxed) &&
+              !std::is_sorted(dests + begin, dests + end)) {
+            sorted.store(false, std::memory_order_relaxed);
+          }
+          return;
+        }
+
+        uint64_t mask = table_end - table_begin - 1;
+        uint32_t* table_dests = index.table_dests_.data() + table_begin;
+        uint64_t* table_edges = index.table_edges_.data() + table_begin;
+        for (uint64_t e = begin; e < end; ++e) {
+          uint32_t dest = dests[e];
+          for (uint64_t slot = Hash(dest) & mask;; slot = (slot + 1) & mask) {
+            if (table_edges[slot] == kEmptySlot) {
+              table_dests[slot] = dest;
+              table_edges[slot] = e;
+              break;
+            }
+            if (table_dests[slot] == dest) {
+              break;
+            }
+          }
+        }
+      },
+      galois::steal());
+
+  if (sorted.load()) {
+    return index;
+  }
+
+  index.sorted_dests_.resize(num_edges);
+  index.sorted_edges_.resize(num_edges);
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_nodes),
+      [&](uint64_t n) {
+        if (index.table_offsets_[n] != index.table_offsets_[n + 1]) {
+          return;
+        }
+        auto [begin, end] = topology.edge_range(n);
+        uint64_t* edges = index.sorted_edges_.data();
+        std::iota(edges + begin, edges + end, begin);
+        // by destination and then edge, so parallel edges find the first
+        std::sort(edges + begin, edges + end, [&](uint64_t a, uint64_t b) {
+          return dests[a] != dests[b] ? dests[a] < dests[b] : a < b;
+        });
+        for (uint64_t i = begin; i < end; ++i) {
+          index.sorted_dests_[i] = dests[edges[i]];
+        }
+      },
+      galois::steal());
+
+  return index;
+}
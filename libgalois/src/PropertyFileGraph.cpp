@@ -2,11 +2,21 @@
 
 #include <sys/mman.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <future>
+#include <limits>
+
+#include <arrow/util/compression.h>
+
 #include "galois/Logging.h"
 #include "galois/Loops.h"
+#include "galois/ParallelSTL.h"
 #include "galois/Platform.h"
 #include "galois/Properties.h"
 #include "galois/Result.h"
+#include "galois/substrate/PerThreadStorage.h"
 #include "tsuba/Errors.h"
 #include "tsuba/FileFrame.h"
 #include "tsuba/RDG.h"
@@ -23,8 +33,39 @@ GetGraphSize(uint64_t num_nodes, uint64_t num_edges) {
          (num_edges * sizeof(uint32_t));
 }
 
-/// MapTopology takes a file buffer of a topology file and extracts the
-/// topology files.
+constexpr uint64_t kTopologyVersion = 1;
+constexpr uint64_t kCompressedTopologyVersion = 2;
+constexpr uint64_t kGapEncodedTopologyVersion = 3;
+constexpr uint64_t kTopologyHeaderSize = 4 * sizeof(uint64_t);
+constexpr uint64_t kGapEncodedTopologyHeaderSize = 6 * sizeof(uint64_t);
+
+// names of the topology arrays that hold the transpose
+const char* kTransposeInIndicesName = "transpose_in_indices";
+const char* kTransposeInSourcesName = "transpose_in_sources";
+const char* kTransposeEdgeIdsName = "transpose_edge_ids";
+// names of the topology arrays that hold the EdgeTypeTopology
+const char* kEdgeTypeNamesName = "edge_type_names";
+const char* kEdgeTypeIndicesName = "edge_type_indices";
+const char* kEdgeTypeDestsName = "edge_type_dests";
+const char* kEdgeTypeEdgeIdsName = "edge_type_edge_ids";
+
+/// Return a buffer for bytes [offset, offset + size) of buf. If owner is not
+/// null, buf is its data and the returned buffer keeps it alive.
+std::shared_ptr<arrow::Buffer>
+WrapBuffer(
+    const uint8_t* buf, uint64_t offset, uint64_t size,
+    const std::shared_ptr<arrow::Buffer>& owner) {
+  if (owner) {
+    return arrow::SliceMutableBuffer(owner, offset, size);
+  }
+  return std::make_shared<arrow::MutableBuffer>(
+      const_cast<uint8_t*>(buf) + offset, size);
+}
+
+/// MapTopology takes a buffer holding a topology file and extracts the
+/// topology files. If owner is not null, the returned arrays refer to slices
+/// of it and keep it alive; otherwise, the caller must keep buf alive for as
+/// long as the topology is in use.
 ///
 /// Format of a topology file (borrowed from the original FileGraph.cpp:
 ///
@@ -40,13 +81,15 @@ GetGraphSize(uint64_t num_nodes, uint64_t num_edges) {
 /// Since property graphs store their edge data separately, we will consider
 /// any topology file with non-zero sizeof_edge_data invalid.
 galois::Result<galois::graphs::GraphTopology>
-MapTopology(const tsuba::FileView& file_view) {
-  const auto* data = file_view.ptr<uint64_t>();
-  if (file_view.size() < 4) {
+MapTopology(
+    const uint8_t* buf, uint64_t size,
+    const std::shared_ptr<arrow::Buffer>& owner) {
+  const auto* data = reinterpret_cast<const uint64_t*>(buf);
+  if (size < kTopologyHeaderSize) {
     return galois::ErrorCode::InvalidArgument;
   }
 
-  if (data[0] != 1) {
+  if (data[0] != kTopologyVersion) {
     return galois::ErrorCode::InvalidArgument;
   }
 
@@ -59,43 +102,332 @@ MapTopology(const tsuba::FileView& file_view) {
 
   uint64_t expected_size = GetGraphSize(num_nodes, num_edges);
 
-  if (file_view.size() < expected_size) {
+  if (size < expected_size) {
     return galois::ErrorCode::InvalidArgument;
   }
 
-  uint64_t* out_indices = const_cast<uint64_t*>(&data[4]);
+  uint64_t indices_size = num_nodes * sizeof(uint64_t);
+  auto indices_buffer =
+      WrapBuffer(buf, kTopologyHeaderSize, indices_size, owner);
+  auto dests_buffer = WrapBuffer(
+      buf, kTopologyHeaderSize + indices_size, num_edges * sizeof(uint32_t),
+      owner);
 
-  auto* out_dests = reinterpret_cast<uint32_t*>(out_indices + num_nodes);
+  return galois::graphs::GraphTopology{
+      .out_indices =
+          std::make_shared<arrow::UInt64Array>(num_nodes, indices_buffer),
+      .out_dests =
+          std::make_shared<arrow::UInt32Array>(num_edges, dests_buffer),
+  };
+}
 
-  auto indices_buffer = std::make_shared<arrow::MutableBuffer>(
-      reinterpret_cast<uint8_t*>(out_indices), num_nodes);
+/// MapGapEncodedTopology is like MapTopology but for gap encoded topology
+/// files.
+///
+/// Format of a gap encoded topology file:
+///
+///   uint64_t version: 3
+///   uint64_t sizeof_edge_data: 0
+///   uint64_t num_nodes: number of nodes
+///   uint64_t num_edges: number of edges
+///   uint64_t num_blocks: number of blocks of encoded destinations
+///   uint64_t data_size: size of the encoded destinations, including padding
+///   uint64_t[num_nodes] out_indices: start and end of the edges for a node
+///   uint64_t[num_blocks + 1] block_offsets: offset of each block in data
+///   uint8_t[data_size] data: destinations encoded as described by
+///     CompressedTopology
+galois::Result<galois::graphs::CompressedTopology>
+MapGapEncodedTopology(
+    const uint8_t* buf, uint64_t size,
+    const std::shared_ptr<arrow::Buffer>& owner) {
+  const auto* data = reinterpret_cast<const uint64_t*>(buf);
+  if (size < kGapEncodedTopologyHeaderSize) {
+    return galois::ErrorCode::InvalidArgument;
+  }
 
-  auto dests_buffer = std::make_shared<arrow::MutableBuffer>(
-      reinterpret_cast<uint8_t*>(out_dests), num_edges);
+  if (data[0] != kGapEncodedTopologyVersion || data[1] != 0) {
+    return galois::ErrorCode::InvalidArgument;
+  }
 
-  return galois::graphs::GraphTopology{
-      .out_indices = std::make_shared<arrow::UInt64Array>(
-          indices_buffer->size(), indices_buffer),
-      .out_dests = std::make_shared<arrow::UInt32Array>(
-          dests_buffer->size(), dests_buffer),
-  };
+  uint64_t num_nodes = data[2];
+  uint64_t num_edges = data[3];
+  uint64_t num_blocks = data[4];
+  uint64_t data_size = data[5];
+
+  uint64_t indices_size = num_nodes * sizeof(uint64_t);
+  uint64_t offsets_size = (num_blocks + 1) * sizeof(uint64_t);
+  if (size <
+      kGapEncodedTopologyHeaderSize + indices_size + offsets_size + data_size) {
+    return galois::ErrorCode::InvalidArgument;
+  }
+
+  uint64_t pos = kGapEncodedTopologyHeaderSize;
+  auto indices_buffer = WrapBuffer(buf, pos, indices_size, owner);
+  pos += indices_size;
+  auto offsets_buffer = WrapBuffer(buf, pos, offsets_size, owner);
+  pos += offsets_size;
+  auto data_buffer = WrapBuffer(buf, pos, data_size, owner);
+
+  return galois::graphs::CompressedTopology::Make(
+      std::make_shared<arrow::UInt64Array>(num_nodes, indices_buffer),
+      num_edges, std::move(offsets_buffer), std::move(data_buffer));
 }
 
+/// DecompressTopology takes a buffer holding a compressed topology file and
+/// returns the uncompressed topology file it contains.
+///
+/// Format of a compressed topology file:
+///
+///   uint64_t version: 2
+///   uint64_t codec: arrow::Compression::type used to compress the topology
+///   uint64_t uncompressed_size: size of the uncompressed topology file
+///   uint64_t compressed_size: size of the compressed data
+///   uint8_t[compressed_size]: a version 1 or 3 topology file compressed by
+///     codec
+galois::Result<std::shared_ptr<arrow::Buffer>>
+DecompressTopology(const uint8_t* buf, uint64_t size) {
+  const auto* data = reinterpret_cast<const uint64_t*>(buf);
+  if (size < kTopologyHeaderSize || data[0] != kCompressedTopologyVersion) {
+    return galois::ErrorCode::InvalidArgument;
+  }
+
+  auto codec_type = static_cast<arrow::Compression::type>(data[1]);
+  uint64_t uncompressed_size = data[2];
+  uint64_t compressed_size = data[3];
+  if (size < kTopologyHeaderSize + compressed_size) {
+    return galois::ErrorCode::InvalidArgument;
+  }
+
+  auto codec_result = arrow::util::Codec::Create(codec_type);
+  if (!codec_result.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", codec_result.status());
+    return tsuba::ArrowToTsuba(codec_result.status().code());
+  }
+  std::unique_ptr<arrow::util::Codec> codec =
+      std::move(codec_result.ValueOrDie());
+
+  auto alloc_result = arrow::AllocateBuffer(uncompressed_size);
+  if (!alloc_result.ok()) {
+    return tsuba::ArrowToTsuba(alloc_result.status().code());
+  }
+  std::shared_ptr<arrow::Buffer> out = std::move(alloc_result.ValueOrDie());
+
+  auto decompress_result = codec->Decompress(
+      compressed_size, buf + kTopologyHeaderSize, uncompressed_size,
+      out->mutable_data());
+  if (!decompress_result.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", decompress_result.status());
+    return tsuba::ArrowToTsuba(decompress_result.status().code());
+  }
+  if (static_cast<uint64_t>(decompress_result.ValueOrDie()) !=
+      uncompressed_size) {
+    GALOIS_LOG_DEBUG(
+        "expected {} bytes of topology found {}", uncompressed_size,
+        decompress_result.ValueOrDie());
+    return galois::ErrorCode::InvalidArgument;
+  }
+
+  return out;
+}
+
+/// Load a topology file into topology. Gap encoded topologies are also
+/// returned in compressed.
 galois::Result<void>
 LoadTopology(
     galois::graphs::GraphTopology* topology,
+    std::shared_ptr<galois::graphs::CompressedTopology>* compressed,
     const tsuba::FileView& topology_file_storage) {
-  auto map_result = MapTopology(topology_file_storage);
+  const auto* data = topology_file_storage.ptr<uint8_t>();
+  uint64_t size = topology_file_storage.size();
+
+  auto version = [&]() -> uint64_t {
+    return size >= sizeof(uint64_t) ? *reinterpret_cast<const uint64_t*>(data)
+                                    : 0;
+  };
+
+  std::shared_ptr<arrow::Buffer> owner;
+  if (version() == kCompressedTopologyVersion) {
+    auto decompress_result = DecompressTopology(data, size);
+    if (!decompress_result) {
+      return decompress_result.error();
+    }
+    owner = std::move(decompress_result.value());
+    data = owner->data();
+    size = owner->size();
+  }
+
+  if (version() == kGapEncodedTopologyVersion) {
+    auto map_result = MapGapEncodedTopology(data, size, owner);
+    if (!map_result) {
+      return map_result.error();
+    }
+    auto decompress_result = map_result.value().Decompress();
+    if (!decompress_result) {
+      return decompress_result.error();
+    }
+    *compressed = std::make_shared<galois::graphs::CompressedTopology>(
+        std::move(map_result.value()));
+    *topology = std::move(decompress_result.value());
+    return galois::ResultSuccess();
+  }
+
+  auto map_result = MapTopology(data, size, owner);
   if (!map_result) {
     return map_result.error();
   }
   *topology = std::move(map_result.value());
+  compressed->reset();
 
   return galois::ResultSuccess();
 }
 
+/// Serialize topology as a topology file in memory
+galois::Result<std::shared_ptr<arrow::Buffer>>
+SerializeTopology(
+    const galois::graphs::GraphTopology& topology,
+    galois::graphs::TopologyEncoding encoding) {
+  uint64_t num_nodes = topology.num_nodes();
+  uint64_t num_edges = topology.num_edges();
+  uint64_t indices_size = num_nodes * sizeof(uint64_t);
+
+  if (encoding == galois::graphs::TopologyEncoding::GapEncoded) {
+    auto encode_result =
+        galois::graphs::CompressedTopology::Encode(topology);
+    if (!encode_result) {
+      return encode_result.error();
+    }
+    const galois::graphs::CompressedTopology& compressed =
+        encode_result.value();
+    uint64_t num_blocks = compressed.num_blocks();
+    uint64_t offsets_size = (num_blocks + 1) * sizeof(uint64_t);
+    uint64_t data_size = compressed.data()->size();
+
+    auto alloc_result = galois::graphs::AllocateTopologyBuffer(
+        kGapEncodedTopologyHeaderSize + indices_size + offsets_size +
+        data_size);
+    if (!alloc_result) {
+      return alloc_result.error();
+    }
+    std::shared_ptr<arrow::Buffer> out = std::move(alloc_result.value());
+
+    uint8_t* pos = out->mutable_data();
+    uint64_t header[6] = {kGapEncodedTopologyVersion, 0, num_nodes, num_edges,
+                          num_blocks, data_size};
+    std::memcpy(pos, header, sizeof(header));
+    pos += sizeof(header);
+    if (num_nodes) {
+      std::memcpy(pos, topology.out_indices->raw_values(), indices_size);
+      pos += indices_size;
+    }
+    std::memcpy(pos, compressed.block_offsets()->data(), offsets_size);
+    pos += offsets_size;
+    std::memcpy(pos, compressed.data()->data(), data_size);
+    return out;
+  }
+
+  auto alloc_result = galois::graphs::AllocateTopologyBuffer(
+      GetGraphSize(num_nodes, num_edges));
+  if (!alloc_result) {
+    return alloc_result.error();
+  }
+  std::shared_ptr<arrow::Buffer> out = std::move(alloc_result.value());
+
+  uint8_t* pos = out->mutable_data();
+  uint64_t header[4] = {kTopologyVersion, 0, num_nodes, num_edges};
+  std::memcpy(pos, header, sizeof(header));
+  pos += sizeof(header);
+  if (num_nodes) {
+    std::memcpy(pos, topology.out_indices->raw_values(), indices_size);
+    pos += indices_size;
+  }
+  if (num_edges) {
+    std::memcpy(
+        pos, topology.out_dests->raw_values(), num_edges * sizeof(uint32_t));
+    pos += num_edges * sizeof(uint32_t);
+  }
+  // zero padding, if any
+  std::memset(pos, 0, out->mutable_data() + out->size() - pos);
+  return out;
+}
+
+/// Compress a serialized topology file with codec and wrap it in a version 2
+/// topology file
+galois::Result<std::unique_ptr<tsuba::FileFrame>>
+WriteCompressedTopology(
+    const arrow::Buffer& uncompressed, arrow::Compression::type codec_type,
+    int level) {
+  auto codec_result = arrow::util::Codec::Create(codec_type, level);
+  if (!codec_result.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", codec_result.status());
+    return tsuba::ArrowToTsuba(codec_result.status().code());
+  }
+  std::unique_ptr<arrow::util::Codec> codec =
+      std::move(codec_result.ValueOrDie());
+
+  uint64_t uncompressed_size = uncompressed.size();
+  int64_t max_size =
+      codec->MaxCompressedLen(uncompressed_size, uncompressed.data());
+  auto alloc_result = galois::graphs::AllocateTopologyBuffer(max_size);
+  if (!alloc_result) {
+    return alloc_result.error();
+  }
+  std::shared_ptr<arrow::Buffer> compressed = std::move(alloc_result.value());
+
+  auto compress_result = codec->Compress(
+      uncompressed_size, uncompressed.data(), max_size,
+      compressed->mutable_data());
+  if (!compress_result.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", compress_result.status());
+    return tsuba::ArrowToTsuba(compress_result.status().code());
+  }
+  uint64_t compressed_size = compress_result.ValueOrDie();
+
+  auto ff = std::make_unique<tsuba::FileFrame>();
+  if (auto res = ff->Init(kTopologyHeaderSize + compressed_size); !res) {
+    return res.error();
+  }
+
+  uint64_t data[4] = {
+      kCompressedTopologyVersion, static_cast<uint64_t>(codec_type),
+      uncompressed_size, compressed_size};
+  arrow::Status aro_sts = ff->Write(&data, kTopologyHeaderSize);
+  if (!aro_sts.ok()) {
+    return tsuba::ArrowToTsuba(aro_sts.code());
+  }
+  aro_sts = ff->Write(compressed->data(), compressed_size);
+  if (!aro_sts.ok()) {
+    return tsuba::ArrowToTsuba(aro_sts.code());
+  }
+  return std::unique_ptr<tsuba::FileFrame>(std::move(ff));
+}
+
 galois::Result<std::unique_ptr<tsuba::FileFrame>>
-WriteTopology(const galois::graphs::GraphTopology& topology) {
+WriteTopology(
+    const galois::graphs::GraphTopology& topology,
+    galois::graphs::TopologyEncoding encoding, arrow::Compression::type codec,
+    int level) {
+  if (encoding != galois::graphs::TopologyEncoding::Plain ||
+      codec != arrow::Compression::UNCOMPRESSED) {
+    auto serialize_result = SerializeTopology(topology, encoding);
+    if (!serialize_result) {
+      return serialize_result.error();
+    }
+    const arrow::Buffer& file = *serialize_result.value();
+    if (codec != arrow::Compression::UNCOMPRESSED) {
+      return WriteCompressedTopology(file, codec, level);
+    }
+
+    auto ff = std::make_unique<tsuba::FileFrame>();
+    if (auto res = ff->Init(file.size()); !res) {
+      return res.error();
+    }
+    arrow::Status aro_sts = ff->Write(file.data(), file.size());
+    if (!aro_sts.ok()) {
+      return tsuba::ArrowToTsuba(aro_sts.code());
+    }
+    return std::unique_ptr<tsuba::FileFrame>(std::move(ff));
+  }
+
   auto ff = std::make_unique<tsuba::FileFrame>();
   if (auto res = ff->Init(); !res) {
     return res.error();
@@ -103,7 +435,7 @@ WriteTopology(const galois::graphs::GraphTopology& topology) {
   uint64_t num_nodes = topology.num_nodes();
   uint64_t num_edges = topology.num_edges();
 
-  uint64_t data[4] = {1, 0, num_nodes, num_edges};
+  uint64_t data[4] = {kTopologyVersion, 0, num_nodes, num_edges};
   arrow::Status aro_sts = ff->Write(&data, 4 * sizeof(uint64_t));
   if (!aro_sts.ok()) {
     return tsuba::ArrowToTsuba(aro_sts.code());
@@ -133,6 +465,219 @@ WriteTopology(const galois::graphs::GraphTopology& topology) {
   return std::unique_ptr<tsuba::FileFrame>(std::move(ff));
 }
 
+/// Compute the transpose of topology in parallel: count in-degrees, take
+/// their prefix sum, scatter each out-edge into its destination's in-edges,
+/// and finally sort each node's in-edges so that the result is deterministic
+galois::Result<std::shared_ptr<galois::graphs::TransposeTopology>>
+MakeTranspose(const galois::graphs::GraphTopology& topology) {
+  uint64_t num_nodes = topology.num_nodes();
+  uint64_t num_edges = topology.num_edges();
+
+  auto indices_result =
+      galois::graphs::AllocateTopologyBuffer(num_nodes * sizeof(uint64_t));
+  if (!indices_result) {
+    return indices_result.error();
+  }
+  auto sources_result =
+      galois::graphs::AllocateTopologyBuffer(num_edges * sizeof(uint32_t));
+  if (!sources_result) {
+    return sources_result.error();
+  }
+  auto edge_ids_result =
+      galois::graphs::AllocateTopologyBuffer(num_edges * sizeof(uint64_t));
+  if (!edge_ids_result) {
+    return edge_ids_result.error();
+  }
+  auto* in_indices =
+      reinterpret_cast<uint64_t*>(indices_result.value()->mutable_data());
+  auto* in_sources =
+      reinterpret_cast<uint32_t*>(sources_result.value()->mutable_data());
+  auto* edge_ids =
+      reinterpret_cast<uint64_t*>(edge_ids_result.value()->mutable_data());
+
+  // in-degrees, then the next free in-edge slot of each node
+  std::vector<std::atomic<uint64_t>> counts(num_nodes);
+  galois::do_all(galois::iterate(uint64_t{0}, num_nodes), [&](uint64_t n) {
+    counts[n].store(0, std::memory_order_relaxed);
+  });
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_nodes),
+      [&](uint64_t n) {
+        auto [begin, end] = topology.edge_range(n);
+        for (uint64_t e = begin; e < end; ++e) {
+          counts[topology.out_dests->Value(e)].fetch_add(
+              1, std::memory_order_relaxed);
+        }
+      },
+      galois::steal());
+
+  galois::do_all(galois::iterate(uint64_t{0}, num_nodes), [&](uint64_t n) {
+    in_indices[n] = counts[n].load(std::memory_order_relaxed);
+  });
+  galois::ParallelSTL::partial_sum(
+      in_indices, in_indices + num_nodes, in_indices);
+  galois::do_all(galois::iterate(uint64_t{0}, num_nodes), [&](uint64_t n) {
+    counts[n].store(n > 0 ? in_indices[n - 1] : 0, std::memory_order_relaxed);
+  });
+
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_nodes),
+      [&](uint64_t n) {
+        auto [begin, end] = topology.edge_range(n);
+        for (uint64_t e = begin; e < end; ++e) {
+          uint64_t slot = counts[topology.out_dests->Value(e)].fetch_add(
+              1, std::memory_order_relaxed);
+          edge_ids[slot] = e;
+        }
+      },
+      galois::steal());
+
+  // Out-edges are numbered in order of their source, so sorting by edge id
+  // also sorts by source, which is then found from the out indices
+  const uint64_t* out_indices =
+      num_nodes > 0 ? topology.out_indices->raw_values() : nullptr;
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_nodes),
+      [&](uint64_t n) {
+        uint64_t begin = n > 0 ? in_indices[n - 1] : 0;
+        uint64_t end = in_indices[n];
+        std::sort(edge_ids + begin, edge_ids + end);
+        for (uint64_t i = begin; i < end; ++i) {
+          const uint64_t* src_end = std::upper_bound(
+              out_indices, out_indices + num_nodes, edge_ids[i]);
+          in_sources[i] = src_end - out_indices;
+        }
+      },
+      galois::steal());
+
+  return std::make_shared<galois::graphs::TransposeTopology>(
+      galois::graphs::TransposeTopology{
+          .topology =
+              galois::graphs::GraphTopology{
+                  .out_indices = std::make_shared<arrow::UInt64Array>(
+                      num_nodes, indices_result.value()),
+                  .out_dests = std::make_shared<arrow::UInt32Array>(
+                      num_edges, sources_result.value()),
+              },
+          .edge_ids = std::make_shared<arrow::UInt64Array>(
+              num_edges, edge_ids_result.value()),
+      });
+}
+
+/// Group the out-edges of each node by type in parallel: count the edges of
+/// each (node, type) pair, take their prefix sum and copy the edges of each
+/// pair in order. Counting and copying each make a single pass over the
+/// edges of a node, visiting every type of an edge as they go.
+galois::Result<std::shared_ptr<galois::graphs::EdgeTypeTopology>>
+MakeEdgeTypeTopology(
+    const galois::graphs::GraphTopology& topology,
+    const std::vector<std::string>& type_names,
+    const std::vector<std::shared_ptr<arrow::BooleanArray>>& types) {
+  uint64_t num_nodes = topology.num_nodes();
+  uint64_t num_types = types.size();
+  uint64_t num_groups = num_nodes * num_types;
+
+  auto has_type = [&types](uint64_t edge, uint64_t type) {
+    return types[type]->IsValid(edge) && types[type]->Value(edge);
+  };
+
+  auto indices_result =
+      galois::graphs::AllocateTopologyBuffer(num_groups * sizeof(uint64_t));
+  if (!indices_result) {
+    return indices_result.error();
+  }
+  auto* type_indices =
+      reinterpret_cast<uint64_t*>(indices_result.value()->mutable_data());
+
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_nodes),
+      [&](uint64_t n) {
+        auto [begin, end] = topology.edge_range(n);
+        uint64_t* counts = type_indices + n * num_types;
+        std::fill(counts, counts + num_types, 0);
+        for (uint64_t e = begin; e < end; ++e) {
+          for (uint64_t t = 0; t < num_types; ++t) {
+            counts[t] += has_type(e, t);
+          }
+        }
+      },
+      galois::steal());
+  galois::ParallelSTL::partial_sum(
+      type_indices, type_indices + num_groups, type_indices);
+  uint64_t num_typed_edges = num_groups > 0 ? type_indices[num_groups - 1] : 0;
+
+  auto dests_result = galois::graphs::AllocateTopologyBuffer(
+      num_typed_edges * sizeof(uint32_t));
+  if (!dests_result) {
+    return dests_result.error();
+  }
+  auto edge_ids_result = galois::graphs::AllocateTopologyBuffer(
+      num_typed_edges * sizeof(uint64_t));
+  if (!edge_ids_result) {
+    return edge_ids_result.error();
+  }
+  auto* dests =
+      reinterpret_cast<uint32_t*>(dests_result.value()->mutable_data());
+  auto* edge_ids =
+      reinterpret_cast<uint64_t*>(edge_ids_result.value()->mutable_data());
+
+  // next free slot of each type of the node being copied
+  galois::substrate::PerThreadStorage<std::vector<uint64_t>> thread_slots;
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_nodes),
+      [&](uint64_t n) {
+        std::vector<uint64_t>& slots = *thread_slots.getLocal();
+        slots.resize(num_types);
+        uint64_t first_group = n * num_types;
+        slots[0] = first_group > 0 ? type_indices[first_group - 1] : 0;
+        for (uint64_t t = 1; t < num_types; ++t) {
+          slots[t] = type_indices[first_group + t - 1];
+        }
+
+        auto [begin, end] = topology.edge_range(n);
+        for (uint64_t e = begin; e < end; ++e) {
+          for (uint64_t t = 0; t < num_types; ++t) {
+            if (has_type(e, t)) {
+              uint64_t slot = slots[t]++;
+              dests[slot] = topology.out_dests->Value(e);
+              edge_ids[slot] = e;
+            }
+          }
+        }
+      },
+      galois::steal());
+
+  return std::make_shared<galois::graphs::EdgeTypeTopology>(
+      galois::graphs::EdgeTypeTopology{
+          .type_names = type_names,
+          .type_indices = std::make_shared<arrow::UInt64Array>(
+              num_groups, indices_result.value()),
+          .dests = std::make_shared<arrow::UInt32Array>(
+              num_typed_edges, dests_result.value()),
+          .edge_ids = std::make_shared<arrow::UInt64Array>(
+              num_typed_edges, edge_ids_result.value()),
+      });
+}
+
+/// Return the single chunk of a stored topology array
+template <typename ArrayType>
+galois::Result<std::shared_ptr<ArrayType>>
+UnchunkTopologyArray(
+    const std::shared_ptr<arrow::ChunkedArray>& array, uint64_t length) {
+  if (array->num_chunks() != 1 ||
+      static_cast<uint64_t>(array->length()) != length) {
+    GALOIS_LOG_DEBUG(
+        "expected one chunk of length {} found {} chunks of length {}",
+        length, array->num_chunks(), array->length());
+    return galois::ErrorCode::InvalidArgument;
+  }
+  auto typed = std::dynamic_pointer_cast<ArrayType>(array->chunk(0));
+  if (!typed) {
+    return galois::ErrorCode::TypeError;
+  }
+  return typed;
+}
+
 galois::Result<std::unique_ptr<galois::graphs::PropertyFileGraph>>
 MakePropertyFileGraph(
     std::unique_ptr<tsuba::RDGFile> rdg_file,
@@ -167,6 +712,12 @@ galois::graphs::PropertyFileGraph::PropertyFileGraph(
     std::unique_ptr<tsuba::RDGFile> rdg_file, tsuba::RDG&& rdg)
     : rdg_(std::move(rdg)), file_(std::move(rdg_file)) {}
 
+galois::graphs::PropertyFileGraph::~PropertyFileGraph() {
+  if (auto res = WaitForCommit(); !res) {
+    GALOIS_LOG_ERROR("background commit: {}", res.error());
+  }
+}
+
 galois::Result<void>
 galois::graphs::PropertyFileGraph::Validate() {
   // TODO (thunt) check that arrow table sizes match topology
@@ -184,25 +735,59 @@ galois::graphs::PropertyFileGraph::Validate() {
 galois::Result<void>
 galois::graphs::PropertyFileGraph::DoWrite(
     tsuba::RDGHandle handle, const std::string& command_line) {
-  if (!rdg_.topology_file_storage().Valid()) {
-    auto result = WriteTopology(topology_);
+  if (!rdg_.topology_file_storage().Valid() || rewrite_topology_) {
+    auto result = WriteTopology(
+        topology(), topology_encoding_, topology_codec_,
+        topology_compression_level_);
     if (!result) {
       return result.error();
     }
-    return rdg_.Store(handle, command_line, std::move(result.value()));
+    if (auto res = rdg_.Store(handle, command_line, std::move(result.value()));
+        !res) {
+      return res.error();
+    }
+    rewrite_topology_ = false;
+    return ResultSuccess();
   }
 
   return rdg_.Store(handle, command_line);
 }
 
+galois::Result<void>
+galois::graphs::PropertyFileGraph::SetTopologyCompression(
+    arrow::Compression::type codec, int level) {
+  if (!arrow::util::Codec::IsAvailable(codec)) {
+    GALOIS_LOG_DEBUG(
+        "codec {} is not available",
+        arrow::util::Codec::GetCodecAsString(codec));
+    return ErrorCode::NotImplemented;
+  }
+  if (codec != topology_codec_ || level != topology_compression_level_) {
+    topology_codec_ = codec;
+    topology_compression_level_ = level;
+    rewrite_topology_ = true;
+  }
+  return ResultSuccess();
+}
+
+void
+galois::graphs::PropertyFileGraph::SetTopologyEncoding(
+    TopologyEncoding encoding) {
+  if (encoding != topology_encoding_) {
+    topology_encoding_ = encoding;
+    rewrite_topology_ = true;
+  }
+}
+
 galois::Result<std::unique_ptr<galois::graphs::PropertyFileGraph>>
 galois::graphs::PropertyFileGraph::Make(
     std::unique_ptr<tsuba::RDGFile> rdg_file, tsuba::RDG&& rdg) {
   auto g = std::unique_ptr<PropertyFileGraph>(
       new PropertyFileGraph(std::move(rdg_file), std::move(rdg)));
 
-  auto load_result =
-      LoadTopology(&g->topology_, g->rdg_.topology_file_storage());
+  auto load_result = LoadTopology(
+      &g->topology_, &g->compressed_topology_,
+      g->rdg_.topology_file_storage());
   if (!load_result) {
     return load_result.error();
   }
@@ -239,6 +824,113 @@ galois::graphs::PropertyFileGraph::Make(
       edge_properties);
 }
 
+galois::Result<std::unique_ptr<galois::graphs::PropertyFileGraph>>
+galois::graphs::PropertyFileGraph::MakeLazy(
+    const std::string& rdg_name,
+    const std::vector<std::string>& prefetch_node_properties,
+    const std::vector<std::string>& prefetch_edge_properties) {
+  auto handle = tsuba::Open(rdg_name, tsuba::kReadWrite);
+  if (!handle) {
+    return handle.error();
+  }
+  auto rdg_file = std::make_unique<tsuba::RDGFile>(handle.value());
+
+  auto rdg_result = tsuba::RDG::MakeLazy(
+      *rdg_file, prefetch_node_properties, prefetch_edge_properties);
+  if (!rdg_result) {
+    return rdg_result.error();
+  }
+
+  return galois::graphs::PropertyFileGraph::Make(
+      std::move(rdg_file), std::move(rdg_result.value()));
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::LoadNodePropertyIfUnloaded(
+    const std::string& name) const {
+  if (auto res = FindOrLoadNodeProperty(name); !res) {
+    return res.error();
+  }
+  return galois::ResultSuccess();
+}
+
+galois::Result<std::shared_ptr<arrow::ChunkedArray>>
+galois::graphs::PropertyFileGraph::FindOrLoadNodeProperty(
+    const std::string& name) const {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  if (auto column = rdg_.node_table()->GetColumnByName(name)) {
+    return column;
+  }
+  auto unloaded = rdg_.UnloadedNodePropertyNames();
+  if (std::find(unloaded.begin(), unloaded.end(), name) == unloaded.end()) {
+    // not stored either; let the caller report that it is missing
+    return std::shared_ptr<arrow::ChunkedArray>();
+  }
+  if (auto res = rdg_.LoadNodeProperty(name); !res) {
+    return res.error();
+  }
+  PublishSnapshot();
+  return rdg_.node_table()->GetColumnByName(name);
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::LoadEdgePropertyIfUnloaded(
+    const std::string& name) const {
+  if (auto res = FindOrLoadEdgeProperty(name); !res) {
+    return res.error();
+  }
+  return galois::ResultSuccess();
+}
+
+galois::Result<std::shared_ptr<arrow::ChunkedArray>>
+galois::graphs::PropertyFileGraph::FindOrLoadEdgeProperty(
+    const std::string& name) const {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  if (auto column = rdg_.edge_table()->GetColumnByName(name)) {
+    return column;
+  }
+  auto unloaded = rdg_.UnloadedEdgePropertyNames();
+  if (std::find(unloaded.begin(), unloaded.end(), name) == unloaded.end()) {
+    return std::shared_ptr<arrow::ChunkedArray>();
+  }
+  if (auto res = rdg_.LoadEdgeProperty(name); !res) {
+    return res.error();
+  }
+  PublishSnapshot();
+  return rdg_.edge_table()->GetColumnByName(name);
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::EnsureNodePropertiesLoaded(
+    const std::vector<std::string>& names) const {
+  for (const std::string& name : names) {
+    if (auto res = LoadNodePropertyIfUnloaded(name); !res) {
+      return res.error();
+    }
+  }
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::EnsureEdgePropertiesLoaded(
+    const std::vector<std::string>& names) const {
+  for (const std::string& name : names) {
+    if (auto res = LoadEdgePropertyIfUnloaded(name); !res) {
+      return res.error();
+    }
+  }
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::EnsureAllPropertiesLoaded() const {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  auto res = rdg_.LoadAllProperties();
+  // some properties may have loaded even if others failed
+  PublishSnapshot();
+  return res;
+}
+
 galois::Result<void>
 galois::graphs::PropertyFileGraph::WriteGraph(
     const std::string& uri, const std::string& command_line) {
@@ -248,8 +940,11 @@ galois::graphs::PropertyFileGraph::WriteGraph(
   }
   auto new_file = std::make_unique<tsuba::RDGFile>(open_res.value());
 
-  if (auto res = DoWrite(*new_file, command_line); !res) {
-    return res.error();
+  {
+    std::lock_guard<std::mutex> lock(rdg_mutex_);
+    if (auto res = DoWrite(*new_file, command_line); !res) {
+      return res.error();
+    }
   }
 
   file_ = std::move(new_file);
@@ -259,6 +954,10 @@ galois::graphs::PropertyFileGraph::WriteGraph(
 
 galois::Result<void>
 galois::graphs::PropertyFileGraph::Commit(const std::string& command_line) {
+  if (auto res = WaitForCommit(); !res) {
+    // already reported through the future returned by CommitAsync
+    GALOIS_LOG_DEBUG("previous commit: {}", res.error());
+  }
   if (file_ == nullptr) {
     if (rdg_.rdg_dir().empty()) {
       GALOIS_LOG_ERROR("RDG commit but rdg_dir_ is empty");
@@ -266,12 +965,117 @@ galois::graphs::PropertyFileGraph::Commit(const std::string& command_line) {
     }
     return WriteGraph(rdg_.rdg_dir().string(), command_line);
   }
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
   return DoWrite(*file_, command_line);
 }
 
+std::shared_future<galois::Result<void>>
+galois::graphs::PropertyFileGraph::CommitAsync(
+    const std::string& command_line) {
+  if (auto res = WaitForCommit(); !res) {
+    GALOIS_LOG_DEBUG("previous commit: {}", res.error());
+  }
+
+  std::unique_ptr<tsuba::RDGFile> new_file;
+  if (file_ == nullptr) {
+    if (rdg_.rdg_dir().empty()) {
+      GALOIS_LOG_ERROR("RDG commit but rdg_dir_ is empty");
+      return AsyncError<void>(ErrorCode::InvalidArgument).share();
+    }
+    auto open_res = tsuba::Open(rdg_.rdg_dir().string(), tsuba::kReadWrite);
+    if (!open_res) {
+      return AsyncError<void>(open_res.error()).share();
+    }
+    new_file = std::make_unique<tsuba::RDGFile>(open_res.value());
+  }
+  tsuba::RDGHandle handle = new_file ? *new_file : *file_;
+
+  // Taking the snapshot may load and unbind properties, which lazy loads by
+  // readers also do
+  std::unique_lock<std::mutex> lock(rdg_mutex_);
+  bool write_topology =
+      !rdg_.topology_file_storage().Valid() || rewrite_topology_;
+  // Copied so that the topology can be replaced while it is written; this
+  // also decompresses it if needed
+  GraphTopology topology = this->topology();
+
+  auto snapshot_res = rdg_.Snapshot(handle, write_topology);
+  if (!snapshot_res) {
+    return AsyncError<void>(snapshot_res.error()).share();
+  }
+  auto snapshot =
+      std::make_shared<tsuba::RDG>(std::move(snapshot_res.value()));
+  uint64_t topology_version = topology_version_;
+  lock.unlock();
+
+  std::shared_future<Result<void>> result =
+      std::async(
+          std::launch::async,
+          [snapshot, handle, command_line, write_topology,
+           topology = std::move(topology), encoding = topology_encoding_,
+           codec = topology_codec_,
+           level = topology_compression_level_]() -> galois::Result<void> {
+            if (!write_topology) {
+              return snapshot->Store(handle, command_line);
+            }
+            auto ff_res = WriteTopology(topology, encoding, codec, level);
+            if (!ff_res) {
+              return ff_res.error();
+            }
+            return snapshot->Store(
+                handle, command_line, std::move(ff_res.value()));
+          })
+          .share();
+
+  pending_commit_ = PendingCommit{
+      .result = result,
+      .snapshot = std::move(snapshot),
+      .file = std::move(new_file),
+      .command_line = command_line,
+      .rewrite_topology = rewrite_topology_,
+      .write_topology = write_topology,
+      .topology_version = topology_version,
+  };
+  if (write_topology) {
+    rewrite_topology_ = false;
+  }
+
+  return result;
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::WaitForCommit() {
+  if (!pending_commit_) {
+    return ResultSuccess();
+  }
+  PendingCommit pending = std::move(pending_commit_.value());
+  pending_commit_.reset();
+
+  galois::Result<void> res = pending.result.get();
+  if (!res) {
+    rewrite_topology_ = rewrite_topology_ || pending.rewrite_topology;
+    return res.error();
+  }
+
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  // The stored topology is only current if the topology was not replaced
+  // while it was written
+  bool adopt_topology = pending.write_topology &&
+                        pending.topology_version == topology_version_;
+  rdg_.AdoptStoredLocations(
+      *pending.snapshot, pending.command_line, adopt_topology);
+  if (pending.file) {
+    file_ = std::move(pending.file);
+  }
+  return ResultSuccess();
+}
+
 galois::Result<void>
 galois::graphs::PropertyFileGraph::Write(
     const std::string& rdg_name, const std::string& command_line) {
+  if (auto res = WaitForCommit(); !res) {
+    GALOIS_LOG_DEBUG("previous commit: {}", res.error());
+  }
   if (auto res = tsuba::Create(rdg_name); !res) {
     return res.error();
   }
@@ -281,6 +1085,7 @@ galois::graphs::PropertyFileGraph::Write(
 galois::Result<void>
 galois::graphs::PropertyFileGraph::AddNodeProperties(
     const std::shared_ptr<arrow::Table>& table) {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
   if (topology_.out_indices &&
       topology_.out_indices->length() != table->num_rows()) {
     GALOIS_LOG_DEBUG(
@@ -288,12 +1093,17 @@ galois::graphs::PropertyFileGraph::AddNodeProperties(
         table->num_rows());
     return ErrorCode::InvalidArgument;
   }
-  return rdg_.AddNodeProperties(table);
+  if (auto res = rdg_.AddNodeProperties(table); !res) {
+    return res.error();
+  }
+  PublishSnapshot();
+  return galois::ResultSuccess();
 }
 
 galois::Result<void>
 galois::graphs::PropertyFileGraph::AddEdgeProperties(
     const std::shared_ptr<arrow::Table>& table) {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
   if (topology_.out_dests &&
       topology_.out_dests->length() != table->num_rows()) {
     GALOIS_LOG_DEBUG(
@@ -301,20 +1111,416 @@ galois::graphs::PropertyFileGraph::AddEdgeProperties(
         table->num_rows());
     return ErrorCode::InvalidArgument;
   }
-  return rdg_.AddEdgeProperties(table);
+  if (auto res = rdg_.AddEdgeProperties(table); !res) {
+    return res.error();
+  }
+  PublishSnapshot();
+  return galois::ResultSuccess();
 }
 
 galois::Result<void>
-galois::graphs::PropertyFileGraph::SetTopology(
+galois::graphs::PropertyFileGraph::RemoveNodeProperty(int i) {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  if (auto res = rdg_.RemoveNodeProperty(i); !res) {
+    return res.error();
+  }
+  PublishSnapshot();
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::RemoveNodeProperty(
+    const std::string& prop_name) {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  auto col_names = rdg_.node_table()->ColumnNames();
+  auto pos = std::find(col_names.cbegin(), col_names.cend(), prop_name);
+  if (pos == col_names.cend()) {
+    // A stored property that was never loaded only has to leave the header
+    auto unloaded = rdg_.UnloadedNodePropertyNames();
+    if (std::find(unloaded.begin(), unloaded.end(), prop_name) ==
+        unloaded.end()) {
+      return galois::ErrorCode::PropertyNotFound;
+    }
+    return rdg_.RemoveUnloadedNodeProperty(prop_name);
+  }
+  if (auto res =
+          rdg_.RemoveNodeProperty(std::distance(col_names.cbegin(), pos));
+      !res) {
+    return res.error();
+  }
+  PublishSnapshot();
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::RemoveEdgeProperty(int i) {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  if (auto res = rdg_.RemoveEdgeProperty(i); !res) {
+    return res.error();
+  }
+  PublishSnapshot();
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::RemoveEdgeProperty(
+    const std::string& prop_name) {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  auto col_names = rdg_.edge_table()->ColumnNames();
+  auto pos = std::find(col_names.cbegin(), col_names.cend(), prop_name);
+  if (pos == col_names.cend()) {
+    // A stored property that was never loaded only has to leave the header
+    auto unloaded = rdg_.UnloadedEdgePropertyNames();
+    if (std::find(unloaded.begin(), unloaded.end(), prop_name) ==
+        unloaded.end()) {
+      return galois::ErrorCode::PropertyNotFound;
+    }
+    return rdg_.RemoveUnloadedEdgeProperty(prop_name);
+  }
+  if (auto res =
+          rdg_.RemoveEdgeProperty(std::distance(col_names.cbegin(), pos));
+      !res) {
+    return res.error();
+  }
+  PublishSnapshot();
+  return galois::ResultSuccess();
+}
+
+std::shared_ptr<const galois::graphs::GraphSnapshot>
+galois::graphs::PropertyFileGraph::Snapshot() const {
+  if (auto snapshot = std::atomic_load(&snapshot_)) {
+    return snapshot;
+  }
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  if (!publish_snapshots_) {
+    publish_snapshots_ = true;
+    PublishSnapshot();
+  }
+  return std::atomic_load(&snapshot_);
+}
+
+void
+galois::graphs::PropertyFileGraph::PublishSnapshot() const {
+  if (!publish_snapshots_) {
+    return;
+  }
+  // Readers that hold the previous version keep it alive; it is freed when
+  // the last of them drops it
+  std::shared_ptr<const GraphSnapshot> snapshot =
+      std::make_shared<GraphSnapshot>(GraphSnapshot{
+          .version = ++snapshot_version_,
+          .topology = topology(),
+          .node_table = rdg_.node_table(),
+          .edge_table = rdg_.edge_table(),
+      });
+  std::atomic_store(&snapshot_, std::move(snapshot));
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::DoSetTopology(
     const galois::graphs::GraphTopology& topology) {
   if (auto res = rdg_.UnbindTopologyFileStorage(); !res) {
     return res.error();
   }
+  ResetTopology(topology);
+  return galois::ResultSuccess();
+}
+
+void
+galois::graphs::PropertyFileGraph::ResetTopology(
+    const galois::graphs::GraphTopology& topology) {
   topology_ = topology;
+  ++topology_version_;
+  compressed_topology_.reset();
+  // as ClearDerivedTopologies, which takes rdg_mutex_ itself
+  transpose_.reset();
+  edge_type_topology_.reset();
+  rdg_.ClearTopologyArrays();
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::SetTopology(
+    const galois::graphs::GraphTopology& topology) {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  if (auto res = DoSetTopology(topology); !res) {
+    return res.error();
+  }
+  PublishSnapshot();
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::ReplaceTopologyAndProperties(
+    const galois::graphs::GraphTopology& topology,
+    const std::shared_ptr<arrow::Table>& node_table,
+    const std::shared_ptr<arrow::Table>& edge_table) {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  if (!rdg_.UnloadedNodePropertyNames().empty() ||
+      !rdg_.UnloadedEdgePropertyNames().empty()) {
+    GALOIS_LOG_DEBUG("some properties are not loaded and would not change");
+    return ErrorCode::InvalidArgument;
+  }
+  // Check everything before changing anything
+  if (!node_table->schema()->Equals(*rdg_.node_table()->schema()) ||
+      !edge_table->schema()->Equals(*rdg_.edge_table()->schema())) {
+    GALOIS_LOG_DEBUG("replacement schemas do not match the graph");
+    return ErrorCode::InvalidArgument;
+  }
+  if ((node_table->num_columns() > 0 &&
+       static_cast<uint64_t>(node_table->num_rows()) !=
+           topology.num_nodes()) ||
+      (edge_table->num_columns() > 0 &&
+       static_cast<uint64_t>(edge_table->num_rows()) !=
+           topology.num_edges())) {
+    GALOIS_LOG_DEBUG(
+        "expected {} node and {} edge rows found {} and {} instead",
+        topology.num_nodes(), topology.num_edges(), node_table->num_rows(),
+        edge_table->num_rows());
+    return ErrorCode::InvalidArgument;
+  }
 
+  // Whatever can fail happens in ReplaceProperties before it changes
+  // anything
+  if (auto res = rdg_.ReplaceProperties(node_table, edge_table, true); !res) {
+    return res.error();
+  }
+  ResetTopology(topology);
+  PublishSnapshot();
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::BuildTransposeTopology() {
+  auto transpose_result = MakeTranspose(topology());
+  if (!transpose_result) {
+    return transpose_result.error();
+  }
+  std::shared_ptr<TransposeTopology> transpose =
+      std::move(transpose_result.value());
+
+  std::pair<const char*, std::shared_ptr<arrow::Array>> arrays[] = {
+      {kTransposeInIndicesName, transpose->topology.out_indices},
+      {kTransposeInSourcesName, transpose->topology.out_dests},
+      {kTransposeEdgeIdsName, transpose->edge_ids},
+  };
+
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  for (const auto& [name, array] : arrays) {
+    if (auto res = rdg_.SetTopologyArray(
+            name,
+            std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{array}));
+        !res) {
+      return res.error();
+    }
+  }
+  transpose_ = std::move(transpose);
   return galois::ResultSuccess();
 }
 
+galois::Result<std::shared_ptr<const galois::graphs::TransposeTopology>>
+galois::graphs::PropertyFileGraph::GetTransposeTopology() const {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  if (transpose_) {
+    return transpose_;
+  }
+  if (!rdg_.HasTopologyArray(kTransposeInIndicesName)) {
+    return ErrorCode::PropertyNotFound;
+  }
+
+  auto in_indices_result = rdg_.LoadTopologyArray(kTransposeInIndicesName);
+  if (!in_indices_result) {
+    return in_indices_result.error();
+  }
+  auto in_sources_result = rdg_.LoadTopologyArray(kTransposeInSourcesName);
+  if (!in_sources_result) {
+    return in_sources_result.error();
+  }
+  auto edge_ids_result = rdg_.LoadTopologyArray(kTransposeEdgeIdsName);
+  if (!edge_ids_result) {
+    return edge_ids_result.error();
+  }
+
+  uint64_t num_nodes = topology_.num_nodes();
+  uint64_t num_edges = in_sources_result.value()->length();
+  auto in_indices = UnchunkTopologyArray<arrow::UInt64Array>(
+      in_indices_result.value(), num_nodes);
+  if (!in_indices) {
+    return in_indices.error();
+  }
+  auto in_sources = UnchunkTopologyArray<arrow::UInt32Array>(
+      in_sources_result.value(), num_edges);
+  if (!in_sources) {
+    return in_sources.error();
+  }
+  auto edge_ids = UnchunkTopologyArray<arrow::UInt64Array>(
+      edge_ids_result.value(), num_edges);
+  if (!edge_ids) {
+    return edge_ids.error();
+  }
+  if (num_nodes > 0 && in_indices.value()->Value(num_nodes - 1) != num_edges) {
+    GALOIS_LOG_DEBUG("transpose in indices do not match number of edges");
+    return ErrorCode::InvalidArgument;
+  }
+
+  transpose_ = std::make_shared<TransposeTopology>(TransposeTopology{
+      .topology =
+          GraphTopology{
+              .out_indices = std::move(in_indices.value()),
+              .out_dests = std::move(in_sources.value()),
+          },
+      .edge_ids = std::move(edge_ids.value()),
+  });
+  return transpose_;
+}
+
+galois::Result<void>
+galois::graphs::PropertyFileGraph::BuildEdgeTypeTopology(
+    const std::vector<std::string>& types) {
+  if (types.empty() || types.size() > std::numeric_limits<uint32_t>::max()) {
+    GALOIS_LOG_DEBUG("expected between 1 and 2^32 - 1 types");
+    return ErrorCode::InvalidArgument;
+  }
+
+  std::vector<std::shared_ptr<arrow::BooleanArray>> type_arrays;
+  for (const std::string& name : types) {
+    auto property = EdgeProperty(name);
+    if (!property) {
+      GALOIS_LOG_DEBUG("no edge property {}", name);
+      return ErrorCode::PropertyNotFound;
+    }
+    auto typed = UnchunkProperty<bool>(property);
+    if (!typed) {
+      GALOIS_LOG_DEBUG("edge type {} is not a boolean property", name);
+      return typed.error();
+    }
+    type_arrays.emplace_back(std::move(typed.value()));
+  }
+
+  auto type_topology_result =
+      MakeEdgeTypeTopology(topology(), types, type_arrays);
+  if (!type_topology_result) {
+    return type_topology_result.error();
+  }
+  std::shared_ptr<EdgeTypeTopology> type_topology =
+      std::move(type_topology_result.value());
+
+  arrow::StringBuilder names_builder;
+  if (auto status = names_builder.AppendValues(types); !status.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", status);
+    return ErrorCode::ArrowError;
+  }
+  std::shared_ptr<arrow::Array> names;
+  if (auto status = names_builder.Finish(&names); !status.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", status);
+    return ErrorCode::ArrowError;
+  }
+
+  std::pair<const char*, std::shared_ptr<arrow::Array>> arrays[] = {
+      {kEdgeTypeNamesName, names},
+      {kEdgeTypeIndicesName, type_topology->type_indices},
+      {kEdgeTypeDestsName, type_topology->dests},
+      {kEdgeTypeEdgeIdsName, type_topology->edge_ids},
+  };
+
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  for (const auto& [name, array] : arrays) {
+    if (auto res = rdg_.SetTopologyArray(
+            name,
+            std::make_shared<arrow::ChunkedArray>(arrow::ArrayVector{array}));
+        !res) {
+      return res.error();
+    }
+  }
+  edge_type_topology_ = std::move(type_topology);
+  return galois::ResultSuccess();
+}
+
+galois::Result<std::shared_ptr<const galois::graphs::EdgeTypeTopology>>
+galois::graphs::PropertyFileGraph::GetEdgeTypeTopology() const {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  if (edge_type_topology_) {
+    return edge_type_topology_;
+  }
+  if (!rdg_.HasTopologyArray(kEdgeTypeIndicesName)) {
+    return ErrorCode::PropertyNotFound;
+  }
+
+  auto names_result = rdg_.LoadTopologyArray(kEdgeTypeNamesName);
+  if (!names_result) {
+    return names_result.error();
+  }
+  auto indices_result = rdg_.LoadTopologyArray(kEdgeTypeIndicesName);
+  if (!indices_result) {
+    return indices_result.error();
+  }
+  auto dests_result = rdg_.LoadTopologyArray(kEdgeTypeDestsName);
+  if (!dests_result) {
+    return dests_result.error();
+  }
+  auto edge_ids_result = rdg_.LoadTopologyArray(kEdgeTypeEdgeIdsName);
+  if (!edge_ids_result) {
+    return edge_ids_result.error();
+  }
+
+  auto names = UnchunkTopologyArray<arrow::StringArray>(
+      names_result.value(), names_result.value()->length());
+  if (!names) {
+    return names.error();
+  }
+  std::vector<std::string> type_names;
+  for (int64_t i = 0, n = names.value()->length(); i < n; ++i) {
+    type_names.emplace_back(names.value()->GetString(i));
+  }
+
+  uint64_t num_groups = topology_.num_nodes() * type_names.size();
+  uint64_t num_typed_edges = dests_result.value()->length();
+  auto type_indices = UnchunkTopologyArray<arrow::UInt64Array>(
+      indices_result.value(), num_groups);
+  if (!type_indices) {
+    return type_indices.error();
+  }
+  auto dests = UnchunkTopologyArray<arrow::UInt32Array>(
+      dests_result.value(), num_typed_edges);
+  if (!dests) {
+    return dests.error();
+  }
+  auto edge_ids = UnchunkTopologyArray<arrow::UInt64Array>(
+      edge_ids_result.value(), num_typed_edges);
+  if (!edge_ids) {
+    return edge_ids.error();
+  }
+  if (num_groups > 0 &&
+      type_indices.value()->Value(num_groups - 1) != num_typed_edges) {
+    GALOIS_LOG_DEBUG("edge type indices do not match number of edges");
+    return ErrorCode::InvalidArgument;
+  }
+
+  edge_type_topology_ = std::make_shared<EdgeTypeTopology>(EdgeTypeTopology{
+      .type_names = std::move(type_names),
+      .type_indices = std::move(type_indices.value()),
+      .dests = std::move(dests.value()),
+      .edge_ids = std::move(edge_ids.value()),
+  });
+  return edge_type_topology_;
+}
+
+void
+galois::graphs::PropertyFileGraph::ClearDerivedTopologies() {
+  std::lock_guard<std::mutex> lock(rdg_mutex_);
+  transpose_.reset();
+  edge_type_topology_.reset();
+  rdg_.ClearTopologyArrays();
+}
+
+galois::Result<std::shared_ptr<arrow::Buffer>>
+galois::graphs::AllocateTopologyBuffer(uint64_t size) {
+  auto alloc_result = arrow::AllocateBuffer(size);
+  if (!alloc_result.ok()) {
+    return tsuba::ArrowToTsuba(alloc_result.status().code());
+  }
+  return std::shared_ptr<arrow::Buffer>(std::move(alloc_result.ValueOrDie()));
+}
+
 galois::Result<std::vector<uint64_t>>
 galois::graphs::SortAllEdgesByDest(galois::graphs::PropertyFileGraph* pfg) {
   auto view_result_dests =
@@ -345,6 +1551,7 @@ galois::graphs::SortAllEdgesByDest(galois::graphs::PropertyFileGraph* pfg) {
       },
       galois::steal());
 
+  pfg->ClearDerivedTopologies();
   return permutation_vec;
 }
 
@@ -462,5 +1669,6 @@ galois::graphs::SortNodesByDegree(galois::graphs::PropertyFileGraph* pfg) {
         out_dests_view[edge_id] = new_out_dest[edge_id];
       });
 
+  pfg->ClearDerivedTopologies();
   return galois::ResultSuccess();
 }
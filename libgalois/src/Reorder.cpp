@@ -0,0 +1,363 @@
+#include "galois/graphs/Reorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <queue>
+#include <utility>
+
+#include <arrow/compute/api.h>
+
+#include "galois/Logging.h"
+#include "galois/Loops.h"
+#include "galois/ParallelSTL.h"
+
+namespace {
+
+using galois::graphs::GraphTopology;
+
+uint64_t
+Degree(const GraphTopology& topology, uint32_t node) {
+  auto [begin, end] = topology.edge_range(node);
+  return end - begin;
+}
+
+/// Sort nodes by decreasing (or increasing) degree in parallel; nodes of the
+/// same degree keep their relative order
+void
+SortByDegree(
+    const GraphTopology& topology, std::vector<uint32_t>* nodes,
+    bool decreasing) {
+  galois::ParallelSTL::sort(
+      nodes->begin(), nodes->end(), [&](uint32_t a, uint32_t b) {
+        uint64_t degree_a = Degree(topology, a);
+        uint64_t degree_b = Degree(topology, b);
+        if (degree_a != degree_b) {
+          return decreasing ? degree_a > degree_b : degree_a < degree_b;
+        }
+        return a < b;
+      });
+}
+
+std::vector<uint32_t>
+AllNodes(const GraphTopology& topology) {
+  std::vector<uint32_t> nodes(topology.num_nodes());
+  galois::do_all(
+      galois::iterate(uint64_t{0}, topology.num_nodes()),
+      [&](uint64_t n) { nodes[n] = n; });
+  return nodes;
+}
+
+/// The nodes in order of decreasing degree
+std::vector<uint32_t>
+DegreeOrder(const GraphTopology& topology) {
+  std::vector<uint32_t> nodes = AllNodes(topology);
+  SortByDegree(topology, &nodes, true);
+  return nodes;
+}
+
+/// Hubs, possibly sorted by decreasing degree, followed by the other nodes in
+/// their original order
+std::vector<uint32_t>
+HubOrder(const GraphTopology& topology, bool sort_hubs) {
+  uint64_t num_nodes = topology.num_nodes();
+  if (num_nodes == 0) {
+    return {};
+  }
+  double average_degree = static_cast<double>(topology.num_edges()) /
+                          static_cast<double>(num_nodes);
+
+  std::vector<uint32_t> hubs;
+  std::vector<uint32_t> rest;
+  for (uint64_t n = 0; n < num_nodes; ++n) {
+    if (static_cast<double>(Degree(topology, n)) > average_degree) {
+      hubs.push_back(n);
+    } else {
+      rest.push_back(n);
+    }
+  }
+  if (sort_hubs) {
+    SortByDegree(topology, &hubs, true);
+  }
+  hubs.insert(hubs.end(), rest.begin(), rest.end());
+  return hubs;
+}
+
+/// Visit nodes breadth first from each of roots in turn, skipping roots that
+/// were already visited. If by_degree, the newly visited neighbors of a node
+/// are queued by increasing degree.
+std::vector<uint32_t>
+TraversalOrder(
+    const GraphTopology& topology, const std::vector<uint32_t>& roots,
+    bool by_degree) {
+  std::vector<uint32_t> order;
+  order.reserve(topology.num_nodes());
+  std::vector<bool> visited(topology.num_nodes(), false);
+  std::vector<uint32_t> neighbors;
+
+  for (uint32_t root : roots) {
+    if (visited[root]) {
+      continue;
+    }
+    visited[root] = true;
+    // order doubles as the queue
+    size_t head = order.size();
+    order.push_back(root);
+    for (; head < order.size(); ++head) {
+      auto [begin, end] = topology.edge_range(order[head]);
+      neighbors.clear();
+      for (uint64_t e = begin; e < end; ++e) {
+        uint32_t dest = topology.out_dests->Value(e);
+        if (!visited[dest]) {
+          visited[dest] = true;
+          neighbors.push_back(dest);
+        }
+      }
+      if (by_degree) {
+        std::stable_sort(
+            neighbors.begin(), neighbors.end(), [&](uint32_t a, uint32_t b) {
+              return Degree(topology, a) < Degree(topology, b);
+            });
+      }
+      order.insert(order.end(), neighbors.begin(), neighbors.end());
+    }
+  }
+  return order;
+}
+
+std::vector<uint32_t>
+RCMOrder(const GraphTopology& topology) {
+  std::vector<uint32_t> roots = AllNodes(topology);
+  SortByDegree(topology, &roots, false);
+  std::vector<uint32_t> order = TraversalOrder(topology, roots, true);
+  std::reverse(order.begin(), order.end());
+  return order;
+}
+
+/// Greedily place the node with the highest score, where the score of a node
+/// counts its edges from, and its paths of length two from, the last
+/// kGorderWindow placed nodes. On a symmetric graph the paths are common
+/// neighbors. Paths through nodes of degree above sqrt(num_nodes) are not
+/// counted. When no unplaced node has a positive score, the unplaced node of
+/// highest degree is next.
+std::vector<uint32_t>
+GorderLiteOrder(const GraphTopology& topology) {
+  uint64_t num_nodes = topology.num_nodes();
+  auto hub_degree = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::sqrt(static_cast<double>(num_nodes))));
+  std::vector<uint32_t> by_degree = DegreeOrder(topology);
+
+  std::vector<int64_t> score(num_nodes, 0);
+  std::vector<bool> placed(num_nodes, false);
+  // Entries are not removed when a score changes; an entry whose score is
+  // not the current score of its node is stale and skipped
+  using Entry = std::pair<int64_t, uint32_t>;
+  std::priority_queue<Entry> queue;
+
+  auto add_score = [&](uint32_t node, int64_t delta) {
+    if (placed[node]) {
+      return;
+    }
+    score[node] += delta;
+    if (score[node] > 0) {
+      queue.emplace(score[node], node);
+    }
+  };
+  auto update = [&](uint32_t node, int64_t delta) {
+    auto [begin, end] = topology.edge_range(node);
+    for (uint64_t e = begin; e < end; ++e) {
+      uint32_t neighbor = topology.out_dests->Value(e);
+      add_score(neighbor, delta);
+      if (Degree(topology, neighbor) > hub_degree) {
+        continue;
+      }
+      auto [n_begin, n_end] = topology.edge_range(neighbor);
+      for (uint64_t ne = n_begin; ne < n_end; ++ne) {
+        add_score(topology.out_dests->Value(ne), delta);
+      }
+    }
+  };
+
+  std::vector<uint32_t> order;
+  order.reserve(num_nodes);
+  size_t next_by_degree = 0;
+  while (order.size() < num_nodes) {
+    std::optional<uint32_t> next;
+    while (!queue.empty() && !next) {
+      auto [node_score, node] = queue.top();
+      queue.pop();
+      if (!placed[node] && node_score == score[node]) {
+        next = node;
+      }
+    }
+    if (!next) {
+      while (placed[by_degree[next_by_degree]]) {
+        ++next_by_degree;
+      }
+      next = by_degree[next_by_degree];
+    }
+
+    placed[*next] = true;
+    order.push_back(*next);
+    update(*next, 1);
+    if (order.size() > galois::graphs::kGorderWindow) {
+      update(order[order.size() - 1 - galois::graphs::kGorderWindow], -1);
+    }
+  }
+  return order;
+}
+
+/// Return the rows of table in the order given by indices
+galois::Result<std::shared_ptr<arrow::Table>>
+TakeRows(
+    const std::shared_ptr<arrow::Table>& table,
+    const std::shared_ptr<arrow::Array>& indices) {
+  if (table->num_columns() == 0) {
+    return table;
+  }
+  auto take_result =
+      arrow::compute::Take(arrow::Datum(table), arrow::Datum(indices));
+  if (!take_result.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", take_result.status());
+    return galois::ErrorCode::ArrowError;
+  }
+  return take_result.ValueOrDie().table();
+}
+
+}  // namespace
+
+galois::Result<std::vector<uint32_t>>
+galois::graphs::ComputeNodeOrder(
+    const GraphTopology& topology, ReorderPolicy policy) {
+  std::vector<uint32_t> order;
+  switch (policy) {
+  case ReorderPolicy::Degree:
+    order = DegreeOrder(topology);
+    break;
+  case ReorderPolicy::HubSort:
+    order = HubOrder(topology, true);
+    break;
+  case ReorderPolicy::HubCluster:
+    order = HubOrder(topology, false);
+    break;
+  case ReorderPolicy::BFS:
+    order = TraversalOrder(topology, DegreeOrder(topology), false);
+    break;
+  case ReorderPolicy::RCM:
+    order = RCMOrder(topology);
+    break;
+  case ReorderPolicy::GorderLite:
+    order = GorderLiteOrder(topology);
+    break;
+  default:
+    GALOIS_LOG_DEBUG("unknown reorder policy {}", static_cast<int>(policy));
+    return ErrorCode::InvalidArgument;
+  }
+
+  // order lists nodes by new id; invert it
+  std::vector<uint32_t> old_to_new(order.size());
+  galois::do_all(galois::iterate(uint64_t{0}, order.size()), [&](uint64_t i) {
+    old_to_new[order[i]] = i;
+  });
+  return old_to_new;
+}
+
+galois::Result<void>
+galois::graphs::PermuteNodes(
+    PropertyFileGraph* pfg, const std::vector<uint32_t>& old_to_new) {
+  if (auto res = pfg->EnsureAllPropertiesLoaded(); !res) {
+    return res.error();
+  }
+  const GraphTopology& topology = pfg->topology();
+  uint64_t num_nodes = topology.num_nodes();
+  uint64_t num_edges = topology.num_edges();
+
+  if (old_to_new.size() != num_nodes) {
+    GALOIS_LOG_DEBUG(
+        "expected {} new node ids found {}", num_nodes, old_to_new.size());
+    return ErrorCode::InvalidArgument;
+  }
+  std::vector<uint32_t> new_to_old(num_nodes);
+  std::vector<bool> seen(num_nodes, false);
+  for (uint64_t n = 0; n < num_nodes; ++n) {
+    uint32_t m = old_to_new[n];
+    if (m >= num_nodes || seen[m]) {
+      GALOIS_LOG_DEBUG("new node id {} is out of range or repeated", m);
+      return ErrorCode::InvalidArgument;
+    }
+    seen[m] = true;
+    new_to_old[m] = n;
+  }
+
+  auto indices_result = AllocateTopologyBuffer(num_nodes * sizeof(uint64_t));
+  if (!indices_result) {
+    return indices_result.error();
+  }
+  auto dests_result = AllocateTopologyBuffer(num_edges * sizeof(uint32_t));
+  if (!dests_result) {
+    return dests_result.error();
+  }
+  auto edge_ids_result = AllocateTopologyBuffer(num_edges * sizeof(uint64_t));
+  if (!edge_ids_result) {
+    return edge_ids_result.error();
+  }
+  auto* out_indices =
+      reinterpret_cast<uint64_t*>(indices_result.value()->mutable_data());
+  auto* out_dests =
+      reinterpret_cast<uint32_t*>(dests_result.value()->mutable_data());
+  auto* edge_ids =
+      reinterpret_cast<uint64_t*>(edge_ids_result.value()->mutable_data());
+
+  galois::do_all(galois::iterate(uint64_t{0}, num_nodes), [&](uint64_t m) {
+    out_indices[m] = Degree(topology, new_to_old[m]);
+  });
+  galois::ParallelSTL::partial_sum(
+      out_indices, out_indices + num_nodes, out_indices);
+
+  // edge_ids[e] is the old edge, and edge table row, of new edge e
+  galois::do_all(
+      galois::iterate(uint64_t{0}, num_nodes),
+      [&](uint64_t m) {
+        uint64_t slot = m > 0 ? out_indices[m - 1] : 0;
+        auto [begin, end] = topology.edge_range(new_to_old[m]);
+        for (uint64_t e = begin; e < end; ++e, ++slot) {
+          out_dests[slot] = old_to_new[topology.out_dests->Value(e)];
+          edge_ids[slot] = e;
+        }
+      },
+      galois::steal());
+
+  auto node_table_result = TakeRows(
+      pfg->node_table(), std::make_shared<arrow::UInt32Array>(
+                             num_nodes, arrow::Buffer::Wrap(new_to_old)));
+  if (!node_table_result) {
+    return node_table_result.error();
+  }
+  auto edge_table_result = TakeRows(
+      pfg->edge_table(),
+      std::make_shared<arrow::UInt64Array>(num_edges, edge_ids_result.value()));
+  if (!edge_table_result) {
+    return edge_table_result.error();
+  }
+
+  return pfg->ReplaceTopologyAndProperties(
+      GraphTopology{
+          .out_indices = std::make_shared<arrow::UInt64Array>(
+              num_nodes, indices_result.value()),
+          .out_dests = std::make_shared<arrow::UInt32Array>(
+              num_edges, dests_result.value()),
+      },
+      node_table_result.value(), edge_table_result.value());
+}
+
+galois::Result<std::vector<uint32_t>>
+galois::graphs::ReorderNodes(PropertyFileGraph* pfg, ReorderPolicy policy) {
+  auto order_result = ComputeNodeOrder(pfg->topology(), policy);
+  if (!order_result) {
+    return order_result.error();
+  }
+  if (auto res = PermuteNodes(pfg, order_result.value()); !res) {
+    return res.error();
+  }
+  return order_result;
+}
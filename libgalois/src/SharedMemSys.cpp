@@ -24,6 +24,7 @@
 #include "galois/Statistics.h"
 #include "galois/substrate/SharedMem.h"
 #include "tsuba/FileStorage.h"
+#include "tsuba/Stats.h"
 #include "tsuba/tsuba.h"
 
 namespace {
@@ -46,6 +47,14 @@ galois::SharedMemSys::SharedMemSys() : impl_(std::make_unique<Impl>()) {
 }
 
 galois::SharedMemSys::~SharedMemSys() {
+  // tsuba cannot report to the stat manager itself
+  tsuba::ForEachStat(
+      [](const std::string& name, int64_t value) {
+        galois::ReportStatSingle("tsuba", name, value);
+      },
+      [](const std::string& name, double value) {
+        galois::ReportStatSingle("tsuba", name, value);
+      });
   galois::PrintStats();
   galois::internal::setSysStatManager(nullptr);
 
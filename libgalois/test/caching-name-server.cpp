@@ -0,0 +1,173 @@
+/// Check the cache that tsuba puts in front of the name server when
+/// TSUBA_NS_CACHE_TTL_MS is set.
+
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include "TestPropertyGraph.h"
+#include "galois/Logging.h"
+#include "galois/SharedMemSys.h"
+#include "galois/Uri.h"
+#include "galois/graphs/PropertyFileGraph.h"
+#include "tsuba/Stats.h"
+#include "tsuba/tsuba.h"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+constexpr int kTtlMs = 1000;
+constexpr size_t kNumNodes = 10;
+using ValueType = uint64_t;
+
+std::string command_line;
+
+int64_t
+IntStat(const std::string& name) {
+  int64_t value = 0;
+  tsuba::ForEachStat(
+      [&](const std::string& n, int64_t v) {
+        if (n == name) {
+          value = v;
+        }
+      },
+      [](const std::string&, double) {});
+  return value;
+}
+
+std::shared_ptr<arrow::Table>
+MakeTable(const std::string& name, size_t size) {
+  galois::TableBuilder builder{size};
+
+  galois::ColumnOptions options;
+  options.name = name;
+  options.ascending_values = true;
+  builder.AddColumn<ValueType>(options);
+  return builder.Finish();
+}
+
+std::string
+WriteGraph() {
+  LinePolicy policy{1};
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      MakeFileGraph<ValueType>(kNumNodes, 1, &policy);
+  g->MarkAllPropertiesPersistent();
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/caching-name-server");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+
+  if (auto res = g->Write(rdg_dir, command_line); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", res.error());
+  }
+  return rdg_dir;
+}
+
+std::unique_ptr<galois::graphs::PropertyFileGraph>
+Load(const std::string& rdg_dir) {
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  if (!make_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  return std::move(make_result.value());
+}
+
+void
+TestHit() {
+  std::string rdg_dir = WriteGraph();
+
+  Load(rdg_dir);
+  int64_t hits = IntStat("NameServerCacheHits");
+  int64_t misses = IntStat("NameServerCacheMisses");
+
+  // reopening does not ask the name server again
+  Load(rdg_dir);
+  fs::remove_all(rdg_dir);
+  GALOIS_LOG_ASSERT(IntStat("NameServerCacheHits") > hits);
+  GALOIS_LOG_ASSERT(IntStat("NameServerCacheMisses") == misses);
+}
+
+void
+TestExpiry() {
+  std::string rdg_dir = WriteGraph();
+
+  Load(rdg_dir);
+  int64_t misses = IntStat("NameServerCacheMisses");
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(2 * kTtlMs));
+  Load(rdg_dir);
+  fs::remove_all(rdg_dir);
+  GALOIS_LOG_ASSERT(IntStat("NameServerCacheMisses") > misses);
+}
+
+void
+TestCommitVisible() {
+  std::string rdg_dir = WriteGraph();
+
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g = Load(rdg_dir);
+  GALOIS_LOG_ASSERT(g->AddNodeProperties(MakeTable("committed-a", kNumNodes)));
+  g->MarkAllPropertiesPersistent();
+  if (auto res = g->Commit(command_line); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("commit: {}", res.error());
+  }
+  g.reset();
+
+  // the new version is cached by the commit, not found by asking again
+  int64_t misses = IntStat("NameServerCacheMisses");
+  std::unique_ptr<galois::graphs::PropertyFileGraph> reloaded = Load(rdg_dir);
+  fs::remove_all(rdg_dir);
+  GALOIS_LOG_ASSERT(IntStat("NameServerCacheMisses") == misses);
+  GALOIS_LOG_ASSERT(reloaded->NodePropertyTyped<ValueType>("committed-a"));
+}
+
+void
+TestForget() {
+  std::string rdg_dir = WriteGraph();
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g = Load(rdg_dir);
+  GALOIS_LOG_ASSERT(g->AddNodeProperties(MakeTable("forgotten-a", kNumNodes)));
+  g->MarkAllPropertiesPersistent();
+  if (auto res = g->Commit(command_line); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("commit: {}", res.error());
+  }
+  g.reset();
+
+  // forgetting drops the cached version, so the name is registered again
+  // from what is in storage
+  GALOIS_LOG_ASSERT(tsuba::Forget(rdg_dir));
+  std::unique_ptr<galois::graphs::PropertyFileGraph> reloaded = Load(rdg_dir);
+  fs::remove_all(rdg_dir);
+  GALOIS_LOG_ASSERT(reloaded->NodePropertyTyped<ValueType>("forgotten-a"));
+}
+
+}  // namespace
+
+int
+main(int argc, char** argv) {
+  // tsuba reads this when it starts
+  setenv("TSUBA_NS_CACHE_TTL_MS", std::to_string(kTtlMs).c_str(), 1);
+
+  galois::SharedMemSys sys;
+
+  std::ostringstream cmdout;
+  for (int i = 0; i < argc; ++i) {
+    cmdout << argv[i];
+    if (i != argc - 1)
+      cmdout << " ";
+  }
+  command_line = cmdout.str();
+
+  TestHit();
+  TestExpiry();
+  TestCommitVisible();
+  TestForget();
+  return 0;
+}
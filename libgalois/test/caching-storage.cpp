@@ -0,0 +1,252 @@
+/// Check the local cache that tsuba puts in front of remote storage when
+/// TSUBA_CACHE_DIR is set. The sim:// storage stands in for remote storage.
+
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "galois/Logging.h"
+#include "galois/SharedMemSys.h"
+#include "galois/Uri.h"
+#include "tsuba/Stats.h"
+#include "tsuba/file.h"
+#include "tsuba/tsuba.h"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+// Same as CachingStorage::kCacheBlockSize
+constexpr uint64_t kBlockSize = UINT64_C(4) << 20;
+// Room for two blocks and their headers
+constexpr int kCacheMB = 9;
+
+std::string cache_dir;
+
+int64_t
+IntStat(const std::string& name) {
+  int64_t value = 0;
+  tsuba::ForEachStat(
+      [&](const std::string& n, int64_t v) {
+        if (n == name) {
+          value = v;
+        }
+      },
+      [](const std::string&, double) {});
+  return value;
+}
+
+std::vector<uint8_t>
+MakeData(uint64_t size, uint8_t seed) {
+  std::vector<uint8_t> data(size);
+  for (uint64_t i = 0; i < size; ++i) {
+    data[i] = static_cast<uint8_t>(i * 31 + seed);
+  }
+  return data;
+}
+
+void
+Store(const std::string& uri, const std::vector<uint8_t>& data) {
+  auto res = tsuba::FileStore(uri, data.data(), data.size());
+  GALOIS_LOG_VASSERT(res, "storing {}: {}", uri, res.error());
+}
+
+std::vector<uint8_t>
+Get(const std::string& uri, uint64_t start, uint64_t size) {
+  std::vector<uint8_t> buf(size);
+  auto res = tsuba::FileGet(uri, buf.data(), start, size);
+  GALOIS_LOG_VASSERT(res, "reading {}: {}", uri, res.error());
+  return buf;
+}
+
+/// Simulate a new process by starting tsuba again, which rebuilds the cache
+/// index from cache_dir
+void
+Restart() {
+  GALOIS_LOG_ASSERT(tsuba::Fini());
+  GALOIS_LOG_ASSERT(tsuba::Init());
+}
+
+uint64_t
+CachedBytes() {
+  uint64_t total = 0;
+  for (const fs::directory_entry& entry : fs::directory_iterator(cache_dir)) {
+    total += fs::file_size(entry.path());
+  }
+  return total;
+}
+
+/// Return the path of the cached block file of uri
+std::string
+FindBlockFile(const std::string& uri) {
+  for (const fs::directory_entry& entry : fs::directory_iterator(cache_dir)) {
+    std::ifstream ifile(entry.path().string());
+    uint64_t uri_size = 0;
+    ifile.read(reinterpret_cast<char*>(&uri_size), sizeof(uri_size));
+    std::string found(uri_size, '\0');
+    ifile.read(found.data(), uri_size);
+    if (ifile.good() && found == uri) {
+      return entry.path().string();
+    }
+  }
+  GALOIS_LOG_FATAL("no cached block of {}", uri);
+}
+
+void
+TestHitAndMiss(const std::string& dir) {
+  std::string uri = galois::Uri::JoinPath(dir, "hit-and-miss");
+  std::vector<uint8_t> data = MakeData(kBlockSize + 100, 1);
+  Store(uri, data);
+
+  int64_t hits = IntStat("CacheHits");
+  int64_t misses = IntStat("CacheMisses");
+  GALOIS_LOG_ASSERT(Get(uri, 0, data.size()) == data);
+  GALOIS_LOG_ASSERT(IntStat("CacheMisses") == misses + 2);
+  GALOIS_LOG_ASSERT(IntStat("CacheHits") == hits);
+
+  GALOIS_LOG_ASSERT(Get(uri, 0, data.size()) == data);
+  GALOIS_LOG_ASSERT(IntStat("CacheMisses") == misses + 2);
+  GALOIS_LOG_ASSERT(IntStat("CacheHits") == hits + 2);
+
+  // a read that straddles blocks
+  std::vector<uint8_t> expected(
+      data.begin() + kBlockSize - 10, data.begin() + kBlockSize + 10);
+  GALOIS_LOG_ASSERT(Get(uri, kBlockSize - 10, 20) == expected);
+  GALOIS_LOG_ASSERT(IntStat("CacheHits") == hits + 4);
+}
+
+void
+TestForget(const std::string& dir) {
+  std::string uri = galois::Uri::JoinPath(dir, "forget");
+  std::vector<uint8_t> old_data = MakeData(100, 1);
+  std::vector<uint8_t> new_data = MakeData(100, 2);
+  Store(uri, old_data);
+  GALOIS_LOG_ASSERT(Get(uri, 0, old_data.size()) == old_data);
+
+  // storing through the cache drops the blocks of the old contents
+  Store(uri, new_data);
+  int64_t misses = IntStat("CacheMisses");
+  GALOIS_LOG_ASSERT(Get(uri, 0, new_data.size()) == new_data);
+  GALOIS_LOG_ASSERT(IntStat("CacheMisses") == misses + 1);
+}
+
+void
+TestEviction(const std::string& dir) {
+  std::string uri = galois::Uri::JoinPath(dir, "eviction");
+  std::vector<uint8_t> data = MakeData(3 * kBlockSize, 3);
+  Store(uri, data);
+
+  int64_t evicted = IntStat("CacheEvictedBytes");
+  GALOIS_LOG_ASSERT(Get(uri, 0, data.size()) == data);
+  GALOIS_LOG_ASSERT(IntStat("CacheEvictedBytes") > evicted);
+  GALOIS_LOG_ASSERT(CachedBytes() <= static_cast<uint64_t>(kCacheMB) << 20);
+
+  // the first block was least recently used, the last one is still cached
+  int64_t misses = IntStat("CacheMisses");
+  int64_t hits = IntStat("CacheHits");
+  std::vector<uint8_t> last(data.end() - 100, data.end());
+  GALOIS_LOG_ASSERT(Get(uri, data.size() - 100, 100) == last);
+  GALOIS_LOG_ASSERT(IntStat("CacheHits") == hits + 1);
+  std::vector<uint8_t> first(data.begin(), data.begin() + 100);
+  GALOIS_LOG_ASSERT(Get(uri, 0, 100) == first);
+  GALOIS_LOG_ASSERT(IntStat("CacheMisses") == misses + 1);
+}
+
+void
+TestRestart(const std::string& dir) {
+  std::string uri = galois::Uri::JoinPath(dir, "restart");
+  std::vector<uint8_t> data = MakeData(100, 4);
+  Store(uri, data);
+  GALOIS_LOG_ASSERT(Get(uri, 0, data.size()) == data);
+
+  Restart();
+
+  int64_t hits = IntStat("CacheHits");
+  GALOIS_LOG_ASSERT(Get(uri, 0, data.size()) == data);
+  GALOIS_LOG_ASSERT(IntStat("CacheHits") == hits + 1);
+}
+
+void
+TestOtherObjectIgnored(const std::string& dir) {
+  std::string uri_a = galois::Uri::JoinPath(dir, "object-a");
+  std::string uri_b = galois::Uri::JoinPath(dir, "object-b");
+  std::vector<uint8_t> data_a = MakeData(100, 5);
+  std::vector<uint8_t> data_b = MakeData(100, 6);
+  Store(uri_a, data_a);
+  Store(uri_b, data_b);
+  GALOIS_LOG_ASSERT(Get(uri_a, 0, data_a.size()) == data_a);
+  GALOIS_LOG_ASSERT(Get(uri_b, 0, data_b.size()) == data_b);
+
+  // As if the names of blocks of a and b collided: the block file named for
+  // b holds a block of a
+  std::string path_b = FindBlockFile(uri_b);
+  fs::remove(path_b);
+  fs::copy_file(FindBlockFile(uri_a), path_b);
+  Restart();
+
+  int64_t misses = IntStat("CacheMisses");
+  GALOIS_LOG_ASSERT(Get(uri_b, 0, data_b.size()) == data_b);
+  GALOIS_LOG_ASSERT(IntStat("CacheMisses") == misses + 1);
+}
+
+void
+TestReplacedObject(const std::string& dir) {
+  std::string uri = galois::Uri::JoinPath(dir, "replaced");
+  std::vector<uint8_t> old_data = MakeData(100, 7);
+  std::vector<uint8_t> new_data = MakeData(100, 8);
+  Store(uri, old_data);
+  GALOIS_LOG_ASSERT(Get(uri, 0, old_data.size()) == old_data);
+
+  // Another process replaces the object under the same name, bypassing this
+  // cache; the new contents have the same size but a later mtime
+  auto uri_res = galois::Uri::Make(uri);
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string path = uri_res.value().path();
+  std::time_t mtime = fs::last_write_time(path);
+  {
+    std::ofstream ofile(path, std::ios::binary | std::ios::trunc);
+    ofile.write(
+        reinterpret_cast<const char*>(new_data.data()), new_data.size());
+  }
+  fs::last_write_time(path, mtime + 10);
+  Restart();
+
+  int64_t misses = IntStat("CacheMisses");
+  GALOIS_LOG_ASSERT(Get(uri, 0, new_data.size()) == new_data);
+  GALOIS_LOG_ASSERT(IntStat("CacheMisses") == misses + 1);
+}
+
+}  // namespace
+
+int
+main() {
+  auto cache_res = galois::Uri::MakeRand("/tmp/caching-storage-cache");
+  GALOIS_LOG_ASSERT(cache_res);
+  cache_dir = cache_res.value().path();  // path() because local
+
+  // tsuba reads these when it starts
+  setenv("TSUBA_CACHE_DIR", cache_dir.c_str(), 1);
+  setenv("TSUBA_CACHE_MB", std::to_string(kCacheMB).c_str(), 1);
+  setenv("TSUBA_SIM_LATENCY_US", "0", 1);
+
+  galois::SharedMemSys sys;
+
+  auto dir_res = galois::Uri::MakeRand("sim:///tmp/caching-storage");
+  GALOIS_LOG_ASSERT(dir_res);
+  std::string dir = dir_res.value().string();
+
+  TestHitAndMiss(dir);
+  TestForget(dir);
+  TestEviction(dir);
+  TestRestart(dir);
+  TestOtherObjectIgnored(dir);
+  TestReplacedObject(dir);
+
+  fs::remove_all(dir_res.value().path());
+  fs::remove_all(cache_dir);
+  return 0;
+}
@@ -0,0 +1,142 @@
+/// Compare how long it takes to load a property file graph written with each
+/// available compression codec.
+///
+/// Graphs are written under a randomly named directory below the prefix given
+/// by the environment variable GALOIS_CODEC_BENCH_PREFIX (default /tmp). Point
+/// the prefix at a remote (or simulated remote) storage location to measure
+/// codecs where bandwidth rather than decoding is the bottleneck.
+
+#include <iterator>
+#include <numeric>
+#include <unordered_set>
+
+#include <arrow/util/compression.h>
+#include <benchmark/benchmark.h>
+
+#include "TestPropertyGraph.h"
+#include "galois/Env.h"
+#include "galois/Logging.h"
+#include "galois/SharedMemSys.h"
+#include "galois/Uri.h"
+#include "galois/graphs/PropertyFileGraph.h"
+#include "tsuba/file.h"
+
+namespace gg = galois::graphs;
+
+namespace {
+
+using DataType = int64_t;
+
+const arrow::Compression::type kCodecs[] = {
+    arrow::Compression::UNCOMPRESSED, arrow::Compression::SNAPPY,
+    arrow::Compression::GZIP,         arrow::Compression::BROTLI,
+    arrow::Compression::ZSTD,         arrow::Compression::LZ4_FRAME,
+};
+
+void
+MakeArguments(benchmark::internal::Benchmark* b) {
+  for (size_t c = 0; c < std::size(kCodecs); ++c) {
+    for (int i = 0; i < 2; ++i) {
+      long num_nodes = 1 << (i * 6 + 14);
+      b->Args({static_cast<long>(c), num_nodes});
+    }
+  }
+}
+
+std::string
+BenchPrefix() {
+  std::string prefix = "/tmp";
+  galois::GetEnv("GALOIS_CODEC_BENCH_PREFIX", &prefix);
+  return prefix;
+}
+
+/// Remove everything written to rdg_dir
+void
+RemoveRDG(const std::string& rdg_dir) {
+  std::vector<std::string> files;
+  if (auto res = tsuba::FileListAsync(rdg_dir, &files).get(); !res) {
+    GALOIS_LOG_WARN("listing {}: {}", rdg_dir, res.error());
+    return;
+  }
+  std::unordered_set<std::string> to_delete(files.begin(), files.end());
+  if (auto res = tsuba::FileDelete(rdg_dir, to_delete); !res) {
+    GALOIS_LOG_WARN("deleting {}: {}", rdg_dir, res.error());
+  }
+}
+
+/// Total size of the files in rdg_dir
+uint64_t
+StoredBytes(const std::string& rdg_dir) {
+  std::vector<std::string> files;
+  std::vector<uint64_t> sizes;
+  if (auto res = tsuba::FileListAsync(rdg_dir, &files, &sizes).get(); !res) {
+    GALOIS_LOG_FATAL("listing {}: {}", rdg_dir, res.error());
+  }
+  return std::accumulate(sizes.begin(), sizes.end(), uint64_t{0});
+}
+
+void
+LoadGraph(benchmark::State& state) {
+  arrow::Compression::type codec = kCodecs[state.range(0)];
+  long num_nodes = state.range(1);
+  constexpr size_t num_properties = 4;
+
+  tsuba::PropWriteOptions options;
+  options.codec = codec;
+  if (!tsuba::ValidatePropWriteOptions(options)) {
+    state.SkipWithError("codec not available");
+    return;
+  }
+  state.SetLabel(arrow::util::Codec::GetCodecAsString(codec));
+
+  RandomPolicy policy{8};
+  std::unique_ptr<gg::PropertyFileGraph> g =
+      MakeFileGraph<DataType>(num_nodes, num_properties, &policy);
+  g->MarkAllPropertiesPersistent();
+  if (auto res = g->SetPropWriteOptions(options); !res) {
+    GALOIS_LOG_FATAL("setting write options: {}", res.error());
+  }
+  if (auto res = g->SetTopologyCompression(codec); !res) {
+    GALOIS_LOG_FATAL("setting topology compression: {}", res.error());
+  }
+
+  auto uri_res = galois::Uri::MakeRand(BenchPrefix() + "/codec-bench");
+  if (!uri_res) {
+    GALOIS_LOG_FATAL("making directory name: {}", uri_res.error());
+  }
+  std::string rdg_dir = uri_res.value().string();
+
+  if (auto res = g->Write(rdg_dir, "codec-bench"); !res) {
+    RemoveRDG(rdg_dir);
+    GALOIS_LOG_FATAL("writing graph: {}", res.error());
+  }
+  uint64_t stored_bytes = StoredBytes(rdg_dir);
+
+  for (auto _ : state) {
+    auto make_result = gg::PropertyFileGraph::Make(rdg_dir);
+    if (!make_result) {
+      RemoveRDG(rdg_dir);
+      GALOIS_LOG_FATAL("loading graph: {}", make_result.error());
+    }
+    benchmark::DoNotOptimize(make_result.value()->topology().num_edges());
+  }
+
+  state.counters["StoredBytes"] = stored_bytes;
+  state.SetBytesProcessed(state.iterations() * stored_bytes);
+
+  RemoveRDG(rdg_dir);
+}
+
+BENCHMARK(LoadGraph)->Apply(MakeArguments)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+int
+main(int argc, char** argv) {
+  galois::SharedMemSys sys;
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+
+  return 0;
+}
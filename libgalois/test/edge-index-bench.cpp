@@ -0,0 +1,129 @@
+#include <benchmark/benchmark.h>
+
+#include "TestPropertyGraph.h"
+#include "galois/Logging.h"
+#include "galois/Random.h"
+#include "galois/SharedMemSys.h"
+#include "galois/graphs/EdgeIndex.h"
+#include "galois/graphs/PropertyFileGraph.h"
+
+namespace gg = galois::graphs;
+
+namespace {
+
+constexpr size_t kNumQueries = 1 << 16;
+
+void
+MakeArguments(benchmark::internal::Benchmark* b) {
+  for (long num_nodes : {1 << 14, 1 << 18}) {
+    for (long width : {16, 256}) {
+      b->Args({num_nodes, width});
+    }
+  }
+}
+
+/// MakeQueries returns source and destination pairs of which about half are
+/// edges of topology
+std::vector<std::pair<uint32_t, uint32_t>>
+MakeQueries(const gg::GraphTopology& topology) {
+  std::vector<std::pair<uint32_t, uint32_t>> queries;
+  queries.reserve(kNumQueries);
+  for (size_t i = 0; i < kNumQueries; ++i) {
+    auto src = static_cast<uint32_t>(
+        galois::RandomUniformInt(topology.num_nodes()));
+    auto [begin, end] = topology.edge_range(src);
+    uint32_t dest{};
+    if (i % 2 == 0 && begin != end) {
+      dest = topology.out_dests->Value(
+          begin + galois::RandomUniformInt(end - begin));
+    } else {
+      dest = static_cast<uint32_t>(
+          galois::RandomUniformInt(topology.num_nodes()));
+    }
+    queries.emplace_back(src, dest);
+  }
+  return queries;
+}
+
+std::unique_ptr<gg::PropertyFileGraph>
+MakeSortedGraph(benchmark::State& state) {
+  RandomPolicy policy{static_cast<size_t>(state.range(1))};
+
+  std::unique_ptr<gg::PropertyFileGraph> g =
+      MakeFileGraph<int64_t>(state.range(0), 1, &policy);
+  if (auto r = gg::SortAllEdgesByDest(g.get()); !r) {
+    GALOIS_LOG_FATAL("could not sort edges: {}", r.error());
+  }
+  return g;
+}
+
+void
+FindEdgeSortedByDest(benchmark::State& state) {
+  std::unique_ptr<gg::PropertyFileGraph> g = MakeSortedGraph(state);
+  auto queries = MakeQueries(g->topology());
+
+  for (auto _ : state) {
+    for (const auto& [src, dest] : queries) {
+      benchmark::DoNotOptimize(gg::FindEdgeSortedByDest(*g, src, dest));
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void
+FindEdgeIndexed(benchmark::State& state) {
+  std::unique_ptr<gg::PropertyFileGraph> g = MakeSortedGraph(state);
+  auto queries = MakeQueries(g->topology());
+
+  auto index_result = gg::EdgeIndex::Make(g->topology());
+  if (!index_result) {
+    GALOIS_LOG_FATAL("could not make edge index: {}", index_result.error());
+  }
+  const gg::EdgeIndex& index = index_result.value();
+
+  for (auto _ : state) {
+    for (const auto& [src, dest] : queries) {
+      benchmark::DoNotOptimize(index.FindEdge(src, dest));
+    }
+  }
+
+  state.counters["Hubs"] = index.num_hubs();
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+void
+MakeEdgeIndex(benchmark::State& state) {
+  RandomPolicy policy{static_cast<size_t>(state.range(1))};
+
+  std::unique_ptr<gg::PropertyFileGraph> g =
+      MakeFileGraph<int64_t>(state.range(0), 1, &policy);
+
+  for (auto _ : state) {
+    auto index_result = gg::EdgeIndex::Make(g->topology());
+    if (!index_result) {
+      GALOIS_LOG_FATAL("could not make edge index: {}", index_result.error());
+    }
+    benchmark::DoNotOptimize(index_result.value().num_hubs());
+  }
+
+  state.SetItemsProcessed(state.iterations() * g->topology().num_edges());
+}
+
+BENCHMARK(FindEdgeSortedByDest)->Apply(MakeArguments);
+BENCHMARK(FindEdgeIndexed)->Apply(MakeArguments);
+BENCHMARK(MakeEdgeIndex)
+    ->Apply(MakeArguments)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+int
+main(int argc, char** argv) {
+  galois::SharedMemSys sys;
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+
+  return 0;
+}
@@ -1,11 +1,28 @@
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <tuple>
+#include <vector>
+
 #include <arrow/api.h>
 #include <boost/filesystem.hpp>
+#include <parquet/file_reader.h>
 
 #include "TestPropertyGraph.h"
 #include "galois/Logging.h"
 #include "galois/SharedMemSys.h"
 #include "galois/Uri.h"
 #include "galois/graphs/PropertyFileGraph.h"
+#include "galois/graphs/Reorder.h"
+#include "tsuba/FileFrame.h"
+#include "tsuba/FileView.h"
+#include "tsuba/RDGPrefix.h"
+#include "tsuba/RDGSlice.h"
+#include "tsuba/Stats.h"
+#include "tsuba/WriteGroup.h"
+#include "tsuba/file.h"
 
 namespace fs = boost::filesystem;
 std::string command_line;
@@ -130,83 +147,1739 @@ TestRoundTrip() {
 }
 
 void
-TestGarbageMetadata() {
+TestArrowIPCRoundTrip() {
+  constexpr size_t test_length = 10;
+  using ValueType = uint64_t;
+
+  auto g = std::make_unique<galois::graphs::PropertyFileGraph>();
+
+  auto add_node_result =
+      g->AddNodeProperties(MakeTable<ValueType>("node-ipc", test_length));
+  GALOIS_LOG_ASSERT(add_node_result);
+  auto add_edge_result =
+      g->AddEdgeProperties(MakeTable<ValueType>("edge-parquet", test_length));
+  GALOIS_LOG_ASSERT(add_edge_result);
+
+  g->MarkAllPropertiesPersistent();
+
+  auto set_format_result = g->SetNodePropertyStorageFormat(
+      "node-ipc", tsuba::PropStorageFormat::ArrowIPC);
+  GALOIS_LOG_ASSERT(set_format_result);
+  GALOIS_LOG_ASSERT(!g->SetEdgePropertyStorageFormat(
+      "no-such-property", tsuba::PropStorageFormat::ArrowIPC));
+
   auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
   GALOIS_LOG_ASSERT(uri_res);
-  std::string temp_dir(uri_res.value().path());  // path because local
+  std::string rdg_dir(uri_res.value().path());  // path() because local
 
-  std::string rdg_file{temp_dir};
-  rdg_file += "/meta";
+  auto write_result = g->Write(rdg_dir, command_line);
+  if (!write_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", write_result.error());
+  }
 
-  std::ofstream out(rdg_file);
-  out << "garbage to make the file non-empty";
-  out.close();
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  fs::remove_all(rdg_dir);
+  if (!make_result) {
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g2 =
+      std::move(make_result.value());
 
-  auto no_dir_result = galois::graphs::PropertyFileGraph::Make(rdg_file);
-  fs::remove_all(temp_dir);
-  GALOIS_LOG_ASSERT(!no_dir_result.has_value());
+  auto node_res = g2->NodePropertyTyped<ValueType>("node-ipc");
+  GALOIS_LOG_ASSERT(node_res);
+  auto edge_res = g2->EdgePropertyTyped<ValueType>("edge-parquet");
+  GALOIS_LOG_ASSERT(edge_res);
+
+  std::shared_ptr<arrow::UInt64Array> node_data = node_res.value();
+  std::shared_ptr<arrow::UInt64Array> edge_data = edge_res.value();
+  GALOIS_LOG_ASSERT(static_cast<size_t>(node_data->length()) == test_length);
+
+  // zero-copy loaded properties can still be updated in place
+  GALOIS_LOG_ASSERT(node_data->data()->buffers[1]->is_mutable());
+
+  ValueType value{};
+  for (size_t i = 0; i < test_length; ++i) {
+    GALOIS_LOG_ASSERT(!node_data->IsNull(i) && node_data->Value(i) == value);
+    GALOIS_LOG_ASSERT(!edge_data->IsNull(i) && edge_data->Value(i) == value);
+    ++value;
+  }
 }
 
-std::string
-MakePFGFile(const std::string& n1name) {
+/// Overwrite the pages of row group rg of the single column Parquet file at
+/// path with garbage
+void
+CorruptRowGroup(const std::string& path, int rg) {
+  std::unique_ptr<parquet::ParquetFileReader> reader =
+      parquet::ParquetFileReader::OpenFile(path, false);
+  std::unique_ptr<parquet::ColumnChunkMetaData> col_md =
+      reader->metadata()->RowGroup(rg)->ColumnChunk(0);
+  int64_t begin = col_md->has_dictionary_page()
+                      ? col_md->dictionary_page_offset()
+                      : col_md->data_page_offset();
+  std::string garbage(col_md->total_compressed_size(), '\xff');
+  reader.reset();
+
+  std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(begin);
+  file.write(garbage.data(), garbage.size());
+  GALOIS_LOG_ASSERT(file.good());
+}
+
+void
+TestRowGroupSlices() {
   constexpr size_t test_length = 10;
-  using V0 = int32_t;
-  using V1 = uint64_t;
-  const std::string n0name = "n0";
-  const std::string e0name = "e0";
-  const std::string e1name = "e1";
+  using ValueType = uint64_t;
 
   auto g = std::make_unique<galois::graphs::PropertyFileGraph>();
 
-  std::shared_ptr<arrow::Table> node_table = MakeTable<V0>(n0name, test_length);
+  auto add_node_result =
+      g->AddNodeProperties(MakeTable<ValueType>("node-rg", test_length));
+  GALOIS_LOG_ASSERT(add_node_result);
+  auto add_edge_result =
+      g->AddEdgeProperties(MakeTable<ValueType>("edge-rg", test_length));
+  GALOIS_LOG_ASSERT(add_edge_result);
 
-  auto add_node_result = g->AddNodeProperties(node_table);
+  g->MarkAllPropertiesPersistent();
+
+  tsuba::PropWriteOptions options;
+  options.row_group_size = 4;
+  GALOIS_LOG_ASSERT(g->SetPropWriteOptions(options));
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+
+  auto write_result = g->Write(rdg_dir, command_line);
+  if (!write_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", write_result.error());
+  }
+
+  // Row groups hold rows [0, 4), [4, 8) and [8, 10). Overwrite the first
+  // one, so that reading it fails, to show that slices that do not overlap
+  // it skip it.
+  bool found = false;
+  for (const fs::directory_entry& entry : fs::directory_iterator(rdg_dir)) {
+    if (entry.path().filename().string().rfind("node-rg", 0) == 0) {
+      CorruptRowGroup(entry.path().string(), 0);
+      found = true;
+    }
+  }
+  GALOIS_LOG_ASSERT(found);
+
+  auto open_result = tsuba::Open(rdg_dir, tsuba::kReadOnly);
+  if (!open_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("opening result: {}", open_result.error());
+  }
+  tsuba::RDGFile rdg_file(open_result.value());
+
+  // node slice spans the last two row groups; edge slice is empty
+  tsuba::RDGSlice::SliceArg slice_arg{
+      .node_range = {4, 9},
+      .edge_range = {4, 4},
+      .topo_off = 0,
+      .topo_size = 0,
+  };
+  auto slice_result = tsuba::RDGSlice::Make(rdg_file, slice_arg);
+
+  // a slice that overlaps the first row group has to read it
+  tsuba::RDGSlice::SliceArg overlap_arg = slice_arg;
+  overlap_arg.node_range = {3, 9};
+  auto overlap_result = tsuba::RDGSlice::Make(rdg_file, overlap_arg);
+
+  fs::remove_all(rdg_dir);
+  if (!slice_result) {
+    GALOIS_LOG_FATAL("making slice: {}", slice_result.error());
+  }
+  GALOIS_LOG_ASSERT(!overlap_result);
+  tsuba::RDGSlice slice = std::move(slice_result.value());
+
+  GALOIS_LOG_ASSERT(slice.node_table()->num_rows() == 5);
+  GALOIS_LOG_ASSERT(slice.edge_table()->num_rows() == 0);
+
+  // one chunk per row group read
+  ValueType expected = 4;
+  for (const auto& chunk : slice.node_table()->column(0)->chunks()) {
+    auto node_data = std::static_pointer_cast<arrow::UInt64Array>(chunk);
+    for (int64_t i = 0; i < node_data->length(); ++i) {
+      GALOIS_LOG_ASSERT(
+          !node_data->IsNull(i) && node_data->Value(i) == expected);
+      ++expected;
+    }
+  }
+  GALOIS_LOG_ASSERT(expected == 9);
+}
+
+void
+TestMultiChunkProperties() {
+  constexpr size_t test_length = 10;
+  using ValueType = uint64_t;
+
+  auto g = std::make_unique<galois::graphs::PropertyFileGraph>();
+
+  auto add_node_result =
+      g->AddNodeProperties(MakeTable<ValueType>("node-mc", test_length));
   GALOIS_LOG_ASSERT(add_node_result);
+  g->MarkAllPropertiesPersistent();
 
-  auto mark_node_persistent = g->MarkNodePropertiesPersistent({n0name});
-  GALOIS_LOG_ASSERT(mark_node_persistent);
+  tsuba::PropWriteOptions options;
+  options.row_group_size = 4;
+  GALOIS_LOG_ASSERT(g->SetPropWriteOptions(options));
 
-  add_node_result = g->AddNodeProperties(MakeTable<V1>(n1name, test_length));
-  if (!add_node_result) {
-    return "";
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+
+  auto write_result = g->Write(rdg_dir, command_line);
+  if (!write_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", write_result.error());
   }
 
-  mark_node_persistent = g->MarkNodePropertiesPersistent({n1name});
-  GALOIS_LOG_ASSERT(mark_node_persistent);
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  fs::remove_all(rdg_dir);
+  if (!make_result) {
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g2 =
+      std::move(make_result.value());
 
-  std::shared_ptr<arrow::Table> edge_table = MakeTable<V0>(e0name, test_length);
+  // loading keeps one chunk per row group
+  std::shared_ptr<arrow::ChunkedArray> property = g2->NodeProperty("node-mc");
+  GALOIS_LOG_ASSERT(property);
+  GALOIS_LOG_ASSERT(property->num_chunks() == 3);
 
-  auto add_edge_result = g->AddEdgeProperties(edge_table);
-  GALOIS_LOG_ASSERT(add_edge_result);
+  auto views_result = galois::graphs::internal::MakeNodePropertyViews<
+      std::tuple<galois::UInt64Property>>(g2.get());
+  GALOIS_LOG_ASSERT(views_result);
+  auto view = std::get<0>(views_result.value());
+  GALOIS_LOG_ASSERT(view.size() == test_length);
+  for (size_t i = 0; i < test_length; ++i) {
+    GALOIS_LOG_ASSERT(view.IsValid(i) && view[i] == i);
+  }
+  // views refer to the loaded chunks rather than a copy
+  view[5] = 50;
+  auto second_chunk =
+      std::static_pointer_cast<arrow::UInt64Array>(property->chunk(1));
+  GALOIS_LOG_ASSERT(second_chunk->Value(1) == 50);
 
-  auto mark_edge_persistent = g->MarkEdgePropertiesPersistent({e0name});
-  GALOIS_LOG_ASSERT(mark_edge_persistent);
+  auto typed_result = g2->NodePropertyTyped<ValueType>("node-mc");
+  GALOIS_LOG_ASSERT(typed_result);
+  std::shared_ptr<arrow::UInt64Array> typed = typed_result.value();
+  GALOIS_LOG_ASSERT(static_cast<size_t>(typed->length()) == test_length);
+  for (size_t i = 0; i < test_length; ++i) {
+    GALOIS_LOG_ASSERT(typed->Value(i) == (i == 5 ? 50 : i));
+  }
 
-  auto unique_result = galois::Uri::MakeRand("/tmp/propertygraphtests");
-  GALOIS_LOG_ASSERT(unique_result);
-  std::string rdg_file(
-      std::move(unique_result.value().path()));  // path() for local
+  auto bad_type_result = g2->NodePropertyTyped<int32_t>("node-mc");
+  GALOIS_LOG_ASSERT(
+      !bad_type_result &&
+      bad_type_result.error() == galois::ErrorCode::TypeError);
+}
 
-  auto write_result = g->Write(rdg_file, command_line);
+void
+TestDictionaryProperties() {
+  constexpr size_t test_length = 200;
+  const std::vector<std::string> labels{"person", "movie", "place"};
 
-  GALOIS_LOG_WARN("creating temp file {}", rdg_file);
+  arrow::StringDictionaryBuilder label_builder;
+  arrow::StringBuilder plain_builder;
+  for (size_t i = 0; i < test_length; ++i) {
+    GALOIS_LOG_ASSERT(label_builder.Append(labels[i % labels.size()]).ok());
+    GALOIS_LOG_ASSERT(plain_builder.Append(labels[i % labels.size()]).ok());
+  }
+  std::shared_ptr<arrow::Array> label_array;
+  std::shared_ptr<arrow::Array> plain_array;
+  GALOIS_LOG_ASSERT(label_builder.Finish(&label_array).ok());
+  GALOIS_LOG_ASSERT(plain_builder.Finish(&plain_array).ok());
+  auto table = arrow::Table::Make(
+      arrow::schema(
+          {arrow::field("label", label_array->type()),
+           arrow::field("plain", arrow::utf8())}),
+      {label_array, plain_array});
+
+  auto g = std::make_unique<galois::graphs::PropertyFileGraph>();
+  GALOIS_LOG_ASSERT(g->AddNodeProperties(table));
+  g->MarkAllPropertiesPersistent();
+
+  tsuba::PropWriteOptions options;
+  options.row_group_size = 64;
+  GALOIS_LOG_ASSERT(g->SetPropWriteOptions(options));
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
 
+  auto write_result = g->Write(rdg_dir, command_line);
   if (!write_result) {
-    fs::remove_all(rdg_file);
+    fs::remove_all(rdg_dir);
     GALOIS_LOG_FATAL("writing result: {}", write_result.error());
   }
-  return rdg_file;
+
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  fs::remove_all(rdg_dir);
+  if (!make_result) {
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g2 =
+      std::move(make_result.value());
+
+  // Properties keep the type they were stored with: both columns are
+  // dictionary encoded in Parquet, but only the dictionary column is loaded
+  // as one
+  std::shared_ptr<arrow::ChunkedArray> label = g2->NodeProperty("label");
+  GALOIS_LOG_ASSERT(label->type()->id() == arrow::Type::DICTIONARY);
+  GALOIS_LOG_ASSERT(label->num_chunks() > 1);
+  GALOIS_LOG_ASSERT(g2->NodeProperty("plain")->type()->Equals(arrow::utf8()));
+
+  auto plain_view_result = galois::graphs::internal::MakeNodePropertyViews<
+      std::tuple<galois::StringReadOnlyProperty>>(g2.get(), {"plain"});
+  GALOIS_LOG_ASSERT(plain_view_result);
+  auto plain_view = std::get<0>(plain_view_result.value());
+  for (size_t i = 0; i < test_length; ++i) {
+    GALOIS_LOG_ASSERT(plain_view[i] == labels[i % labels.size()]);
+  }
+
+  auto views_result = galois::graphs::internal::MakeNodePropertyViews<
+      std::tuple<galois::DictionaryStringReadOnlyProperty>>(
+      g2.get(), {"label"});
+  GALOIS_LOG_ASSERT(views_result);
+  auto view = std::get<0>(views_result.value());
+  GALOIS_LOG_ASSERT(view.size() == test_length);
+  GALOIS_LOG_ASSERT(view.dictionary_size() == labels.size());
+
+  auto movie = view.FindCode("movie");
+  GALOIS_LOG_ASSERT(movie && !view.FindCode("album"));
+  for (size_t i = 0; i < test_length; ++i) {
+    GALOIS_LOG_ASSERT(view.IsValid(i));
+    GALOIS_LOG_ASSERT(view[i] == labels[i % labels.size()]);
+    // codes are the same across chunks
+    GALOIS_LOG_ASSERT((view.GetCode(i) == movie.value()) == (i % 3 == 1));
+  }
+
+  auto string_view_result = galois::graphs::internal::MakeNodePropertyViews<
+      std::tuple<galois::StringReadOnlyProperty>>(g2.get(), {"label"});
+  GALOIS_LOG_ASSERT(
+      !string_view_result &&
+      string_view_result.error() == galois::ErrorCode::TypeError);
 }
 
+/// The first few nodes have many more edges than the rest
+class SkewedPolicy : public Policy {
+public:
+  std::vector<uint32_t> GenerateNeighbors(
+      size_t node_id, size_t num_nodes) override {
+    size_t degree = node_id < 10 ? 100 : 1;
+    std::vector<uint32_t> r;
+    for (size_t i = 0; i < degree; ++i) {
+      r.emplace_back((node_id + i + 1) % num_nodes);
+    }
+    return r;
+  }
+};
+
 void
-TestSimplePGs() {
-  auto rdg_file = MakePFGFile("n0");
-  GALOIS_LOG_ASSERT(rdg_file.empty());
-  rdg_file = MakePFGFile("n1");
-  galois::Result<std::unique_ptr<galois::graphs::PropertyFileGraph>>
-      make_result = galois::graphs::PropertyFileGraph::Make(rdg_file);
-  fs::remove_all(rdg_file);
-  GALOIS_LOG_ASSERT(make_result);
+TestPlanSlices() {
+  constexpr size_t num_nodes = 1000;
+  constexpr uint32_t num_slices = 4;
+  constexpr uint64_t max_degree = 100;
+
+  SkewedPolicy policy;
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      MakeFileGraph<uint32_t>(num_nodes, 1, &policy);
+  g->MarkAllPropertiesPersistent();
+  uint64_t num_edges = g->topology().num_edges();
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+
+  if (auto res = g->Write(rdg_dir, command_line); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", res.error());
+  }
+
+  auto open_result = tsuba::Open(rdg_dir, tsuba::kReadOnly);
+  if (!open_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("opening result: {}", open_result.error());
+  }
+  // a raw handle rather than an RDGFile so that it is closed before rdg_dir
+  // is removed
+  tsuba::RDGHandle handle = open_result.value();
+
+  auto prefix_result = tsuba::RDGPrefix::Make(handle);
+  if (!prefix_result) {
+    GALOIS_LOG_ASSERT(tsuba::Close(handle));
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("making prefix: {}", prefix_result.error());
+  }
+  tsuba::RDGPrefix prefix = std::move(prefix_result.value());
+
+  auto check_plan = [&](const tsuba::SliceWeights& weights) {
+    auto plan_result = prefix.PlanSlices(num_slices, weights);
+    GALOIS_LOG_ASSERT(plan_result);
+    const std::vector<tsuba::RDGSlice::SliceArg>& plan = plan_result.value();
+    GALOIS_LOG_ASSERT(plan.size() == num_slices);
+
+    double total = weights.node_weight * num_nodes +
+                   weights.edge_weight * static_cast<double>(num_edges);
+    double max_node = weights.node_weight + weights.edge_weight * max_degree;
+    uint64_t next_node = 0;
+    for (const tsuba::RDGSlice::SliceArg& slice : plan) {
+      auto [first, last] = slice.node_range;
+      GALOIS_LOG_ASSERT(first == next_node && first <= last);
+      next_node = last;
+
+      auto first_edges = g->topology().edge_range(first).first;
+      auto last_edges = last == num_nodes
+                            ? num_edges
+                            : g->topology().edge_range(last).first;
+      GALOIS_LOG_ASSERT(
+          slice.edge_range.first == first_edges &&
+          slice.edge_range.second == last_edges);
+
+      double weight = weights.node_weight * (last - first) +
+                      weights.edge_weight * (last_edges - first_edges);
+      GALOIS_LOG_ASSERT(weight <= total / num_slices + max_node);
+    }
+    GALOIS_LOG_ASSERT(next_node == num_nodes);
+    return plan;
+  };
+
+  check_plan(tsuba::SliceWeights{.node_weight = 1, .edge_weight = 0});
+  check_plan(tsuba::SliceWeights{.node_weight = 0.5, .edge_weight = 1});
+  std::vector<tsuba::RDGSlice::SliceArg> plan = check_plan(
+      tsuba::SliceWeights{.node_weight = 0, .edge_weight = 1});
+
+  GALOIS_LOG_ASSERT(!prefix.PlanSlices(0));
+
+  // The plain topology file is a four word header, the end of the edges of
+  // each node and then the destination of each edge. A slice binds the
+  // node indexes from its first node on and the destinations up to its last
+  // edge.
+  constexpr uint64_t indices_off = 4 * sizeof(uint64_t);
+  constexpr uint64_t dests_off = indices_off + num_nodes * sizeof(uint64_t);
+
+  // each slice loads with the ranges the planner computed
+  bool ok = true;
+  for (const tsuba::RDGSlice::SliceArg& slice_arg : plan) {
+    auto [first, last] = slice_arg.node_range;
+    auto [first_edge, last_edge] = slice_arg.edge_range;
+    ok = ok && slice_arg.topo_off == indices_off + first * sizeof(uint64_t) &&
+         slice_arg.topo_off + slice_arg.topo_size ==
+             dests_off + last_edge * sizeof(uint32_t);
+
+    auto slice_result = tsuba::RDGSlice::Make(handle, slice_arg);
+    if (!slice_result) {
+      ok = false;
+      break;
+    }
+    const tsuba::RDGSlice& slice = slice_result.value();
+    ok = ok &&
+         static_cast<uint64_t>(slice.node_table()->num_rows()) ==
+             last - first &&
+         static_cast<uint64_t>(slice.edge_table()->num_rows()) ==
+             last_edge - first_edge;
+
+    const tsuba::FileView& topology = slice.topology_file_storage();
+    const uint64_t* indices = topology.ptr<uint64_t>(indices_off);
+    for (uint64_t n = first; ok && n < last; ++n) {
+      ok = indices[n] == g->topology().edge_range(n).second;
+    }
+    const uint32_t* dests = topology.ptr<uint32_t>(dests_off);
+    for (uint64_t e = first_edge; ok && e < last_edge; ++e) {
+      ok = dests[e] == g->topology().out_dests->Value(e);
+    }
+  }
+  auto close_result = tsuba::Close(handle);
+  fs::remove_all(rdg_dir);
+  GALOIS_LOG_ASSERT(close_result);
+  GALOIS_LOG_ASSERT(ok);
+}
+
+void
+TestReorderNodes() {
+  constexpr size_t num_nodes = 1000;
+  using galois::graphs::ReorderPolicy;
+
+  for (ReorderPolicy policy :
+       {ReorderPolicy::Degree, ReorderPolicy::HubSort,
+        ReorderPolicy::HubCluster, ReorderPolicy::BFS, ReorderPolicy::RCM,
+        ReorderPolicy::GorderLite}) {
+    SkewedPolicy skewed;
+    std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+        MakeFileGraph<uint32_t>(num_nodes, 1, &skewed);
+    uint64_t num_edges = g->topology().num_edges();
+    // rows hold their original node and edge ids
+    GALOIS_LOG_ASSERT(
+        g->AddNodeProperties(MakeTable<uint64_t>("node-id", num_nodes)));
+    GALOIS_LOG_ASSERT(
+        g->AddEdgeProperties(MakeTable<uint64_t>("edge-id", num_edges)));
+    galois::graphs::GraphTopology original = g->topology();
+
+    auto reorder_result = galois::graphs::ReorderNodes(g.get(), policy);
+    GALOIS_LOG_VASSERT(
+        reorder_result, "reordering with policy {}", static_cast<int>(policy));
+    const std::vector<uint32_t>& old_to_new = reorder_result.value();
+    const galois::graphs::GraphTopology& topology = g->topology();
+    GALOIS_LOG_ASSERT(topology.num_nodes() == num_nodes);
+    GALOIS_LOG_ASSERT(topology.num_edges() == num_edges);
+
+    auto node_ids = g->NodePropertyTyped<uint64_t>("node-id");
+    auto edge_ids = g->EdgePropertyTyped<uint64_t>("edge-id");
+    GALOIS_LOG_ASSERT(node_ids && edge_ids);
+    for (uint32_t n = 0; n < num_nodes; ++n) {
+      uint32_t m = old_to_new[n];
+      GALOIS_LOG_ASSERT(node_ids.value()->Value(m) == n);
+      auto [begin, end] = topology.edge_range(m);
+      auto [old_begin, old_end] = original.edge_range(n);
+      GALOIS_LOG_ASSERT(end - begin == old_end - old_begin);
+      for (uint64_t e = begin; e < end; ++e) {
+        uint64_t old_edge = edge_ids.value()->Value(e);
+        GALOIS_LOG_ASSERT(old_begin <= old_edge && old_edge < old_end);
+        GALOIS_LOG_ASSERT(
+            topology.out_dests->Value(e) ==
+            old_to_new[original.out_dests->Value(old_edge)]);
+      }
+    }
+
+    if (policy == ReorderPolicy::Degree || policy == ReorderPolicy::HubSort) {
+      // the high degree nodes come first
+      for (uint32_t n = 0; n < 10; ++n) {
+        GALOIS_LOG_ASSERT(old_to_new[n] < 10);
+      }
+    }
+  }
+
+  SkewedPolicy skewed;
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      MakeFileGraph<uint32_t>(num_nodes, 1, &skewed);
+  std::vector<uint32_t> not_permutation(num_nodes, 0);
+  GALOIS_LOG_ASSERT(!galois::graphs::PermuteNodes(g.get(), not_permutation));
+  GALOIS_LOG_ASSERT(!galois::graphs::PermuteNodes(g.get(), {}));
+}
+
+void
+TestCompressedRoundTrip() {
+  constexpr size_t num_nodes = 1 << 10;
+  constexpr size_t num_properties = 2;
+
+  for (auto codec :
+       {arrow::Compression::SNAPPY, arrow::Compression::GZIP,
+        arrow::Compression::BROTLI, arrow::Compression::ZSTD}) {
+    tsuba::PropWriteOptions options;
+    options.codec = codec;
+    options.dictionary = false;
+    if (auto res = tsuba::ValidatePropWriteOptions(options); !res) {
+      // Only snappy, gzip and brotli are in the supported Arrow build; see
+      // config/conanfile.py
+      GALOIS_LOG_ASSERT(
+          codec != arrow::Compression::SNAPPY &&
+          codec != arrow::Compression::GZIP &&
+          codec != arrow::Compression::BROTLI);
+      GALOIS_LOG_ASSERT(res.error() == tsuba::ErrorCode::NotImplemented);
+      GALOIS_LOG_WARN(
+          "skipping {}: not in this build",
+          arrow::util::Codec::GetCodecAsString(codec));
+      continue;
+    }
+
+    RandomPolicy policy{4};
+    std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+        MakeFileGraph<int64_t>(num_nodes, num_properties, &policy);
+    g->MarkAllPropertiesPersistent();
+    GALOIS_LOG_ASSERT(g->SetPropWriteOptions(options));
+    GALOIS_LOG_ASSERT(g->SetTopologyCompression(codec));
+
+    auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+    GALOIS_LOG_ASSERT(uri_res);
+    std::string rdg_dir(uri_res.value().path());  // path() because local
+
+    auto write_result = g->Write(rdg_dir, command_line);
+    if (!write_result) {
+      fs::remove_all(rdg_dir);
+      GALOIS_LOG_FATAL("writing result: {}", write_result.error());
+    }
+
+    auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+    fs::remove_all(rdg_dir);
+    if (!make_result) {
+      GALOIS_LOG_FATAL("making result: {}", make_result.error());
+    }
+
+    GALOIS_LOG_VASSERT(
+        g->Equals(make_result.value().get()), "round trip failed for {}",
+        arrow::util::Codec::GetCodecAsString(codec));
+    GALOIS_LOG_ASSERT(make_result.value()->prop_write_options() == options);
+  }
+}
+
+/// Number of row groups in the Parquet file for the property whose file name
+/// starts with prefix in dir
+int
+NumRowGroups(const std::string& dir, const std::string& prefix) {
+  for (const fs::directory_entry& entry : fs::directory_iterator(dir)) {
+    if (entry.path().filename().string().rfind(prefix, 0) == 0) {
+      return parquet::ParquetFileReader::OpenFile(entry.path().string(), false)
+          ->metadata()
+          ->num_row_groups();
+    }
+  }
+  GALOIS_LOG_FATAL("no file for {} in {}", prefix, dir);
+}
+
+void
+TestWriteOptionsPersist() {
+  constexpr size_t test_length = 10;
+  using ValueType = uint64_t;
+
+  auto g = std::make_unique<galois::graphs::PropertyFileGraph>();
+  GALOIS_LOG_ASSERT(
+      g->AddNodeProperties(MakeTable<ValueType>("wo-rdg", test_length)));
+  GALOIS_LOG_ASSERT(
+      g->AddNodeProperties(MakeTable<ValueType>("wo-prop", test_length)));
+  g->MarkAllPropertiesPersistent();
+
+  tsuba::PropWriteOptions options;
+  options.row_group_size = 4;
+  options.dictionary = false;
+  GALOIS_LOG_ASSERT(g->SetPropWriteOptions(options));
+  tsuba::PropWriteOptions prop_options = options;
+  prop_options.row_group_size = 2;
+  GALOIS_LOG_ASSERT(g->SetNodePropertyWriteOptions("wo-prop", prop_options));
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+  auto copy_uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(copy_uri_res);
+  std::string copy_dir(copy_uri_res.value().path());
+
+  if (auto res = g->Write(rdg_dir, command_line); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", res.error());
+  }
+
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  if (!make_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g2 =
+      std::move(make_result.value());
+  GALOIS_LOG_ASSERT(g2->prop_write_options() == options);
+
+  // writing elsewhere rewrites every property with the recorded options
+  auto copy_result = g2->Write(copy_dir, command_line);
+  fs::remove_all(rdg_dir);
+  if (!copy_result) {
+    fs::remove_all(copy_dir);
+    GALOIS_LOG_FATAL("writing copy: {}", copy_result.error());
+  }
+  int rdg_row_groups = NumRowGroups(copy_dir, "wo-rdg");
+  int prop_row_groups = NumRowGroups(copy_dir, "wo-prop");
+  fs::remove_all(copy_dir);
+  GALOIS_LOG_ASSERT(rdg_row_groups == 3);
+  GALOIS_LOG_ASSERT(prop_row_groups == 5);
+}
+
+void
+TestGapEncodedRoundTrip() {
+  constexpr size_t num_nodes = 1 << 10;
+  constexpr size_t num_properties = 2;
+
+  for (auto codec :
+       {arrow::Compression::UNCOMPRESSED, arrow::Compression::GZIP}) {
+    RandomPolicy policy{4};
+    std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+        MakeFileGraph<int64_t>(num_nodes, num_properties, &policy);
+    g->MarkAllPropertiesPersistent();
+    g->SetTopologyEncoding(galois::graphs::TopologyEncoding::GapEncoded);
+    GALOIS_LOG_ASSERT(g->SetTopologyCompression(codec));
+
+    auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+    GALOIS_LOG_ASSERT(uri_res);
+    std::string rdg_dir(uri_res.value().path());  // path() because local
+
+    auto write_result = g->Write(rdg_dir, command_line);
+    if (!write_result) {
+      fs::remove_all(rdg_dir);
+      GALOIS_LOG_FATAL("writing result: {}", write_result.error());
+    }
+
+    auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+    fs::remove_all(rdg_dir);
+    if (!make_result) {
+      GALOIS_LOG_FATAL("making result: {}", make_result.error());
+    }
+    std::unique_ptr<galois::graphs::PropertyFileGraph> loaded =
+        std::move(make_result.value());
+
+    auto compressed = loaded->compressed_topology();
+    GALOIS_LOG_ASSERT(compressed);
+    GALOIS_LOG_ASSERT(compressed->num_edges() == g->topology().num_edges());
+
+    galois::graphs::CompressedTopology::Cursor cursor(compressed.get());
+    const auto& expected = g->topology();
+    for (uint32_t n = 0; n < num_nodes; ++n) {
+      cursor.ForEachOutEdge(n, [&](uint64_t e, uint32_t dest) {
+        GALOIS_LOG_ASSERT(dest == expected.out_dests->Value(e));
+      });
+    }
+
+    GALOIS_LOG_VASSERT(
+        g->Equals(loaded.get()), "round trip failed for {}",
+        arrow::util::Codec::GetCodecAsString(codec));
+  }
+}
+
+void
+TestCompressedTopologyValidation() {
+  constexpr size_t num_nodes = 1 << 10;
+  constexpr size_t num_properties = 1;
+  using galois::graphs::CompressedTopology;
+
+  LinePolicy policy{4};
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      MakeFileGraph<uint32_t>(num_nodes, num_properties, &policy);
+  auto encode_result = CompressedTopology::Encode(g->topology());
+  GALOIS_LOG_ASSERT(encode_result);
+  const CompressedTopology& encoded = encode_result.value();
+  GALOIS_LOG_ASSERT(encoded.num_edges() >= CompressedTopology::kBlockSize);
+
+  // Make a topology from a copy of encoded whose byte at pos is changed
+  auto make_changed = [&](uint64_t pos, uint8_t value) {
+    auto alloc_result = arrow::AllocateBuffer(encoded.data()->size());
+    GALOIS_LOG_ASSERT(alloc_result.ok());
+    std::shared_ptr<arrow::Buffer> data = std::move(alloc_result.ValueOrDie());
+    std::memcpy(
+        data->mutable_data(), encoded.data()->data(), encoded.data()->size());
+    data->mutable_data()[pos] = value;
+    return CompressedTopology::Make(
+        encoded.out_indices(), encoded.num_edges(), encoded.block_offsets(),
+        data);
+  };
+
+  uint8_t control = encoded.data()->data()[0];
+  GALOIS_LOG_ASSERT(make_changed(0, control));
+  // The first value claims a different length, so the block no longer adds
+  // up to its size
+  GALOIS_LOG_ASSERT(!make_changed(0, control ^ 1));
+  // The first delta becomes -128, so destinations wrap past num_nodes
+  uint64_t first_data = CompressedTopology::kBlockSize / 4;
+  GALOIS_LOG_ASSERT((control & 3) == 0);
+  GALOIS_LOG_ASSERT(!make_changed(first_data, 0xFF));
+}
+
+/// Check that transpose holds exactly the reversed edges of topology
+void
+CheckTranspose(
+    const galois::graphs::GraphTopology& topology,
+    const galois::graphs::TransposeTopology& transpose) {
+  GALOIS_LOG_ASSERT(transpose.num_nodes() == topology.num_nodes());
+  GALOIS_LOG_ASSERT(transpose.num_edges() == topology.num_edges());
+
+  std::vector<bool> seen(topology.num_edges(), false);
+  for (uint32_t n = 0; n < transpose.num_nodes(); ++n) {
+    auto [begin, end] = transpose.in_edge_range(n);
+    for (uint64_t e = begin; e < end; ++e) {
+      uint64_t out_edge = transpose.out_edge(e);
+      uint32_t src = transpose.in_edge_source(e);
+      auto [src_begin, src_end] = topology.edge_range(src);
+      GALOIS_LOG_ASSERT(src_begin <= out_edge && out_edge < src_end);
+      GALOIS_LOG_ASSERT(topology.out_dests->Value(out_edge) == n);
+      GALOIS_LOG_ASSERT(!seen[out_edge]);
+      seen[out_edge] = true;
+      if (e > begin) {
+        GALOIS_LOG_ASSERT(transpose.in_edge_source(e - 1) <= src);
+      }
+    }
+  }
+}
+
+void
+TestTransposeTopology() {
+  constexpr size_t num_nodes = 1 << 10;
+  constexpr size_t num_properties = 2;
+
+  RandomPolicy policy{4};
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      MakeFileGraph<int64_t>(num_nodes, num_properties, &policy);
+  g->MarkAllPropertiesPersistent();
+
+  GALOIS_LOG_ASSERT(
+      g->GetTransposeTopology().error() ==
+      galois::ErrorCode::PropertyNotFound);
+  GALOIS_LOG_ASSERT(g->BuildTransposeTopology());
+  auto built = g->GetTransposeTopology();
+  GALOIS_LOG_ASSERT(built);
+  CheckTranspose(g->topology(), *built.value());
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+
+  auto write_result = g->Write(rdg_dir, command_line);
+  if (!write_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", write_result.error());
+  }
+
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  if (!make_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> loaded =
+      std::move(make_result.value());
+  // loaded on request rather than with the graph
+  auto loaded_transpose = loaded->GetTransposeTopology();
+  fs::remove_all(rdg_dir);
+  GALOIS_LOG_ASSERT(loaded_transpose);
+  GALOIS_LOG_ASSERT(
+      loaded_transpose.value()->topology.Equals(built.value()->topology));
+  GALOIS_LOG_ASSERT(
+      loaded_transpose.value()->edge_ids->Equals(*built.value()->edge_ids));
+
+  // changing the topology invalidates the transpose
+  GALOIS_LOG_ASSERT(loaded->SetTopology(g->topology()));
+  GALOIS_LOG_ASSERT(!loaded->GetTransposeTopology());
+}
+
+/// Edge e has type "even" if e is even and type "third" if e is a multiple of
+/// three; every seventh edge has no value for "third"
+std::shared_ptr<arrow::Table>
+MakeEdgeTypes(size_t num_edges) {
+  arrow::BooleanBuilder even;
+  arrow::BooleanBuilder third;
+  for (size_t e = 0; e < num_edges; ++e) {
+    GALOIS_LOG_ASSERT(even.Append(e % 2 == 0).ok());
+    if (e % 7 == 0) {
+      GALOIS_LOG_ASSERT(third.AppendNull().ok());
+    } else {
+      GALOIS_LOG_ASSERT(third.Append(e % 3 == 0).ok());
+    }
+  }
+  std::shared_ptr<arrow::Array> even_array;
+  std::shared_ptr<arrow::Array> third_array;
+  GALOIS_LOG_ASSERT(even.Finish(&even_array).ok());
+  GALOIS_LOG_ASSERT(third.Finish(&third_array).ok());
+  return arrow::Table::Make(
+      arrow::schema({
+          arrow::field("even", arrow::boolean()),
+          arrow::field("third", arrow::boolean()),
+      }),
+      {even_array, third_array});
+}
+
+/// Check that the edges of each node and type in type_topology are exactly
+/// the out-edges of the node that have the type, in order
+void
+CheckEdgeTypes(
+    const galois::graphs::GraphTopology& topology,
+    const galois::graphs::EdgeTypeTopology& type_topology) {
+  GALOIS_LOG_ASSERT(type_topology.num_nodes() == topology.num_nodes());
+  auto even = type_topology.TypeIndex("even");
+  auto third = type_topology.TypeIndex("third");
+  GALOIS_LOG_ASSERT(even && third);
+  GALOIS_LOG_ASSERT(!type_topology.TypeIndex("no-such-type"));
+
+  auto has_type = [](uint64_t e, const std::string& type) {
+    return type == "even" ? e % 2 == 0 : e % 7 != 0 && e % 3 == 0;
+  };
+  for (uint32_t n = 0; n < topology.num_nodes(); ++n) {
+    for (const std::string& type : type_topology.type_names) {
+      auto [begin, end] =
+          type_topology.edge_range(n, type_topology.TypeIndex(type).value());
+      uint64_t typed = begin;
+      auto [out_begin, out_end] = topology.edge_range(n);
+      for (uint64_t e = out_begin; e < out_end; ++e) {
+        if (!has_type(e, type)) {
+          continue;
+        }
+        GALOIS_LOG_ASSERT(typed < end);
+        GALOIS_LOG_ASSERT(type_topology.out_edge(typed) == e);
+        GALOIS_LOG_ASSERT(
+            type_topology.edge_dest(typed) == topology.out_dests->Value(e));
+        ++typed;
+      }
+      GALOIS_LOG_ASSERT(typed == end);
+    }
+  }
+}
+
+void
+TestEdgeTypeTopology() {
+  constexpr size_t num_nodes = 1 << 10;
+
+  RandomPolicy policy{4};
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      MakeFileGraph<int64_t>(num_nodes, 1, &policy);
+  GALOIS_LOG_ASSERT(
+      g->AddEdgeProperties(MakeEdgeTypes(g->topology().num_edges())));
+  g->MarkAllPropertiesPersistent();
+
+  GALOIS_LOG_ASSERT(
+      g->GetEdgeTypeTopology().error() == galois::ErrorCode::PropertyNotFound);
+  GALOIS_LOG_ASSERT(!g->BuildEdgeTypeTopology({}));
+  GALOIS_LOG_ASSERT(!g->BuildEdgeTypeTopology({"no-such-type"}));
+  GALOIS_LOG_ASSERT(g->BuildEdgeTypeTopology({"even", "third"}));
+  auto built = g->GetEdgeTypeTopology();
+  GALOIS_LOG_ASSERT(built);
+  CheckEdgeTypes(g->topology(), *built.value());
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+
+  auto write_result = g->Write(rdg_dir, command_line);
+  if (!write_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", write_result.error());
+  }
+
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  if (!make_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> loaded =
+      std::move(make_result.value());
+  // loaded on request rather than with the graph
+  auto loaded_types = loaded->GetEdgeTypeTopology();
+  fs::remove_all(rdg_dir);
+  GALOIS_LOG_ASSERT(loaded_types);
+  GALOIS_LOG_ASSERT(
+      loaded_types.value()->type_names == built.value()->type_names);
+  CheckEdgeTypes(loaded->topology(), *loaded_types.value());
+
+  // changing the topology invalidates the index
+  GALOIS_LOG_ASSERT(loaded->SetTopology(g->topology()));
+  GALOIS_LOG_ASSERT(!loaded->GetEdgeTypeTopology());
+}
+
+size_t
+CountFiles(const std::string& dir) {
+  return std::distance(fs::directory_iterator(dir), fs::directory_iterator());
+}
+
+void
+TestCommitAsync() {
+  constexpr size_t num_nodes = 10;
+  using ValueType = uint64_t;
+
+  LinePolicy policy{1};
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      MakeFileGraph<ValueType>(num_nodes, 1, &policy);
+  g->MarkAllPropertiesPersistent();
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+
+  auto write_result = g->Write(rdg_dir, command_line);
+  if (!write_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", write_result.error());
+  }
+
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  if (!make_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g2 =
+      std::move(make_result.value());
+
+  size_t num_files = CountFiles(rdg_dir);
+
+  GALOIS_LOG_ASSERT(
+      g2->AddNodeProperties(MakeTable<ValueType>("async-a", num_nodes)));
+  g2->MarkAllPropertiesPersistent();
+  std::shared_future<galois::Result<void>> commit =
+      g2->CommitAsync(command_line);
+
+  // properties can be added while the commit is in flight
+  GALOIS_LOG_ASSERT(
+      g2->AddNodeProperties(MakeTable<ValueType>("async-b", num_nodes)));
+  g2->MarkAllPropertiesPersistent();
+
+  if (auto res = commit.get(); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("async commit: {}", res.error());
+  }
+  GALOIS_LOG_ASSERT(g2->WaitForCommit());
+  size_t first_commit_files = CountFiles(rdg_dir) - num_files;
+  num_files += first_commit_files;
+
+  if (auto res = g2->Commit(command_line); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("commit: {}", res.error());
+  }
+  // Each commit writes one property and the same metadata; async-a, which
+  // the first commit stored, is not written again
+  GALOIS_LOG_ASSERT(CountFiles(rdg_dir) - num_files == first_commit_files);
+  g2.reset();
+
+  auto reload_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  fs::remove_all(rdg_dir);
+  if (!reload_result) {
+    GALOIS_LOG_FATAL("reloading result: {}", reload_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g3 =
+      std::move(reload_result.value());
+  for (const char* name : {"async-a", "async-b"}) {
+    auto property = g3->NodePropertyTyped<ValueType>(name);
+    GALOIS_LOG_ASSERT(property);
+    GALOIS_LOG_ASSERT(
+        static_cast<size_t>(property.value()->length()) == num_nodes);
+    for (size_t i = 0; i < num_nodes; ++i) {
+      GALOIS_LOG_ASSERT(property.value()->Value(i) == i);
+    }
+  }
+}
+
+void
+TestCommitAsyncTopology() {
+  constexpr size_t num_nodes = 10;
+  using ValueType = uint64_t;
+
+  LinePolicy policy{1};
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      MakeFileGraph<ValueType>(num_nodes, 1, &policy);
+  g->MarkAllPropertiesPersistent();
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+
+  auto write_result = g->Write(rdg_dir, command_line);
+  if (!write_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", write_result.error());
+  }
+
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  if (!make_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g2 =
+      std::move(make_result.value());
+
+  // The background commit writes the topology with the new encoding, and the
+  // commit after it must keep referring to that file
+  g2->SetTopologyEncoding(galois::graphs::TopologyEncoding::GapEncoded);
+  if (auto res = g2->CommitAsync(command_line).get(); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("async commit: {}", res.error());
+  }
+  if (auto res = g2->Commit(command_line); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("commit: {}", res.error());
+  }
+  g2.reset();
+
+  auto reload_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  fs::remove_all(rdg_dir);
+  if (!reload_result) {
+    GALOIS_LOG_FATAL("reloading result: {}", reload_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g3 =
+      std::move(reload_result.value());
+  GALOIS_LOG_ASSERT(g3->compressed_topology());
+  GALOIS_LOG_ASSERT(g->Equals(g3.get()));
+}
+
+void
+TestSnapshotIsolation() {
+  constexpr size_t num_nodes = 10;
+  constexpr int num_versions = 100;
+  using ValueType = uint64_t;
+
+  LinePolicy policy{1};
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      MakeFileGraph<ValueType>(num_nodes, 1, &policy);
+  size_t num_node_properties = g->NodeProperties().size();
+  size_t num_edge_properties = g->EdgeProperties().size();
+
+  std::shared_ptr<const galois::graphs::GraphSnapshot> pinned = g->Snapshot();
+  GALOIS_LOG_ASSERT(
+      static_cast<size_t>(pinned->node_table->num_columns()) ==
+      num_node_properties);
+
+  // a reader takes snapshots while this thread changes the graph
+  std::atomic<bool> done{false};
+  std::future<void> reader = std::async(std::launch::async, [&]() {
+    uint64_t last_version = 0;
+    while (!done) {
+      std::shared_ptr<const galois::graphs::GraphSnapshot> snapshot =
+          g->Snapshot();
+      GALOIS_LOG_ASSERT(snapshot->version >= last_version);
+      last_version = snapshot->version;
+      GALOIS_LOG_ASSERT(snapshot->topology.num_nodes() == num_nodes);
+      // a version has all of a property or none of it
+      if (auto property = snapshot->NodeProperty("snap"); property) {
+        GALOIS_LOG_ASSERT(static_cast<size_t>(property->length()) == num_nodes);
+      }
+    }
+  });
+
+  for (int i = 0; i < num_versions; ++i) {
+    GALOIS_LOG_ASSERT(
+        g->AddNodeProperties(MakeTable<ValueType>("snap", num_nodes)));
+    GALOIS_LOG_ASSERT(g->RemoveNodeProperty("snap"));
+  }
+  done = true;
+  reader.get();
+
+  // the pinned version is unchanged and each change published a new one
+  GALOIS_LOG_ASSERT(
+      static_cast<size_t>(pinned->node_table->num_columns()) ==
+      num_node_properties);
+  GALOIS_LOG_ASSERT(!pinned->NodeProperty("snap"));
+  std::shared_ptr<const galois::graphs::GraphSnapshot> latest = g->Snapshot();
+  GALOIS_LOG_ASSERT(latest->version == pinned->version + 2 * num_versions);
+
+  GALOIS_LOG_ASSERT(
+      g->AddEdgeProperties(MakeTable<ValueType>("snap-edge", num_nodes)));
+  GALOIS_LOG_ASSERT(g->Snapshot()->EdgeProperty("snap-edge"));
+  GALOIS_LOG_ASSERT(g->RemoveEdgeProperty("snap-edge"));
+  GALOIS_LOG_ASSERT(g->EdgeProperties().size() == num_edge_properties);
+  GALOIS_LOG_ASSERT(g->NodeProperties().size() == num_node_properties);
+  GALOIS_LOG_ASSERT(!g->Snapshot()->EdgeProperty("snap-edge"));
+  GALOIS_LOG_ASSERT(latest->EdgeProperty("snap-edge") == nullptr);
+
+  // SetTopology publishes too
+  galois::graphs::GraphTopology topology = g->topology();
+  GALOIS_LOG_ASSERT(g->SetTopology(topology));
+  GALOIS_LOG_ASSERT(g->Snapshot()->version == latest->version + 3);
+}
+
+int64_t
+IntStat(const std::string& name) {
+  int64_t value = 0;
+  tsuba::ForEachStat(
+      [&](const std::string& n, int64_t v) {
+        if (n == name) {
+          value = v;
+        }
+      },
+      [](const std::string&, double) {});
+  return value;
+}
+
+void
+TestReopenCachedHeader() {
+  constexpr size_t num_nodes = 10;
+  using ValueType = uint64_t;
+
+  LinePolicy policy{1};
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      MakeFileGraph<ValueType>(num_nodes, 1, &policy);
+  g->MarkAllPropertiesPersistent();
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+
+  if (auto res = g->Write(rdg_dir, command_line); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", res.error());
+  }
+
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  GALOIS_LOG_ASSERT(make_result);
+  int64_t hits = IntStat("PartHeaderCacheHits");
+
+  // reopening the same version does not parse its header again
+  auto reopen_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  GALOIS_LOG_ASSERT(reopen_result);
+  GALOIS_LOG_ASSERT(IntStat("PartHeaderCacheHits") > hits);
+
+  // a new version is read from its own header
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g2 =
+      std::move(reopen_result.value());
+  GALOIS_LOG_ASSERT(
+      g2->AddNodeProperties(MakeTable<ValueType>("cached-a", num_nodes)));
+  g2->MarkAllPropertiesPersistent();
+  if (auto res = g2->Commit(command_line); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("commit: {}", res.error());
+  }
+  g2.reset();
+
+  auto reload_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  fs::remove_all(rdg_dir);
+  GALOIS_LOG_ASSERT(reload_result);
+  GALOIS_LOG_ASSERT(
+      reload_result.value()->NodePropertyTyped<ValueType>("cached-a"));
+}
+
+void
+TestRecreatedCachedHeader() {
+  constexpr size_t num_nodes = 10;
+  using ValueType = uint64_t;
+
+  LinePolicy policy{1};
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      MakeFileGraph<ValueType>(num_nodes, 1, &policy);
+  g->MarkAllPropertiesPersistent();
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+  auto other_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(other_res);
+  std::string other_dir(other_res.value().path());  // path() because local
+
+  if (auto res = g->Write(rdg_dir, command_line); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", res.error());
+  }
+  GALOIS_LOG_ASSERT(galois::graphs::PropertyFileGraph::Make(rdg_dir));
+
+  // The same version of a different graph, as if rdg_dir were deleted and
+  // created again by another process, which does not drop what this process
+  // has cached
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g2 =
+      MakeFileGraph<ValueType>(num_nodes, 1, &policy);
+  GALOIS_LOG_ASSERT(
+      g2->AddNodeProperties(MakeTable<ValueType>("recreated-a", num_nodes)));
+  g2->MarkAllPropertiesPersistent();
+  if (auto res = g2->Write(other_dir, command_line); !res) {
+    fs::remove_all(rdg_dir);
+    fs::remove_all(other_dir);
+    GALOIS_LOG_FATAL("writing result: {}", res.error());
+  }
+  fs::remove_all(rdg_dir);
+  fs::rename(other_dir, rdg_dir);
+
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  fs::remove_all(rdg_dir);
+  GALOIS_LOG_ASSERT(make_result);
+  GALOIS_LOG_ASSERT(
+      make_result.value()->NodePropertyTyped<ValueType>("recreated-a"));
+}
+
+void
+TestStreamingFileFrame() {
+  constexpr uint64_t part_size = 4096;
+  constexpr uint64_t size = 3 * part_size + 100;
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string dir(uri_res.value().path());  // path() because local
+  std::string path = galois::Uri::JoinPath(dir, "streamed");
+
+  std::vector<uint8_t> expected(size);
+  for (uint64_t i = 0; i < size; ++i) {
+    expected[i] = static_cast<uint8_t>(i * 7);
+  }
+
+  {
+    tsuba::FileFrame ff;
+    // a budget of two parts: one being filled and one being stored
+    GALOIS_LOG_ASSERT(ff.InitStreaming(path, part_size, 2 * part_size));
+    GALOIS_LOG_ASSERT(ff.streaming());
+    // odd sized writes that straddle part boundaries
+    for (uint64_t off = 0; off < size; off += 1000) {
+      GALOIS_LOG_ASSERT(
+          ff.Write(expected.data() + off, std::min<uint64_t>(1000, size - off))
+              .ok());
+    }
+    GALOIS_LOG_ASSERT(ff.Persist());
+
+    // the parts are gone once the upload completes
+    GALOIS_LOG_ASSERT(!ff.Persist());
+    GALOIS_LOG_ASSERT(!ff.Write(expected.data(), 1).ok());
+    GALOIS_LOG_ASSERT(!ff.ptr<uint8_t>());
+  }
+
+  // less than a part holds only what was written and is stored whole
+  std::string small_path = galois::Uri::JoinPath(dir, "small");
+  int64_t parts = IntStat("FileFrameParts");
+  {
+    tsuba::FileFrame ff;
+    GALOIS_LOG_ASSERT(ff.InitStreaming(small_path, part_size, 2 * part_size));
+    GALOIS_LOG_ASSERT(ff.Write(expected.data(), 100).ok());
+    GALOIS_LOG_ASSERT(ff.buffered_bytes() < part_size);
+    GALOIS_LOG_ASSERT(ff.Persist());
+  }
+  GALOIS_LOG_ASSERT(IntStat("FileFrameParts") == parts);
+
+  std::vector<uint8_t> actual(size);
+  auto get_res = tsuba::FileGet(path, actual.data(), 0, size);
+  tsuba::StatBuf stat;
+  auto stat_res = tsuba::FileStat(path, &stat);
+  std::vector<uint8_t> small_actual(100);
+  auto small_res = tsuba::FileGet(small_path, small_actual.data(), 0, 100);
+  fs::remove_all(dir);
+  GALOIS_LOG_ASSERT(get_res);
+  GALOIS_LOG_ASSERT(stat_res);
+  GALOIS_LOG_ASSERT(stat.size == size);
+  GALOIS_LOG_ASSERT(actual == expected);
+  GALOIS_LOG_ASSERT(small_res);
+  GALOIS_LOG_ASSERT(std::equal(
+      small_actual.begin(), small_actual.end(), expected.begin()));
+}
+
+double
+FpStat(const std::string& name) {
+  double value = 0;
+  tsuba::ForEachStat(
+      [](const std::string&, int64_t) {},
+      [&](const std::string& n, double v) {
+        if (n == name) {
+          value = v;
+        }
+      });
+  return value;
+}
+
+/// Store num_files files of size bytes through a WriteGroup with the given
+/// bounds and return the most writes that ran at once
+uint64_t
+StoreWithLimits(
+    uint64_t num_files, uint64_t size, uint64_t max_in_flight_bytes,
+    uint64_t max_in_flight_ops) {
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string dir(uri_res.value().path());  // path() because local
+
+  std::vector<uint8_t> buf(size, 42);
+  auto make_res =
+      tsuba::WriteGroup::Make(max_in_flight_bytes, max_in_flight_ops);
+  GALOIS_LOG_ASSERT(make_res);
+  std::unique_ptr<tsuba::WriteGroup> group = std::move(make_res.value());
+  for (uint64_t i = 0; i < num_files; ++i) {
+    group->StartStore(
+        galois::Uri::JoinPath(dir, std::to_string(i)), buf.data(), size);
+  }
+  auto finish_res = group->Finish();
+
+  std::vector<std::string> files;
+  std::vector<uint64_t> sizes;
+  auto list_res = tsuba::FileListAsync(dir, &files, &sizes).get();
+  fs::remove_all(dir);
+  GALOIS_LOG_ASSERT(finish_res);
+  GALOIS_LOG_ASSERT(list_res);
+  GALOIS_LOG_ASSERT(files.size() == num_files);
+  for (uint64_t s : sizes) {
+    GALOIS_LOG_ASSERT(s == size);
+  }
+  return FpStat("WriteGroupPeakRunningOps");
+}
+
+void
+TestWriteGroupLimits() {
+  constexpr uint64_t num_files = 8;
+  constexpr uint64_t size = 1000;
+
+  // one op at a time
+  GALOIS_LOG_ASSERT(StoreWithLimits(num_files, size, 0, 1) == 1);
+  // less than two buffers in flight at a time
+  GALOIS_LOG_ASSERT(StoreWithLimits(num_files, size, size + size / 2, 0) == 1);
+  // two ops at a time
+  uint64_t peak = StoreWithLimits(num_files, size, 0, 2);
+  GALOIS_LOG_ASSERT(peak >= 1 && peak <= 2);
+}
+
+void
+TestExternallyReplacedFile() {
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string dir(uri_res.value().path());  // path() because local
+  std::string path = galois::Uri::JoinPath(dir, "replaced");
+
+  std::vector<uint8_t> old_data(100, 1);
+  std::vector<uint8_t> new_data(100, 2);
+  GALOIS_LOG_ASSERT(tsuba::FileStore(path, old_data.data(), old_data.size()));
+  std::vector<uint8_t> buf(100);
+  GALOIS_LOG_ASSERT(tsuba::FileGet(path, buf.data(), 0, buf.size()));
+
+  // Replace the file behind tsuba's back, as another process would
+  std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream ofile(tmp_path, std::ios::binary);
+    ofile.write(
+        reinterpret_cast<const char*>(new_data.data()), new_data.size());
+  }
+  fs::rename(tmp_path, path);
+  std::vector<uint8_t> replaced(100);
+  auto get_res = tsuba::FileGet(path, replaced.data(), 0, replaced.size());
+
+  fs::remove(path);
+  auto removed_res = tsuba::FileGet(path, buf.data(), 0, buf.size());
+  fs::remove_all(dir);
+
+  GALOIS_LOG_ASSERT(get_res);
+  GALOIS_LOG_ASSERT(replaced == new_data);
+  GALOIS_LOG_ASSERT(!removed_res);
+}
+
+void
+TestListManyFiles() {
+  // enough files for several pages of concurrent stats
+  constexpr uint64_t num_files = 1000;
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string dir(uri_res.value().path());  // path() because local
+
+  std::vector<uint8_t> buf(10, 42);
+  for (uint64_t i = 0; i < num_files; ++i) {
+    auto res = tsuba::FileStore(
+        galois::Uri::JoinPath(dir, std::to_string(i)), buf.data(), i % 10);
+    GALOIS_LOG_ASSERT(res);
+  }
+
+  // listings may run concurrently
+  std::vector<std::string> files;
+  std::vector<uint64_t> sizes;
+  std::vector<std::string> names_only;
+  auto list_fut = tsuba::FileListAsync(dir, &files, &sizes);
+  auto names_fut = tsuba::FileListAsync(dir, &names_only);
+  auto list_res = list_fut.get();
+  auto names_res = names_fut.get();
+  fs::remove_all(dir);
+
+  GALOIS_LOG_ASSERT(list_res && names_res);
+  GALOIS_LOG_ASSERT(files.size() == num_files && sizes.size() == num_files);
+  for (size_t i = 0; i < files.size(); ++i) {
+    GALOIS_LOG_ASSERT(sizes[i] == std::stoul(files[i]) % 10);
+  }
+  std::sort(files.begin(), files.end());
+  std::sort(names_only.begin(), names_only.end());
+  GALOIS_LOG_ASSERT(files == names_only);
+}
+
+void
+TestSequentialReadAhead() {
+  constexpr uint64_t file_size = 1000;
+  tsuba::SequentialReadAhead policy(64);
+
+  // a random read reads ahead a little more than it read
+  auto [begin, end] = policy.NextRange(500, 10, file_size);
+  GALOIS_LOG_ASSERT(begin == 510 && end == 521);
+
+  // each sequential read doubles the window up to the maximum
+  std::tie(begin, end) = policy.NextRange(510, 10, file_size);
+  GALOIS_LOG_ASSERT(begin == 520 && end == 542);
+  std::tie(begin, end) = policy.NextRange(520, 10, file_size);
+  GALOIS_LOG_ASSERT(end == 574);
+  std::tie(begin, end) = policy.NextRange(530, 10, file_size);
+  GALOIS_LOG_ASSERT(end == 604);
+
+  // the window never extends past the end of the file
+  std::tie(begin, end) = policy.NextRange(990, 10, file_size);
+  GALOIS_LOG_ASSERT(begin == 1000 && end == 1000);
+}
+
+void
+TestFileViewResidencyBudget() {
+  constexpr uint64_t page_size = 1 << 20;  // local storage page size
+  constexpr uint64_t num_pages = 8;
+  constexpr uint64_t budget = 2 * page_size;
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string dir(uri_res.value().path());  // path() because local
+  std::string path = galois::Uri::JoinPath(dir, "pages");
+
+  std::vector<uint8_t> data(num_pages * page_size);
+  for (uint64_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i / page_size);
+  }
+  GALOIS_LOG_ASSERT(tsuba::FileStore(path, data.data(), data.size()));
+
+  bool ok = true;
+  {
+    tsuba::FileView fv;
+    fv.set_residency_budget(budget);
+    GALOIS_LOG_ASSERT(fv.Bind(path, 0, false));
+    // two passes so that the second refetches released pages
+    for (int pass = 0; pass < 2; ++pass) {
+      for (uint64_t page = 0; page < num_pages; ++page) {
+        auto ptr_res = fv.ResidentPtr<uint8_t>(page * page_size, page_size);
+        ok = ok && ptr_res && ptr_res.value()[0] == page &&
+             ptr_res.value()[page_size - 1] == page &&
+             fv.resident_bytes() <= budget;
+      }
+    }
+  }
+
+  fs::remove_all(dir);
+  GALOIS_LOG_ASSERT(ok);
+}
+
+void
+TestFileViewBudgetReads() {
+  constexpr uint64_t page_size = 4 << 20;  // sim storage page size
+  constexpr uint64_t num_pages = 6;
+  constexpr uint64_t read_size = page_size / 4;
+
+  // sim storage cannot be mapped, so the view holds the file in anonymous
+  // memory that it releases to stay within the budget
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string dir(uri_res.value().path());  // path() because local
+  std::string path = "sim://" + galois::Uri::JoinPath(dir, "pages");
+
+  std::vector<uint8_t> data(num_pages * page_size);
+  for (uint64_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i / read_size);
+  }
+  GALOIS_LOG_ASSERT(tsuba::FileStore(path, data.data(), data.size()));
+
+  bool ok = true;
+  {
+    tsuba::FileView fv;
+    fv.set_residency_budget(page_size);
+    GALOIS_LOG_ASSERT(fv.Bind(path, false));
+    GALOIS_LOG_ASSERT(!fv.Mapped());
+    // two passes so that the second refetches released pages; read ahead
+    // makes room by releasing pages while reads are in progress
+    for (int pass = 0; pass < 2; ++pass) {
+      GALOIS_LOG_ASSERT(fv.Seek(0).ok());
+      std::vector<uint8_t> out(read_size);
+      for (uint64_t off = 0; off < data.size(); off += read_size) {
+        uint8_t expected = static_cast<uint8_t>(off / read_size);
+        if ((off / read_size) % 2 == 0) {
+          auto buf_res = fv.Read(read_size);
+          ok = ok && buf_res.ok() &&
+               buf_res.ValueOrDie()->size() ==
+                   static_cast<int64_t>(read_size) &&
+               buf_res.ValueOrDie()->data()[0] == expected &&
+               buf_res.ValueOrDie()->data()[read_size - 1] == expected;
+        } else {
+          auto read_res = fv.Read(read_size, out.data());
+          ok = ok && read_res.ok() &&
+               read_res.ValueOrDie() == static_cast<int64_t>(read_size) &&
+               out[0] == expected && out[read_size - 1] == expected;
+        }
+      }
+    }
+  }
+
+  fs::remove_all(dir);
+  GALOIS_LOG_ASSERT(ok);
+}
+
+void
+TestConcurrentLoadError() {
+  constexpr size_t num_nodes = 10;
+  constexpr size_t num_properties = 6;
+  using ValueType = uint64_t;
+
+  auto g = std::make_unique<galois::graphs::PropertyFileGraph>();
+  for (size_t i = 0; i < num_properties; ++i) {
+    GALOIS_LOG_ASSERT(g->AddNodeProperties(
+        MakeTable<ValueType>(fmt::format("load-{}", i), num_nodes)));
+  }
+  g->MarkAllPropertiesPersistent();
+
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string rdg_dir(uri_res.value().path());  // path() because local
+
+  if (auto res = g->Write(rdg_dir, command_line); !res) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("writing result: {}", res.error());
+  }
+
+  // all properties are loaded concurrently and come back in order
+  auto make_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  if (!make_result) {
+    fs::remove_all(rdg_dir);
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  std::shared_ptr<arrow::Schema> schema = make_result.value()->node_schema();
+  GALOIS_LOG_ASSERT(schema->num_fields() == num_properties);
+  for (size_t i = 0; i < num_properties; ++i) {
+    GALOIS_LOG_ASSERT(schema->field(i)->name() == fmt::format("load-{}", i));
+  }
+
+  // a property file that cannot be read fails the whole load
+  bool found = false;
+  for (const fs::directory_entry& entry : fs::directory_iterator(rdg_dir)) {
+    if (entry.path().filename().string().rfind("load-3", 0) == 0) {
+      std::ofstream out(entry.path().string(), std::ios::trunc);
+      out << "not a property file";
+      found = true;
+    }
+  }
+  GALOIS_LOG_ASSERT(found);
+
+  auto corrupt_result = galois::graphs::PropertyFileGraph::Make(rdg_dir);
+  fs::remove_all(rdg_dir);
+  GALOIS_LOG_ASSERT(!corrupt_result);
+}
+
+void
+TestGarbageMetadata() {
+  auto uri_res = galois::Uri::MakeRand("/tmp/propertyfilegraph");
+  GALOIS_LOG_ASSERT(uri_res);
+  std::string temp_dir(uri_res.value().path());  // path because local
+
+  std::string rdg_file{temp_dir};
+  rdg_file += "/meta";
+
+  std::ofstream out(rdg_file);
+  out << "garbage to make the file non-empty";
+  out.close();
+
+  auto no_dir_result = galois::graphs::PropertyFileGraph::Make(rdg_file);
+  fs::remove_all(temp_dir);
+  GALOIS_LOG_ASSERT(!no_dir_result.has_value());
+}
+
+std::string
+MakePFGFile(const std::string& n1name) {
+  constexpr size_t test_length = 10;
+  using V0 = int32_t;
+  using V1 = uint64_t;
+  const std::string n0name = "n0";
+  const std::string e0name = "e0";
+  const std::string e1name = "e1";
+
+  auto g = std::make_unique<galois::graphs::PropertyFileGraph>();
+
+  std::shared_ptr<arrow::Table> node_table = MakeTable<V0>(n0name, test_length);
+
+  auto add_node_result = g->AddNodeProperties(node_table);
+  GALOIS_LOG_ASSERT(add_node_result);
+
+  auto mark_node_persistent = g->MarkNodePropertiesPersistent({n0name});
+  GALOIS_LOG_ASSERT(mark_node_persistent);
+
+  add_node_result = g->AddNodeProperties(MakeTable<V1>(n1name, test_length));
+  if (!add_node_result) {
+    return "";
+  }
+
+  mark_node_persistent = g->MarkNodePropertiesPersistent({n1name});
+  GALOIS_LOG_ASSERT(mark_node_persistent);
+
+  std::shared_ptr<arrow::Table> edge_table = MakeTable<V0>(e0name, test_length);
+
+  auto add_edge_result = g->AddEdgeProperties(edge_table);
+  GALOIS_LOG_ASSERT(add_edge_result);
+
+  auto mark_edge_persistent = g->MarkEdgePropertiesPersistent({e0name});
+  GALOIS_LOG_ASSERT(mark_edge_persistent);
+
+  auto unique_result = galois::Uri::MakeRand("/tmp/propertygraphtests");
+  GALOIS_LOG_ASSERT(unique_result);
+  std::string rdg_file(
+      std::move(unique_result.value().path()));  // path() for local
+
+  auto write_result = g->Write(rdg_file, command_line);
+
+  GALOIS_LOG_WARN("creating temp file {}", rdg_file);
+
+  if (!write_result) {
+    fs::remove_all(rdg_file);
+    GALOIS_LOG_FATAL("writing result: {}", write_result.error());
+  }
+  return rdg_file;
+}
+
+void
+TestSimplePGs() {
+  auto rdg_file = MakePFGFile("n0");
+  GALOIS_LOG_ASSERT(rdg_file.empty());
+  rdg_file = MakePFGFile("n1");
+  galois::Result<std::unique_ptr<galois::graphs::PropertyFileGraph>>
+      make_result = galois::graphs::PropertyFileGraph::Make(rdg_file);
+  fs::remove_all(rdg_file);
+  GALOIS_LOG_ASSERT(make_result);
+}
+
+void
+TestLazyLoad() {
+  auto rdg_file = MakePFGFile("n1");
+  GALOIS_LOG_ASSERT(!rdg_file.empty());
+
+  auto make_result =
+      galois::graphs::PropertyFileGraph::MakeLazy(rdg_file, {"n1"}, {});
+  if (!make_result) {
+    fs::remove_all(rdg_file);
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      std::move(make_result.value());
+
+  // only the prefetched property is loaded
+  GALOIS_LOG_ASSERT(g->NodeProperties().size() == 1);
+  GALOIS_LOG_ASSERT(g->EdgeProperties().empty());
+  GALOIS_LOG_ASSERT(
+      g->UnloadedNodePropertyNames() == std::vector<std::string>{"n0"});
+  GALOIS_LOG_ASSERT(
+      g->UnloadedEdgePropertyNames() == std::vector<std::string>{"e0"});
+
+  // properties are faulted in on first access by name
+  GALOIS_LOG_ASSERT(g->NodeProperty("n0"));
+  GALOIS_LOG_ASSERT(g->NodeProperties().size() == 2);
+  GALOIS_LOG_ASSERT(g->UnloadedNodePropertyNames().empty());
+  GALOIS_LOG_ASSERT(!g->NodeProperty("no-such-property"));
+
+  GALOIS_LOG_ASSERT(g->EnsureAllPropertiesLoaded());
+  fs::remove_all(rdg_file);
+  GALOIS_LOG_ASSERT(g->EdgeProperties().size() == 1);
+  GALOIS_LOG_ASSERT(g->edge_schema()->field(0)->name() == "e0");
+}
+
+void
+TestLazyAddRemove() {
+  auto rdg_file = MakePFGFile("n1");
+  GALOIS_LOG_ASSERT(!rdg_file.empty());
+
+  auto make_result =
+      galois::graphs::PropertyFileGraph::MakeLazy(rdg_file, {"n1"}, {});
+  if (!make_result) {
+    fs::remove_all(rdg_file);
+    GALOIS_LOG_FATAL("making result: {}", make_result.error());
+  }
+  std::unique_ptr<galois::graphs::PropertyFileGraph> g =
+      std::move(make_result.value());
+  GALOIS_LOG_ASSERT(
+      g->UnloadedNodePropertyNames() == std::vector<std::string>{"n0"});
+
+  // a stored but unloaded name is taken
+  GALOIS_LOG_ASSERT(!g->AddNodeProperties(MakeTable<int32_t>("n0", 10)));
+  GALOIS_LOG_ASSERT(!g->AddEdgeProperties(MakeTable<int32_t>("e0", 10)));
+  GALOIS_LOG_ASSERT(g->NodeProperties().size() == 1);
+  GALOIS_LOG_ASSERT(g->EdgeProperties().empty());
+
+  // unloaded properties can be removed without loading them
+  GALOIS_LOG_ASSERT(g->RemoveNodeProperty("n0"));
+  GALOIS_LOG_ASSERT(g->RemoveEdgeProperty("e0"));
+  GALOIS_LOG_ASSERT(g->UnloadedNodePropertyNames().empty());
+  GALOIS_LOG_ASSERT(g->UnloadedEdgePropertyNames().empty());
+  GALOIS_LOG_ASSERT(!g->NodeProperty("n0"));
+  GALOIS_LOG_ASSERT(!g->RemoveNodeProperty("n0"));
+
+  // the name is free again
+  GALOIS_LOG_ASSERT(g->AddNodeProperties(MakeTable<int32_t>("n0", 10)));
+  GALOIS_LOG_ASSERT(g->NodeProperties().size() == 2);
+
+  // a removed unloaded property is not recorded again
+  g->MarkAllPropertiesPersistent();
+  if (auto res = g->Commit(command_line); !res) {
+    fs::remove_all(rdg_file);
+    GALOIS_LOG_FATAL("commit: {}", res.error());
+  }
+  g.reset();
+
+  auto reload_result = galois::graphs::PropertyFileGraph::Make(rdg_file);
+  fs::remove_all(rdg_file);
+  GALOIS_LOG_ASSERT(reload_result);
+  GALOIS_LOG_ASSERT(reload_result.value()->NodeProperties().size() == 2);
+  GALOIS_LOG_ASSERT(reload_result.value()->EdgeProperties().empty());
 }
 
 int
@@ -222,8 +1895,35 @@ main(int argc, char** argv) {
   command_line = cmdout.str();
 
   TestRoundTrip();
+  TestArrowIPCRoundTrip();
+  TestRowGroupSlices();
+  TestMultiChunkProperties();
+  TestDictionaryProperties();
+  TestPlanSlices();
+  TestReorderNodes();
+  TestCompressedRoundTrip();
+  TestWriteOptionsPersist();
+  TestGapEncodedRoundTrip();
+  TestCompressedTopologyValidation();
+  TestTransposeTopology();
+  TestEdgeTypeTopology();
+  TestCommitAsync();
+  TestCommitAsyncTopology();
+  TestSnapshotIsolation();
+  TestReopenCachedHeader();
+  TestRecreatedCachedHeader();
+  TestStreamingFileFrame();
+  TestWriteGroupLimits();
+  TestExternallyReplacedFile();
+  TestListManyFiles();
+  TestSequentialReadAhead();
+  TestFileViewResidencyBudget();
+  TestFileViewBudgetReads();
+  TestConcurrentLoadError();
   TestGarbageMetadata();
   TestSimplePGs();
+  TestLazyLoad();
+  TestLazyAddRemove();
 
   return 0;
 }
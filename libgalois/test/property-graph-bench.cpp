@@ -130,8 +130,46 @@ IterateBaseline(benchmark::State& state) {
   }
 }
 
+/// Sum a property through a view over num_chunks slices of one array, e.g.,
+/// as loaded from num_chunks row groups
+void
+ReadChunkedView(benchmark::State& state) {
+  auto [num_rows, num_chunks] = std::make_tuple(state.range(0), state.range(1));
+
+  arrow::Int64Builder builder;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    GALOIS_LOG_ASSERT(builder.Append(i).ok());
+  }
+  std::shared_ptr<arrow::Array> array;
+  GALOIS_LOG_ASSERT(builder.Finish(&array).ok());
+  arrow::ArrayVector chunks;
+  int64_t chunk_size = (num_rows + num_chunks - 1) / num_chunks;
+  for (int64_t start = 0; start < num_rows; start += chunk_size) {
+    chunks.emplace_back(array->Slice(start, chunk_size));
+  }
+  auto chunked = std::make_shared<arrow::ChunkedArray>(chunks);
+
+  auto view_result = galois::ConstructPropertyView<Field0>(chunked.get());
+  if (!view_result) {
+    GALOIS_LOG_FATAL("could not make view: {}", view_result.error());
+  }
+  const galois::PODPropertyView<DataType>& view = view_result.value();
+
+  for (auto _ : state) {
+    DataType sum = 0;
+    for (size_t i = 0, n = view.size(); i < n; ++i) {
+      sum += view.GetValue(i);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
 BENCHMARK(IterateBaseline)->Apply(MakeArguments);
 BENCHMARK(IterateProperty)->Apply(MakeArguments);
+BENCHMARK(ReadChunkedView)
+    ->Args({1 << 20, 1})
+    ->Args({1 << 20, 4})
+    ->Args({1 << 20, 64});
 
 }  // namespace
 
@@ -5,6 +5,8 @@
 #include "TestPropertyGraph.h"
 #include "galois/Logging.h"
 #include "galois/Properties.h"
+#include "galois/SharedMemSys.h"
+#include "galois/graphs/EdgeIndex.h"
 
 namespace gg = galois::graphs;
 
@@ -128,12 +130,105 @@ TestError1(size_t num_nodes, size_t line_width) {
       "Should return PropertyNotFound when node property doesn't exist.");
 }
 
+/// MixedPolicy gives every fourth node many random neighbors, some repeated,
+/// and the other nodes a few
+class MixedPolicy : public Policy {
+public:
+  std::vector<uint32_t> GenerateNeighbors(
+      size_t node_id, size_t num_nodes) override {
+    size_t degree = node_id % 4 == 0 ? 40 : 3;
+    std::vector<uint32_t> r;
+    for (size_t i = 0; i < degree; ++i) {
+      r.emplace_back(galois::RandomUniformInt(num_nodes));
+    }
+    return r;
+  }
+};
+
+uint64_t
+FirstEdge(const gg::GraphTopology& topology, uint32_t src, uint32_t dest) {
+  auto [begin, end] = topology.edge_range(src);
+  for (uint64_t e = begin; e < end; ++e) {
+    if (topology.out_dests->Value(e) == dest) {
+      return e;
+    }
+  }
+  return end;
+}
+
+template <typename FindFn>
+void
+CheckFindEdge(const gg::GraphTopology& topology, FindFn find) {
+  for (uint32_t src = 0; src < topology.num_nodes(); ++src) {
+    for (uint32_t dest = 0; dest < topology.num_nodes(); ++dest) {
+      uint64_t expected = FirstEdge(topology, src, dest);
+      uint64_t found = find(src, dest);
+      GALOIS_LOG_VASSERT(
+          found == expected, "{} -> {}: expected edge {} found {}", src, dest,
+          expected, found);
+    }
+  }
+}
+
+void
+TestEdgeIndex(size_t num_nodes) {
+  using NodeType = std::tuple<Field0>;
+  using EdgeType = std::tuple<Field0>;
+
+  constexpr uint64_t hub_degree = 16;
+
+  MixedPolicy policy;
+
+  std::unique_ptr<gg::PropertyFileGraph> g =
+      MakeFileGraph<DataType>(num_nodes, 1, &policy);
+
+  GALOIS_LOG_ASSERT(
+      gg::EdgeIndex::Make(g->topology(), 0).error() ==
+      galois::ErrorCode::InvalidArgument);
+
+  auto unsorted_result = gg::EdgeIndex::Make(g->topology(), hub_degree);
+  GALOIS_LOG_ASSERT(unsorted_result);
+  const gg::EdgeIndex& unsorted = unsorted_result.value();
+  GALOIS_LOG_ASSERT(unsorted.num_hubs() == (num_nodes + 3) / 4);
+  GALOIS_LOG_ASSERT(unsorted.has_sorted_copy());
+  CheckFindEdge(g->topology(), [&](uint32_t src, uint32_t dest) {
+    return unsorted.FindEdge(src, dest);
+  });
+
+  auto r = gg::PropertyGraph<NodeType, EdgeType>::Make(g.get());
+  if (!r) {
+    GALOIS_LOG_FATAL("could not make property graph: {}", r.error());
+  }
+  auto pg = std::move(r.value());
+  CheckFindEdge(g->topology(), [&](uint32_t src, uint32_t dest) {
+    return *pg.FindEdge(src, dest);
+  });
+  GALOIS_LOG_ASSERT(pg.BuildEdgeIndex(hub_degree));
+  CheckFindEdge(g->topology(), [&](uint32_t src, uint32_t dest) {
+    return *pg.FindEdge(src, dest);
+  });
+
+  auto sort_result = gg::SortAllEdgesByDest(g.get());
+  GALOIS_LOG_ASSERT(sort_result);
+
+  auto sorted_result = gg::EdgeIndex::Make(g->topology(), hub_degree);
+  GALOIS_LOG_ASSERT(sorted_result);
+  const gg::EdgeIndex& sorted = sorted_result.value();
+  GALOIS_LOG_ASSERT(!sorted.has_sorted_copy());
+  CheckFindEdge(g->topology(), [&](uint32_t src, uint32_t dest) {
+    return sorted.FindEdge(src, dest);
+  });
+}
+
 int
 main() {
+  galois::SharedMemSys sys;
+
   TestIterate1(10, 3);
   TestIterate3(10, 3);
   TestIterate4(10, 3);
   TestError1(10, 3);
+  TestEdgeIndex(100);
 
   return 0;
 }
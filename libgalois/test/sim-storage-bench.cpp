@@ -0,0 +1,136 @@
+/// Measure storing and loading property file graphs through the sim://
+/// storage stand-in, which makes local files behave like remote storage.
+///
+/// Graphs are written under a randomly named directory below the prefix given
+/// by the environment variable GALOIS_SIM_BENCH_PREFIX (default sim:///tmp).
+/// The simulated latency, bandwidth, jitter and concurrency are set with the
+/// TSUBA_SIM_* environment variables; see libtsuba/src/SimStorage.h.
+
+#include <unordered_set>
+
+#include <benchmark/benchmark.h>
+
+#include "TestPropertyGraph.h"
+#include "galois/Env.h"
+#include "galois/Logging.h"
+#include "galois/SharedMemSys.h"
+#include "galois/Uri.h"
+#include "galois/graphs/PropertyFileGraph.h"
+#include "tsuba/file.h"
+
+namespace gg = galois::graphs;
+
+namespace {
+
+using DataType = int64_t;
+constexpr size_t kNumProperties = 4;
+
+void
+MakeArguments(benchmark::internal::Benchmark* b) {
+  for (int i = 0; i < 2; ++i) {
+    long num_nodes = 1 << (i * 6 + 14);
+    b->Args({num_nodes});
+  }
+}
+
+std::string
+BenchPrefix() {
+  std::string prefix = "sim:///tmp";
+  galois::GetEnv("GALOIS_SIM_BENCH_PREFIX", &prefix);
+  return prefix;
+}
+
+std::string
+RandomRDGDir() {
+  auto uri_res = galois::Uri::MakeRand(BenchPrefix() + "/sim-storage-bench");
+  if (!uri_res) {
+    GALOIS_LOG_FATAL("making directory name: {}", uri_res.error());
+  }
+  return uri_res.value().string();
+}
+
+/// Remove everything written to rdg_dir
+void
+RemoveRDG(const std::string& rdg_dir) {
+  std::vector<std::string> files;
+  if (auto res = tsuba::FileListAsync(rdg_dir, &files).get(); !res) {
+    GALOIS_LOG_WARN("listing {}: {}", rdg_dir, res.error());
+    return;
+  }
+  std::unordered_set<std::string> to_delete(files.begin(), files.end());
+  if (auto res = tsuba::FileDelete(rdg_dir, to_delete); !res) {
+    GALOIS_LOG_WARN("deleting {}: {}", rdg_dir, res.error());
+  }
+}
+
+std::unique_ptr<gg::PropertyFileGraph>
+MakeGraph(long num_nodes) {
+  RandomPolicy policy{8};
+  std::unique_ptr<gg::PropertyFileGraph> g =
+      MakeFileGraph<DataType>(num_nodes, kNumProperties, &policy);
+  g->MarkAllPropertiesPersistent();
+  return g;
+}
+
+void
+StoreGraph(benchmark::State& state) {
+  std::unique_ptr<gg::PropertyFileGraph> g = MakeGraph(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::string rdg_dir = RandomRDGDir();
+    state.ResumeTiming();
+
+    if (auto res = g->Write(rdg_dir, "sim-storage-bench"); !res) {
+      RemoveRDG(rdg_dir);
+      GALOIS_LOG_FATAL("writing graph: {}", res.error());
+    }
+
+    state.PauseTiming();
+    RemoveRDG(rdg_dir);
+    state.ResumeTiming();
+  }
+}
+
+BENCHMARK(StoreGraph)
+    ->Apply(MakeArguments)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void
+LoadGraph(benchmark::State& state) {
+  std::string rdg_dir = RandomRDGDir();
+  if (auto res = MakeGraph(state.range(0))->Write(rdg_dir, "sim-storage-bench");
+      !res) {
+    RemoveRDG(rdg_dir);
+    GALOIS_LOG_FATAL("writing graph: {}", res.error());
+  }
+
+  for (auto _ : state) {
+    auto make_result = gg::PropertyFileGraph::Make(rdg_dir);
+    if (!make_result) {
+      RemoveRDG(rdg_dir);
+      GALOIS_LOG_FATAL("loading graph: {}", make_result.error());
+    }
+    benchmark::DoNotOptimize(make_result.value()->topology().num_edges());
+  }
+
+  RemoveRDG(rdg_dir);
+}
+
+BENCHMARK(LoadGraph)
+    ->Apply(MakeArguments)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+
+int
+main(int argc, char** argv) {
+  galois::SharedMemSys sys;
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+
+  return 0;
+}
@@ -3,16 +3,27 @@
 
 #include <cstdint>
 #include <future>
+#include <memory>
 #include <string>
 
 #include <parquet/arrow/writer.h>
 
 #include "galois/Logging.h"
 #include "galois/Result.h"
+#include "tsuba/Errors.h"
 
 namespace tsuba {
 
+/// A FileFrame is an output stream that is stored to a file.
+///
+/// By default, a FileFrame buffers everything written to it in memory until
+/// Persist or PersistAsync stores it. A FileFrame made with InitStreaming
+/// instead stores fixed-size parts while it is being written, so memory use is
+/// bounded and storing overlaps with producing the data. A streaming FileFrame
+/// that is never written more than one part is stored whole by Persist.
 class GALOIS_EXPORT FileFrame : public arrow::io::OutputStream {
+  struct Upload;
+
   std::string path_;
   uint8_t* map_start_;
   uint64_t map_size_;
@@ -20,54 +31,74 @@ class GALOIS_EXPORT FileFrame : public arrow::io::OutputStream {
   uint64_t cursor_;
   bool valid_ = false;
   bool synced_ = false;
+  // Set once a streaming FileFrame is stored or its upload is aborted; its
+  // data is gone after that
+  bool finished_ = false;
+  std::unique_ptr<Upload> upload_;
   galois::Result<void> GrowBuffer(int64_t accommodate);
+  arrow::Status WriteBuffer(const uint8_t* data, uint64_t nbytes);
+  galois::Result<void> StartPart();
+  galois::Result<void> FinishUpload();
+  void AbortUpload();
 
 public:
-  FileFrame() = default;
+  FileFrame();
   FileFrame(const FileFrame&) = delete;
   FileFrame& operator=(const FileFrame&) = delete;
-
-  FileFrame(FileFrame&& other) noexcept
-      : path_(other.path_),
-        map_start_(other.map_start_),
-        map_size_(other.map_size_),
-        region_size_(other.region_size_),
-        cursor_(other.cursor_),
-        valid_(other.valid_),
-        synced_(other.synced_) {
-    other.valid_ = false;
-  }
-
-  FileFrame& operator=(FileFrame&& other) noexcept {
-    if (&other != this) {
-      if (auto res = Destroy(); !res) {
-        GALOIS_LOG_ERROR("Destroy: {}", res.error());
-      }
-      path_ = other.path_;
-      map_start_ = other.map_start_;
-      map_size_ = other.map_size_;
-      region_size_ = other.region_size_;
-      cursor_ = other.cursor_;
-      synced_ = other.synced_;
-      valid_ = other.valid_;
-      other.valid_ = false;
-    }
-    return *this;
-  }
+  FileFrame(FileFrame&& other) noexcept;
+  FileFrame& operator=(FileFrame&& other) noexcept;
 
   ~FileFrame() override;
 
   galois::Result<void> Init(uint64_t reserve_size);
   galois::Result<void> Init() { return Init(1); }
+
+  /// Default size of the parts stored by a streaming FileFrame
+  static constexpr uint64_t kDefaultPartSize = UINT64_C(16) << 20;
+  /// Default bound on the memory used for parts that are being filled or
+  /// stored
+  static constexpr uint64_t kDefaultMaxInFlightBytes = kDefaultPartSize * 4;
+
+  /// InitStreaming prepares a FileFrame that stores what is written to it to
+  /// path in parts of part_size bytes. Writes block while parts totaling
+  /// max_in_flight_bytes are still being stored. Persist stores the last part
+  /// and waits for the others. Once Persist is called, the FileFrame cannot be
+  /// written or persisted again.
+  ///
+  /// The multipart upload only begins when the first part is full. If the
+  /// storage backend of path does not support multipart uploads, the
+  /// FileFrame then falls back to buffering everything, as if made by Init
+  /// and bound to path.
+  galois::Result<void> InitStreaming(
+      std::string_view path, uint64_t part_size = kDefaultPartSize,
+      uint64_t max_in_flight_bytes = kDefaultMaxInFlightBytes);
+
+  /// Set the file a buffered FileFrame is stored to. The path of a streaming
+  /// FileFrame is fixed by InitStreaming.
   void Bind(std::string_view filename);
 
+  /// True if this FileFrame stores parts as they are written
+  bool streaming() const { return upload_ != nullptr; }
+
+  /// Bytes of memory held for data that is not stored yet, including parts
+  /// that are still being stored
+  uint64_t buffered_bytes() const;
+
   galois::Result<void> Destroy();
 
   galois::Result<void> Persist();
   std::future<galois::Result<void>> PersistAsync();
 
+  /// The buffered contents of this FileFrame. Not available for streaming
+  /// FileFrames.
   template <typename T>
   galois::Result<T*> ptr() const {
+    if (finished_) {
+      return ErrorCode::InvalidArgument;
+    }
+    if (upload_) {
+      return ErrorCode::NotImplemented;
+    }
     return reinterpret_cast<T*>(map_start_); /* NOLINT */
   }
 
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <future>
+#include <string>
 #include <string_view>
 #include <unordered_set>
 #include <vector>
@@ -44,6 +45,11 @@ public:
   /// to the LocalStorage when no protocol on the URI is provided
   virtual uint32_t Priority() const { return 0; }
 
+  /// log2 of the size of the pages that FileViews fetch from this storage.
+  /// Storage with high per-request latency should use larger pages so that
+  /// fewer requests are needed.
+  virtual uint8_t PageShift() const { return 20; /* 1M */ }
+
   // get on future can potentially block (bulk synchronous parallel)
   virtual std::future<galois::Result<void>> PutAsync(
       const std::string& uri, const uint8_t* data, uint64_t size) = 0;
@@ -56,6 +62,43 @@ public:
   virtual galois::Result<void> Delete(
       const std::string& directory,
       const std::unordered_set<std::string>& files) = 0;
+
+  /// Map the first size bytes of uri directly into memory. The mapping is
+  /// copy-on-write: pages are readable and writable, but writes are never
+  /// written back to storage. Backends that cannot map their objects return
+  /// ErrorCode::NotImplemented, in which case callers should fall back to
+  /// GetAsync. The caller owns the mapping and releases it with munmap.
+  virtual galois::Result<uint8_t*> Mmap(const std::string& uri, uint64_t size);
+
+  /// Multipart uploads store an object as a sequence of parts so that it can
+  /// be written while it is still being produced. Every part except the last
+  /// is exactly part_size bytes. Parts are numbered from zero and may be put
+  /// concurrently and in any order. The object is only visible at uri after
+  /// MultipartComplete succeeds.
+  ///
+  /// Backends that do not support multipart uploads return
+  /// ErrorCode::NotImplemented from MultipartBegin, in which case callers
+  /// should fall back to PutAsync.
+  ///
+  /// \returns an upload id to pass to the other Multipart methods
+  virtual galois::Result<std::string> MultipartBegin(
+      const std::string& uri, uint64_t part_size);
+
+  /// Start storing part part_number of an upload. The caller must keep data
+  /// alive until the returned future is ready.
+  virtual std::future<galois::Result<void>> MultipartPutAsync(
+      const std::string& uri, const std::string& upload_id,
+      uint64_t part_number, const uint8_t* data, uint64_t size);
+
+  /// Make the object at uri the concatenation of parts [0, num_parts). All
+  /// parts must have been stored successfully.
+  virtual galois::Result<void> MultipartComplete(
+      const std::string& uri, const std::string& upload_id,
+      uint64_t num_parts);
+
+  /// Discard an upload and any parts stored so far
+  virtual galois::Result<void> MultipartAbort(
+      const std::string& uri, const std::string& upload_id);
 };
 
 /// RegisterFileStorage adds a file storage backend to the tsuba library. File
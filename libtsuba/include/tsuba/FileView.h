@@ -3,7 +3,9 @@
 
 #include <cstdint>
 #include <future>
+#include <memory>
 #include <string>
+#include <utility>
 
 #include <parquet/arrow/reader.h>
 
@@ -13,6 +15,54 @@
 
 namespace tsuba {
 
+/// A ReadAheadPolicy decides what a FileView fetches ahead of the reads made
+/// through it
+class GALOIS_EXPORT ReadAheadPolicy {
+public:
+  virtual ~ReadAheadPolicy();
+
+  /// Called for each read of [start, start + size) of a file of file_size
+  /// bytes. Returns the range [begin, end) to fetch in the background; an
+  /// empty range fetches nothing.
+  virtual std::pair<uint64_t, uint64_t> NextRange(
+      uint64_t start, uint64_t size, uint64_t file_size) = 0;
+};
+
+/// SequentialReadAhead detects sequential reads and doubles its window, up to
+/// max_window bytes, for each read that continues where the previous one
+/// ended. Any other read resets the window to slightly more than the size of
+/// the read, which suits Parquet files, whose consecutive row groups are
+/// roughly the same size.
+///
+/// The default max_window can be set with the environment variable
+/// TSUBA_READ_AHEAD_MAX_MB.
+class GALOIS_EXPORT SequentialReadAhead : public ReadAheadPolicy {
+  uint64_t max_window_;
+  uint64_t window_{0};
+  uint64_t last_end_{0};
+
+public:
+  static constexpr uint64_t kDefaultMaxWindow = UINT64_C(64) << 20;
+
+  SequentialReadAhead();
+  explicit SequentialReadAhead(uint64_t max_window)
+      : max_window_(max_window) {}
+
+  std::pair<uint64_t, uint64_t> NextRange(
+      uint64_t start, uint64_t size, uint64_t file_size) override;
+};
+
+/// A FileView is a read-only view of a file in storage. Its regions are
+/// fetched on demand, and ahead of sequential reads as decided by its
+/// ReadAheadPolicy.
+///
+/// FileViews record these tsuba stats:
+///   FileViewPrefetchBytes: bytes fetched ahead of reads
+///   FileViewPrefetchWastedBytes: prefetched bytes that were never read when
+///     the view was unbound
+///   FileViewStalls: reads that waited for data from storage
+///   FileViewStallMicroseconds: time reads waited for data from storage
+///   FileViewEvictedBytes: bytes released to stay within a residency budget
 class GALOIS_EXPORT FileView : public arrow::io::RandomAccessFile {
   struct FillingRange {
     uint64_t first_page;
@@ -27,8 +77,19 @@ class GALOIS_EXPORT FileView : public arrow::io::RandomAccessFile {
   int64_t mem_start_;
   std::string filename_;
   bool valid_ = false;
+  // true when map_start_ maps the file itself rather than anonymous memory
+  // that is filled by copying from storage
+  bool mapped_ = false;
   std::vector<uint64_t> filling_;
+  // pages that were prefetched and have not been read yet
+  std::vector<uint64_t> prefetched_;
+  // pages used since the clock hand last passed them
+  std::vector<uint64_t> referenced_;
+  uint64_t resident_pages_{0};
+  uint64_t clock_hand_{0};
+  uint64_t residency_budget_{0};
   std::unique_ptr<std::vector<FillingRange>> fetches_;
+  std::unique_ptr<ReadAheadPolicy> read_ahead_;
 
 public:
   FileView() = default;
@@ -43,8 +104,15 @@ public:
         mem_start_(other.mem_start_),
         filename_(std::move(other.filename_)),
         valid_(other.valid_),
+        mapped_(other.mapped_),
         filling_(std::move(other.filling_)),
-        fetches_(std::move(other.fetches_)) {
+        prefetched_(std::move(other.prefetched_)),
+        referenced_(std::move(other.referenced_)),
+        resident_pages_(other.resident_pages_),
+        clock_hand_(other.clock_hand_),
+        residency_budget_(other.residency_budget_),
+        fetches_(std::move(other.fetches_)),
+        read_ahead_(std::move(other.read_ahead_)) {
     other.valid_ = false;
   }
 
@@ -60,9 +128,16 @@ public:
       mem_start_ = other.mem_start_;
       filename_ = std::move(other.filename_);
       valid_ = other.valid_;
+      mapped_ = other.mapped_;
       filling_ = std::move(other.filling_);
+      prefetched_ = std::move(other.prefetched_);
+      referenced_ = std::move(other.referenced_);
+      resident_pages_ = other.resident_pages_;
+      clock_hand_ = other.clock_hand_;
+      residency_budget_ = other.residency_budget_;
       fetches_ =
           std::unique_ptr<std::vector<FillingRange>>(std::move(other.fetches_));
+      read_ahead_ = std::move(other.read_ahead_);
       other.valid_ = false;
     }
     return *this;
@@ -80,6 +155,15 @@ public:
   /// Calls to Read will handle asynchronous
   /// reads internally, but if you intend to use ptr(), you should pass
   /// resolve=true.
+  ///
+  /// Regions are fetched in pages whose size depends on the storage backend;
+  /// see FilePageShift.
+  ///
+  /// If the storage backend supports it (e.g., local files), the file is
+  /// mapped directly and filling a region only hints the kernel to read it
+  /// ahead; otherwise the file is copied into anonymous memory as regions are
+  /// filled. Setting the environment variable TSUBA_DO_NOT_MMAP forces the
+  /// copying behavior.
   galois::Result<void> Bind(
       std::string_view filename, uint64_t begin, uint64_t end, bool resolve);
   galois::Result<void> Bind(
@@ -92,8 +176,48 @@ public:
 
   galois::Result<void> Fill(uint64_t begin, uint64_t end, bool resolve);
 
+  /// Replace the read-ahead policy, which is a SequentialReadAhead by
+  /// default. Bind keeps the current policy.
+  void set_read_ahead_policy(std::unique_ptr<ReadAheadPolicy> policy) {
+    read_ahead_ = std::move(policy);
+  }
+
+  /// Limit the memory holding the file to about budget bytes; 0, the default,
+  /// means no limit. When filling a region would exceed the budget, pages
+  /// that have not been used recently are released and fetched again when
+  /// they are next needed, so a file larger than memory can be traversed
+  /// with ResidentPtr. Regions being filled are never released, so the
+  /// budget is exceeded if a single fill is larger than it.
+  ///
+  /// With a budget, pointers from ptr() and valid_ptr() may refer to
+  /// released memory, writes through them may be lost, and Read(int64_t)
+  /// returns copies rather than views of the file.
+  void set_residency_budget(uint64_t budget) { residency_budget_ = budget; }
+  uint64_t residency_budget() const { return residency_budget_; }
+
+  /// Number of bytes of the file currently held in memory (or, if Mapped(),
+  /// requested from the page cache)
+  uint64_t resident_bytes() const { return resident_pages_ << page_shift_; }
+
+  /// Fetch [begin, end) if it is not in memory and wait for it
+  galois::Result<void> EnsureResident(uint64_t begin, uint64_t end);
+
+  /// Like ptr() but makes the count values starting at offset resident
+  /// first. The pointer is valid until the next call that fills this view,
+  /// which may release it to stay within the residency budget.
+  template <typename T>
+  galois::Result<const T*> ResidentPtr(uint64_t offset, uint64_t count) {
+    if (auto res = EnsureResident(offset, offset + count * sizeof(T)); !res) {
+      return res.error();
+    }
+    return ptr<T>(offset);
+  }
+
   bool Valid() const { return valid_; }
 
+  /// \returns true if the view maps the file directly rather than a copy of it
+  bool Mapped() const { return mapped_; }
+
   galois::Result<void> Unbind();
 
   /// Be very careful with this function. It is the caller's responsibility to
@@ -163,11 +287,32 @@ private:
   galois::Result<void> MarkFilled(
       uint64_t* bitmap, uint64_t begin, uint64_t end);
 
-  // Resolve all outstanding reads that overlap with the range [cursor_, nbytes]
-  galois::Result<void> Resolve(int64_t start, int64_t size);
+  // Fill [begin, end). Making room for it never releases the pages of the
+  // byte range [pin_begin, pin_end), e.g., a read in progress.
+  galois::Result<void> DoFill(
+      uint64_t begin, uint64_t end, bool resolve, bool prefetch,
+      uint64_t pin_begin, uint64_t pin_end);
+
+  // Note that the pages in [start, start + size) have been read: they are no
+  // longer only prefetched, and they were recently used
+  void MarkRead(int64_t start, int64_t size);
+
+  // Release pages not used recently, other than those in [keep_first,
+  // keep_last], in [pin_first, pin_last] or still being fetched, until the
+  // view is within its residency budget
+  galois::Result<void> Evict(
+      uint64_t keep_first, uint64_t keep_last, uint64_t pin_first,
+      uint64_t pin_last);
+  bool InFlight(uint64_t page) const;
+
+  // Resolve all outstanding reads that overlap with the range [start, start +
+  // size). Waiting for storage counts as a stall if record_stalls is true.
+  galois::Result<void> Resolve(
+      int64_t start, int64_t size, bool record_stalls = true);
 
-  // Start asynchronously fetching data that we think we might need from storage
-  // @start and @size give the location and range of the previous read
+  // Start asynchronously fetching data that we think we might need from
+  // storage, as chosen by read_ahead_. @start and @size give the location and
+  // range of the current read
   galois::Result<void> PreFetch(int64_t start, int64_t size);
 };
 }  // namespace tsuba
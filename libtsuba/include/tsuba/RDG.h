@@ -4,9 +4,11 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include <arrow/api.h>
 #include <arrow/chunked_array.h>
+#include <arrow/util/compression.h>
 #include <nlohmann/json.hpp>
 
 #include "galois/Result.h"
@@ -26,6 +28,54 @@ class RDGMeta;
 class RDGCore;
 struct PropStorageInfo;
 
+/// How a property is laid out in storage
+enum class PropStorageFormat {
+  /// Encoded and compressed; smallest, but must be decoded (copied) on load
+  Parquet,
+  /// Uncompressed Arrow IPC file; mapped and used in place on load
+  ArrowIPC,
+};
+
+/// Options that control how properties are written when an RDG is stored
+struct PropWriteOptions {
+  /// Maximum number of rows in a Parquet row group. Loading a slice of a
+  /// property reads only the row groups that overlap it, so smaller row groups
+  /// mean less wasted I/O for RDGSlice at some cost in compression.
+  int64_t row_group_size{int64_t{1} << 20};
+  /// Codec used to compress Parquet column data. Arrow IPC files are never
+  /// compressed so that they can be used in place. The codec is recorded in
+  /// each file's metadata, so readers do not need to be told what was used.
+  ///
+  /// The supported Arrow build (config/conanfile.py) has snappy, gzip and
+  /// brotli. Other codecs, e.g., zstd and lz4, are only available if Arrow
+  /// was built with them; see ValidatePropWriteOptions.
+  arrow::Compression::type codec{arrow::Compression::UNCOMPRESSED};
+  /// Codec specific compression level
+  int compression_level{arrow::util::kUseDefaultCompressionLevel};
+  /// Dictionary encode Parquet columns. Writers fall back to plain encoding
+  /// when a dictionary grows too large. This only affects how values are
+  /// encoded in the file: properties are loaded as arrow::DictionaryArrays
+  /// if, and only if, they were DictionaryArrays when they were stored.
+  bool dictionary{true};
+};
+
+inline bool
+operator==(const PropWriteOptions& a, const PropWriteOptions& b) {
+  return a.row_group_size == b.row_group_size && a.codec == b.codec &&
+         a.compression_level == b.compression_level &&
+         a.dictionary == b.dictionary;
+}
+
+inline bool
+operator!=(const PropWriteOptions& a, const PropWriteOptions& b) {
+  return !(a == b);
+}
+
+/// Check that properties can be written with options in this build, e.g.,
+/// that the codec was compiled into Arrow and is supported by Parquet
+GALOIS_EXPORT galois::Result<void> ValidatePropWriteOptions(
+    const PropWriteOptions& options);
+
 class GALOIS_EXPORT RDG {
 public:
   RDG(const RDG& no_copy) = delete;
@@ -48,6 +98,33 @@ public:
       RDGHandle handle, const std::string& command_line,
       std::unique_ptr<FileFrame> ff = nullptr);
 
+  /// Snapshot prepares to store this RDG at `handle` while this RDG keeps
+  /// changing. The returned RDG shares the property tables of this one, which
+  /// are immutable, and copies where they are stored, so the snapshot can be
+  /// stored on another thread while properties are added to or removed from
+  /// this RDG. The values of shared properties must not be modified in place
+  /// until that store finishes.
+  ///
+  /// Pass new_topology if the snapshot will be stored with an updated
+  /// topology. Otherwise, a stored topology that has to be copied to handle's
+  /// location is read into the snapshot.
+  galois::Result<RDG> Snapshot(RDGHandle handle, bool new_topology);
+
+  /// After `snapshot` was stored, record where it wrote the properties and
+  /// topology arrays that this RDG has not changed since, so that the next
+  /// Store does not write them again.
+  ///
+  /// Pass adopt_topology if the snapshot was stored with a new topology and
+  /// the topology of this RDG has not changed since. This RDG then refers to
+  /// the new topology file, and its topology file storage is bound to it if
+  /// it was unbound.
+  void AdoptStoredLocations(
+      const RDG& snapshot, const std::string& command_line,
+      bool adopt_topology);
+
+  /// Add the columns of table as new node (edge) properties. Returns
+  /// ErrorCode::Exists if a property with the same name is already loaded or
+  /// is stored but not loaded yet.
   galois::Result<void> AddNodeProperties(
       const std::shared_ptr<arrow::Table>& table);
 
@@ -57,6 +134,18 @@ public:
   galois::Result<void> RemoveNodeProperty(uint32_t i);
   galois::Result<void> RemoveEdgeProperty(uint32_t i);
 
+  /// Replace the values of all node and edge properties, e.g., because nodes
+  /// were relabeled. The tables must have the same schemas as node_table()
+  /// and edge_table(). The properties keep their storage format, options and
+  /// persistence, but they are written again by the next Store.
+  ///
+  /// A caller that replaces the topology at the same time sets
+  /// unbind_topology to unbind the topology file storage too. Nothing
+  /// changes unless both tables fit and unbinding succeeds.
+  galois::Result<void> ReplaceProperties(
+      const std::shared_ptr<arrow::Table>& node_table,
+      const std::shared_ptr<arrow::Table>& edge_table, bool unbind_topology);
+
   void MarkAllPropertiesPersistent();
 
   galois::Result<void> MarkNodePropertiesPersistent(
@@ -64,6 +153,24 @@ public:
   galois::Result<void> MarkEdgePropertiesPersistent(
       const std::vector<std::string>& persist_edge_props);
 
+  /// Choose how the named property is laid out the next time this RDG is
+  /// stored. Changing the format of an already stored property causes it to be
+  /// rewritten. The default format is PropStorageFormat::Parquet.
+  galois::Result<void> SetNodePropertyStorageFormat(
+      const std::string& name, PropStorageFormat format);
+  galois::Result<void> SetEdgePropertyStorageFormat(
+      const std::string& name, PropStorageFormat format);
+
+  /// Write the named property with options rather than the RDG wide
+  /// prop_write_options() the next time this RDG is stored. Like changing the
+  /// storage format, this causes an already stored property to be rewritten.
+  /// The choice is recorded in the part header, so it also applies when the
+  /// property is rewritten after the RDG is loaded again.
+  galois::Result<void> SetNodePropertyWriteOptions(
+      const std::string& name, const PropWriteOptions& options);
+  galois::Result<void> SetEdgePropertyWriteOptions(
+      const std::string& name, const PropWriteOptions& options);
+
   /// Explain to graph how it is derived from previous version
   void AddLineage(const std::string& command_line);
 
@@ -72,8 +179,52 @@ public:
       RDGHandle handle, const std::vector<std::string>* node_props = nullptr,
       const std::vector<std::string>* edge_props = nullptr);
 
+  /// Load the RDG described by the metadata in handle, but only load the
+  /// named node and edge properties. The remaining properties stay in storage
+  /// until they are requested with LoadNodeProperty or LoadEdgeProperty.
+  static galois::Result<RDG> MakeLazy(
+      RDGHandle handle, const std::vector<std::string>& node_props,
+      const std::vector<std::string>& edge_props);
+
+  /// Load a property that was deferred by MakeLazy. It is appended to the
+  /// node (edge) table.
+  galois::Result<void> LoadNodeProperty(const std::string& name);
+  galois::Result<void> LoadEdgeProperty(const std::string& name);
+
+  /// Load all properties that were deferred by MakeLazy
+  galois::Result<void> LoadAllProperties();
+
+  /// Names of the properties that are stored but have not been loaded yet
+  std::vector<std::string> UnloadedNodePropertyNames() const;
+  std::vector<std::string> UnloadedEdgePropertyNames() const;
+
+  /// Remove a property that is stored but has not been loaded yet, so that
+  /// the next Store does not record it
+  galois::Result<void> RemoveUnloadedNodeProperty(const std::string& name);
+  galois::Result<void> RemoveUnloadedEdgeProperty(const std::string& name);
+
   galois::Result<void> UnbindTopologyFileStorage();
 
+  /// Topology arrays are named arrays derived from the topology, e.g., its
+  /// transpose. They are stored alongside the topology as Arrow IPC files, so
+  /// they are used in place, but they are only loaded when requested.
+  ///
+  /// SetTopologyArray sets the named array, replacing any array with the same
+  /// name. It is written by the next Store.
+  galois::Result<void> SetTopologyArray(
+      const std::string& name,
+      const std::shared_ptr<arrow::ChunkedArray>& array);
+
+  /// Return the named topology array, loading it if it is stored but not
+  /// loaded yet. Returns PropertyNotFound if there is no such array.
+  galois::Result<std::shared_ptr<arrow::ChunkedArray>> LoadTopologyArray(
+      const std::string& name);
+
+  bool HasTopologyArray(const std::string& name) const;
+
+  /// Forget all topology arrays, e.g., because the topology changed
+  void ClearTopologyArrays();
+
   void AddMirrorNodes(std::shared_ptr<arrow::ChunkedArray>&& a) {
     mirror_nodes_.emplace_back(std::move(a));
   }
@@ -121,6 +272,12 @@ public:
   const PartitionMetadata& part_metadata() const;
   void set_part_metadata(const PartitionMetadata& metadata);
 
+  const PropWriteOptions& prop_write_options() const;
+  /// Set the options used for properties written by future stores. Returns
+  /// an error if the options are not usable in this build. Like per property
+  /// options, they are recorded in the part header and kept across loads.
+  galois::Result<void> SetPropWriteOptions(const PropWriteOptions& options);
+
   const FileView& topology_file_storage() const;
 
 private:
@@ -132,7 +289,7 @@ private:
 
   static galois::Result<RDG> Make(
       const RDGMeta& meta, const std::vector<std::string>* node_props,
-      const std::vector<std::string>* edge_props);
+      const std::vector<std::string>* edge_props, bool defer_others = false);
 
   galois::Result<void> AddPartitionMetadataArray(
       const std::shared_ptr<arrow::Table>& table);
@@ -140,6 +297,11 @@ private:
   galois::Result<std::vector<tsuba::PropStorageInfo>> WritePartArrays(
       const galois::Uri& dir, tsuba::WriteGroup* desc);
 
+  galois::Result<void> WriteTopologyArrays(
+      const galois::Uri& dir, tsuba::WriteGroup* desc);
+
+  galois::Result<void> LoadAllTopologyArrays();
+
   galois::Result<void> DoStore(
       RDGHandle handle, const std::string& command_line,
       std::unique_ptr<WriteGroup> desc);
@@ -153,6 +315,9 @@ private:
   std::vector<std::shared_ptr<arrow::ChunkedArray>> mirror_nodes_;
   std::vector<std::shared_ptr<arrow::ChunkedArray>> master_nodes_;
   std::shared_ptr<arrow::ChunkedArray> local_to_global_vector_;
+  /// Loaded topology arrays by name
+  std::unordered_map<std::string, std::shared_ptr<arrow::ChunkedArray>>
+      topology_arrays_;
 
   /// name of the graph that was used to load this RDG
   galois::Uri rdg_dir_;
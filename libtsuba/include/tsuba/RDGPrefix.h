@@ -2,14 +2,24 @@
 #define GALOIS_LIBTSUBA_TSUBA_RDGPREFIX_H_
 
 #include <cstdint>
+#include <vector>
 
 #include "tsuba/FileView.h"
+#include "tsuba/RDGSlice.h"
 #include "tsuba/tsuba.h"
 
 namespace tsuba {
 
 class RDGMeta;
 
+/// How much a node and an edge count toward the size of a slice, e.g.,
+/// {0, 1} balances edges, {1, 0} balances nodes and {alpha, 1} balances
+/// alpha * nodes + edges
+struct SliceWeights {
+  double node_weight{0};
+  double edge_weight{1};
+};
+
 /// An RDGPrefix loads the header information from the topology CSR, this is
 /// used by the partitioner to avoid downloading the whole RDG to make
 /// partitioning decisions
@@ -50,6 +60,27 @@ public:
     return std::vector<uint64_t>(out_indexes + first, out_indexes + second);
   }
 
+  /// Number of edges of nodes [0, n)
+  uint64_t edges_before(uint64_t n) const {
+    return n == 0 ? 0 : prefix_->out_indexes[n - 1];
+  }
+
+  /// The slice of nodes [first_node, last_node), their edges and the part
+  /// of the topology file that holds them. Node indexes come before edge
+  /// destinations in the file, so the topology range runs from the index of
+  /// first_node to the destination of the last edge of the slice.
+  RDGSlice::SliceArg MakeSliceArg(
+      uint64_t first_node, uint64_t last_node) const;
+
+  /// Cut the nodes into num_slices contiguous slices of about equal weight.
+  ///
+  /// Cuts are found by binary search over the node indexes, so only the
+  /// pages of the prefix that the searches touch are read. A slice is never
+  /// cut inside the edges of a node, so a node with many edges can make its
+  /// slice heavier than the others; slices may also be empty.
+  galois::Result<std::vector<RDGSlice::SliceArg>> PlanSlices(
+      uint32_t num_slices, const SliceWeights& weights = SliceWeights()) const;
+
 private:
   RDGPrefix(FileView&& prefix_storage, uint64_t view_offset)
       : prefix_storage_(std::move(prefix_storage)),
@@ -0,0 +1,34 @@
+#ifndef GALOIS_LIBTSUBA_TSUBA_STATS_H_
+#define GALOIS_LIBTSUBA_TSUBA_STATS_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "galois/config.h"
+
+namespace tsuba {
+
+/// tsuba keeps a small set of named, process-wide statistics about its I/O
+/// (bytes read, time spent in storage, etc.). tsuba sits below the galois
+/// statistics manager, so it is up to the owner of that manager (e.g.,
+/// galois::SharedMemSys) to report them.
+
+/// Add value to the integer statistic name
+GALOIS_EXPORT void StatAdd(const std::string& name, int64_t value);
+
+/// Set the floating point statistic name to value, e.g., for rates that are
+/// derived from other statistics
+GALOIS_EXPORT void StatSet(const std::string& name, double value);
+
+/// Call int_cb or fp_cb for each recorded statistic in name order
+GALOIS_EXPORT void ForEachStat(
+    const std::function<void(const std::string&, int64_t)>& int_cb,
+    const std::function<void(const std::string&, double)>& fp_cb);
+
+/// Forget all recorded statistics
+GALOIS_EXPORT void ResetStats();
+
+}  // namespace tsuba
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef GALOIS_LIBTSUBA_TSUBA_WRITEGROUP_H_
 #define GALOIS_LIBTSUBA_TSUBA_WRITEGROUP_H_
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <future>
 #include <list>
 #include <memory>
@@ -13,39 +16,93 @@ namespace tsuba {
 
 /// Track multiple, outstanding async writes and provide a mechanism to ensure
 /// that they have all completed
+///
+/// A WriteGroup bounds the number of writes and the number of buffered bytes
+/// it has in flight. Starting a write that would exceed either bound blocks
+/// until earlier writes finish, so the data of a large commit is not all held
+/// in memory at once and storage is not flooded with concurrent puts. A write
+/// larger than the byte bound is started once nothing else is in flight.
+///
+/// Each write runs on its own thread, which is only started once the write
+/// fits within the bounds, so the number of writer threads is bounded too.
+///
+/// The default bounds can be set with the environment variables
+/// TSUBA_WRITE_MAX_OPS and TSUBA_WRITE_MAX_MB.
 class WriteGroup {
   struct AsyncOp {
     std::future<galois::Result<void>> result;
     std::string location;
+    uint64_t size;
   };
 
   std::string tag_;
+  // Declared before pending_ops_ so that they outlive the ops that update
+  // them
+  std::atomic<uint64_t> running_ops_{0};
+  std::atomic<uint64_t> peak_running_ops_{0};
   std::list<AsyncOp> pending_ops_;
 
-  WriteGroup(std::string tag) : tag_(std::move(tag)){};
+  uint64_t max_in_flight_bytes_;
+  uint64_t max_in_flight_ops_;
+  uint64_t in_flight_bytes_{0};
+
+  // Results of ops that finished before Finish
+  uint64_t total_ops_{0};
+  uint64_t total_bytes_{0};
+  uint32_t errors_{0};
+  galois::Result<void> status_{galois::ResultSuccess()};
+  std::chrono::steady_clock::time_point start_;
+
+  WriteGroup(
+      std::string tag, uint64_t max_in_flight_bytes,
+      uint64_t max_in_flight_ops)
+      : tag_(std::move(tag)),
+        max_in_flight_bytes_(max_in_flight_bytes),
+        max_in_flight_ops_(max_in_flight_ops),
+        start_(std::chrono::steady_clock::now()) {}
 
   /// Add future to the list of futures this descriptor will wait for, note
   /// the file name for debugging
-  void AddOp(std::future<galois::Result<void>> future, std::string file);
+  void AddOp(
+      std::future<galois::Result<void>> future, std::string file,
+      uint64_t size);
+
+  /// Run op on the calling thread, counting it as running and recording its
+  /// latency
+  galois::Result<void> RunOp(const std::function<galois::Result<void>()>& op);
+
+  /// Wait for op and record its result
+  void Retire(std::list<AsyncOp>::iterator op);
+
+  /// Block until an op of size bytes can start without exceeding the bounds
+  void WaitForRoom(uint64_t size);
 
 public:
+  static constexpr uint64_t kDefaultMaxInFlightOps = 32;
+  static constexpr uint64_t kDefaultMaxInFlightBytes = UINT64_C(2) << 30;
+
   /// Build a descriptor with a tag. If running with multiple hosts, Make should
   /// be Called BSP style and all hosts will have the same tag
   static galois::Result<std::unique_ptr<WriteGroup>> Make();
 
+  /// Like Make() but with explicit bounds on in flight writes; 0 means no
+  /// bound
+  static galois::Result<std::unique_ptr<WriteGroup>> Make(
+      uint64_t max_in_flight_bytes, uint64_t max_in_flight_ops);
+
   /// Return a random tag that uniquely identifies this op
   const std::string& tag() const { return tag_; }
 
   /// Wait until all operations this descriptor knows about have completed
   galois::Result<void> Finish();
 
-  /// Start async store op, we hold onto the data until op finishes
+  /// Start async store op, we hold onto the data until op finishes. May block
+  /// until earlier ops finish.
   void StartStore(std::shared_ptr<FileFrame> ff);
 
-  /// Start async store op, caller responsible for keeping buffer live
-  void StartStore(const std::string& file, const uint8_t* buf, uint64_t size) {
-    AddOp(FileStoreAsync(file, buf, size), file);
-  }
+  /// Start async store op, caller responsible for keeping buffer live. May
+  /// block until earlier ops finish.
+  void StartStore(const std::string& file, const uint8_t* buf, uint64_t size);
 };
 
 }  // namespace tsuba
@@ -29,6 +29,9 @@ RoundUpToBlock(T val) {
 
 struct StatBuf {
   uint64_t size{UINT64_C(0)};
+  // last modification time in nanoseconds since the epoch, or 0 if the
+  // storage does not report one
+  uint64_t mtime_ns{UINT64_C(0)};
 };
 
 // Returns an error file filename does not exist
@@ -61,6 +64,36 @@ GALOIS_EXPORT std::future<galois::Result<void>> FileGetAsync(
     const std::string& filename, uint8_t* result_buffer, uint64_t begin,
     uint64_t size);
 
+/// Map the first @size bytes of @uri directly into memory with copy-on-write
+/// semantics. Returns ErrorCode::NotImplemented if the storage backend of @uri
+/// does not support mapping; callers should fall back to FileGetAsync. The
+/// returned region must be released with munmap.
+GALOIS_EXPORT galois::Result<uint8_t*> FileMmap(
+    const std::string& uri, uint64_t size);
+
+/// Start a multipart upload to @uri; see FileStorage::MultipartBegin. Returns
+/// ErrorCode::NotImplemented if the storage backend of @uri does not support
+/// multipart uploads; callers should fall back to FileStoreAsync.
+GALOIS_EXPORT galois::Result<std::string> FileMultipartBegin(
+    const std::string& uri, uint64_t part_size);
+
+/// Start storing part @part_number of a multipart upload. @data must stay
+/// alive until the returned future is ready.
+GALOIS_EXPORT std::future<galois::Result<void>> FileMultipartPutAsync(
+    const std::string& uri, const std::string& upload_id, uint64_t part_number,
+    const uint8_t* data, uint64_t size);
+
+/// Finish a multipart upload of @num_parts parts
+GALOIS_EXPORT galois::Result<void> FileMultipartComplete(
+    const std::string& uri, const std::string& upload_id, uint64_t num_parts);
+
+/// Abandon a multipart upload
+GALOIS_EXPORT galois::Result<void> FileMultipartAbort(
+    const std::string& uri, const std::string& upload_id);
+
+/// log2 of the page size FileViews use for @uri; see FileStorage::PageShift
+GALOIS_EXPORT uint8_t FilePageShift(const std::string& uri);
+
 /// List the set of files in a directory
 /// \param directory is URI whose contents are listed. It can be
 /// Async return type allows this function to be called repeatedly (and
@@ -1,28 +1,126 @@
 #include "AddTables.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <optional>
+
+#include <arrow/compute/api.h>
+#include <arrow/ipc/reader.h>
+
+#include "galois/Env.h"
 #include "tsuba/Errors.h"
 #include "tsuba/FileView.h"
+#include "tsuba/Stats.h"
 
 template <typename T>
 using Result = galois::Result<T>;
 
 namespace {
 
+Result<void>
+CheckSchema(
+    const std::shared_ptr<arrow::Schema>& schema,
+    const std::string& expected_name) {
+  if (schema->num_fields() != 1) {
+    GALOIS_LOG_DEBUG("expected 1 field found {} instead", schema->num_fields());
+    return tsuba::ErrorCode::InvalidArgument;
+  }
+
+  if (schema->field(0)->name() != expected_name) {
+    GALOIS_LOG_DEBUG(
+        "expected {} found {} instead", expected_name,
+        schema->field(0)->name());
+    return tsuba::ErrorCode::InvalidArgument;
+  }
+  return galois::ResultSuccess();
+}
+
+/// Whether a Parquet property can be read as an arrow::DictionaryArray
+/// directly: it holds strings (or binary values), not lists of them
+bool
+CanReadDictionary(const parquet::FileMetaData& md) {
+  if (md.schema()->num_columns() != 1) {
+    return false;
+  }
+  const parquet::ColumnDescriptor* column = md.schema()->Column(0);
+  return column->physical_type() == parquet::Type::BYTE_ARRAY &&
+         column->max_repetition_level() == 0;
+}
+
+/// Open a single column Parquet file. If dictionary is set, string columns
+/// are read as arrow::DictionaryArrays rather than decoded.
+Result<std::unique_ptr<parquet::arrow::FileReader>>
+OpenParquet(const std::shared_ptr<tsuba::FileView>& fv, bool dictionary) {
+  parquet::arrow::FileReaderBuilder builder;
+  if (auto status = builder.Open(fv); !status.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", status);
+    return tsuba::ErrorCode::ArrowError;
+  }
+
+  parquet::ArrowReaderProperties properties =
+      parquet::default_arrow_reader_properties();
+  properties.set_read_dictionary(
+      0, dictionary && CanReadDictionary(*builder.raw_reader()->metadata()));
+
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  if (auto status = builder.memory_pool(arrow::default_memory_pool())
+                        ->properties(properties)
+                        ->Build(&reader);
+      !status.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", status);
+    return tsuba::ErrorCode::ArrowError;
+  }
+  return reader;
+}
+
+/// Turn a single column table read from a property that was stored as a
+/// dictionary column back into one. Parquet keeps only the values, so
+/// columns that could not be read as dictionaries are encoded again, and
+/// the reader starts a new dictionary for each row group, so chunks are
+/// unified to share one dictionary and codes mean the same thing in every
+/// chunk.
 Result<std::shared_ptr<arrow::Table>>
-DoLoadTable(const std::string& expected_name, const galois::Uri& file_path) {
+AsDictionary(const std::shared_ptr<arrow::Table>& table) {
+  std::shared_ptr<arrow::Table> encoded = table;
+  if (table->column(0)->type()->id() != arrow::Type::DICTIONARY) {
+    auto encode_result = arrow::compute::DictionaryEncode(table->column(0));
+    if (!encode_result.ok()) {
+      GALOIS_LOG_DEBUG("arrow error: {}", encode_result.status());
+      return tsuba::ErrorCode::ArrowError;
+    }
+    std::shared_ptr<arrow::ChunkedArray> column =
+        encode_result.ValueOrDie().chunked_array();
+    auto field = table->schema()->field(0)->WithType(column->type());
+    encoded =
+        arrow::Table::Make(arrow::schema({field}), {column}, table->num_rows());
+  }
+
+  auto unify_result = arrow::DictionaryUnifier::UnifyTable(*encoded);
+  if (!unify_result.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", unify_result.status());
+    return tsuba::ErrorCode::ArrowError;
+  }
+  return std::move(unify_result.ValueOrDie());
+}
+
+Result<std::shared_ptr<arrow::Table>>
+DoLoadTable(
+    const std::string& expected_name, const galois::Uri& file_path,
+    bool dictionary) {
   auto fv = std::make_shared<tsuba::FileView>(tsuba::FileView());
   if (auto res = fv->Bind(file_path.string(), false); !res) {
     return res.error();
   }
 
-  std::unique_ptr<parquet::arrow::FileReader> reader;
-
-  auto open_file_result =
-      parquet::arrow::OpenFile(fv, arrow::default_memory_pool(), &reader);
-  if (!open_file_result.ok()) {
-    GALOIS_LOG_DEBUG("arrow error: {}", open_file_result);
-    return tsuba::ErrorCode::ArrowError;
+  auto reader_result = OpenParquet(fv, dictionary);
+  if (!reader_result) {
+    return reader_result.error();
   }
+  std::unique_ptr<parquet::arrow::FileReader> reader =
+      std::move(reader_result.value());
 
   std::shared_ptr<arrow::Table> out;
   auto read_result = reader->ReadTable(&out);
@@ -31,39 +129,127 @@ DoLoadTable(const std::string& expected_name, const galois::Uri& file_path) {
     return tsuba::ErrorCode::ArrowError;
   }
 
-  // Combine multiple chunks into one. Binary and string columns (c.f. large
-  // binary and large string columns) are a special case. They may not be
-  // combined into a single chunk due to the fact the offset type for these
-  // columns is int32_t and thus the maximum size of an arrow::Array for these
-  // types is 2^31.
-  auto combine_result = out->CombineChunks(arrow::default_memory_pool());
-  if (!combine_result.ok()) {
-    GALOIS_LOG_DEBUG("arrow error: {}", combine_result.status());
-    return tsuba::ErrorCode::ArrowError;
+  // Columns keep one chunk per row group rather than being combined into a
+  // single chunk, which would copy them; property views handle several
+  // chunks.
+
+  if (auto res = CheckSchema(out->schema(), expected_name); !res) {
+    return res.error();
+  }
+
+  if (dictionary) {
+    return AsDictionary(out);
   }
+  return out;
+}
 
-  out = std::move(combine_result.ValueOrDie());
+/// A buffer that points into a FileView and keeps it bound for as long as the
+/// buffer is in use
+class FileViewBuffer : public arrow::MutableBuffer {
+public:
+  FileViewBuffer(
+      std::shared_ptr<tsuba::FileView> fv, uint8_t* data, int64_t size)
+      : arrow::MutableBuffer(data, size), fv_(std::move(fv)) {}
 
-  std::shared_ptr<arrow::Schema> schema = out->schema();
-  if (schema->num_fields() != 1) {
-    GALOIS_LOG_DEBUG("expected 1 field found {} instead", schema->num_fields());
-    return tsuba::ErrorCode::InvalidArgument;
+private:
+  std::shared_ptr<tsuba::FileView> fv_;
+};
+
+/// Replace buffers that point into fv with FileViewBuffers. Buffers that the
+/// reader allocated itself (e.g., when it had to copy) are kept as is.
+std::shared_ptr<arrow::ArrayData>
+BindToFileView(
+    const std::shared_ptr<tsuba::FileView>& fv,
+    const std::shared_ptr<arrow::ArrayData>& data) {
+  auto view_begin = reinterpret_cast<uintptr_t>(fv->ptr<uint8_t>());
+  auto view_end = view_begin + fv->size();
+
+  std::shared_ptr<arrow::ArrayData> out = data->Copy();
+  for (std::shared_ptr<arrow::Buffer>& buf : out->buffers) {
+    if (!buf) {
+      continue;
+    }
+    auto buf_begin = reinterpret_cast<uintptr_t>(buf->data());
+    if (buf_begin >= view_begin && buf_begin + buf->size() <= view_end) {
+      // The view is mapped writable (copy-on-write for local files), so the
+      // buffer can be too
+      buf = std::make_shared<FileViewBuffer>(
+          fv, const_cast<uint8_t*>(buf->data()), buf->size());
+    }
+  }
+  for (std::shared_ptr<arrow::ArrayData>& child : out->child_data) {
+    child = BindToFileView(fv, child);
   }
+  if (out->dictionary) {
+    out->dictionary = BindToFileView(fv, out->dictionary);
+  }
+  return out;
+}
 
-  if (schema->field(0)->name() != expected_name) {
-    GALOIS_LOG_DEBUG(
-        "expected {} found {} instead", expected_name,
-        schema->field(0)->name());
-    return tsuba::ErrorCode::InvalidArgument;
+/// Load a property stored as an Arrow IPC file. The file is mapped through a
+/// FileView and the resulting arrays refer to the mapping directly.
+Result<std::shared_ptr<arrow::Table>>
+DoLoadTableIPC(
+    const std::string& expected_name, const galois::Uri& file_path) {
+  auto fv = std::make_shared<tsuba::FileView>(tsuba::FileView());
+  if (auto res = fv->Bind(file_path.string(), true); !res) {
+    return res.error();
   }
 
-  return out;
+  auto open_result = arrow::ipc::RecordBatchFileReader::Open(fv);
+  if (!open_result.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", open_result.status());
+    return tsuba::ErrorCode::ArrowError;
+  }
+  std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader =
+      std::move(open_result.ValueOrDie());
+
+  std::shared_ptr<arrow::Schema> schema = reader->schema();
+  if (auto res = CheckSchema(schema, expected_name); !res) {
+    return res.error();
+  }
+
+  arrow::ArrayVector chunks;
+  for (int i = 0, n = reader->num_record_batches(); i < n; ++i) {
+    auto batch_result = reader->ReadRecordBatch(i);
+    if (!batch_result.ok()) {
+      GALOIS_LOG_DEBUG("arrow error: {}", batch_result.status());
+      return tsuba::ErrorCode::ArrowError;
+    }
+    std::shared_ptr<arrow::RecordBatch> batch =
+        std::move(batch_result.ValueOrDie());
+    chunks.emplace_back(
+        arrow::MakeArray(BindToFileView(fv, batch->column_data(0))));
+  }
+
+  auto column =
+      std::make_shared<arrow::ChunkedArray>(chunks, schema->field(0)->type());
+  return arrow::Table::Make(schema, {column});
+}
+
+/// Return the range [first, last) of row groups in index that overlap rows
+/// [offset, offset + length)
+std::pair<size_t, size_t>
+SelectRowGroups(
+    const tsuba::RowGroupIndex& index, int64_t offset, int64_t length) {
+  const std::vector<int64_t>& rows = index.rows;
+  if (rows.empty()) {
+    return {0, 0};
+  }
+  // row group i holds rows [rows[i], rows[i + 1])
+  size_t first =
+      std::upper_bound(rows.begin() + 1, rows.end(), offset) - rows.begin() - 1;
+  size_t last =
+      std::lower_bound(rows.begin(), rows.end() - 1, offset + length) -
+      rows.begin();
+  return {first, std::max(first, last)};
 }
 
 Result<std::shared_ptr<arrow::Table>>
 DoLoadTableSlice(
     const std::string& expected_name, const galois::Uri& file_path,
-    int64_t offset, int64_t length) {
+    int64_t offset, int64_t length, const tsuba::RowGroupIndex& known_index,
+    bool dictionary) {
   if (offset < 0 || length < 0) {
     return tsuba::ErrorCode::InvalidArgument;
   }
@@ -72,38 +258,70 @@ DoLoadTableSlice(
     return res.error();
   }
 
-  std::unique_ptr<parquet::arrow::FileReader> reader;
+  // If the part header told us where the row groups are, start fetching the
+  // slice now so that it overlaps with reading the footer
+  bool prefetched = false;
+  if (!known_index.empty()) {
+    auto [first, last] = SelectRowGroups(known_index, offset, length);
+    if (first < last) {
+      if (auto res = fv->Fill(
+              known_index.offsets[first], known_index.offsets[last], false);
+          !res) {
+        return res.error();
+      }
+    }
+    prefetched = true;
+  }
 
-  auto open_file_result =
-      parquet::arrow::OpenFile(fv, arrow::default_memory_pool(), &reader);
-  if (!open_file_result.ok()) {
-    GALOIS_LOG_DEBUG("arrow error: {}", open_file_result);
-    return tsuba::ErrorCode::ArrowError;
+  auto reader_result = OpenParquet(fv, dictionary);
+  if (!reader_result) {
+    return reader_result.error();
   }
+  std::unique_ptr<parquet::arrow::FileReader> reader =
+      std::move(reader_result.value());
 
-  std::vector<int> row_groups;
-  int rg_count = reader->num_row_groups();
-  int64_t row_offset = 0;
-  int64_t cumulative_rows = 0;
-  int64_t file_offset = 0;
-  int64_t cumulative_bytes = 0;
-  for (int i = 0; cumulative_rows < offset + length && i < rg_count; ++i) {
-    auto rg_md = reader->parquet_reader()->metadata()->RowGroup(i);
-    int64_t new_rows = rg_md->num_rows();
-    int64_t new_bytes = rg_md->total_byte_size();
-    if (offset < cumulative_rows + new_rows) {
-      if (row_groups.empty()) {
-        row_offset = offset - cumulative_rows;
-        file_offset = cumulative_bytes;
-      }
-      row_groups.push_back(i);
+  tsuba::RowGroupIndex index =
+      prefetched ? known_index
+                 : tsuba::MakeRowGroupIndex(
+                       *reader->parquet_reader()->metadata());
+  if (!index.empty() &&
+      static_cast<int>(index.rows.size()) != reader->num_row_groups() + 1) {
+    GALOIS_LOG_DEBUG(
+        "row group index has {} entries but {} has {} row groups",
+        index.rows.size(), file_path, reader->num_row_groups());
+    return tsuba::ErrorCode::InvalidArgument;
+  }
+
+  auto [first, last] = SelectRowGroups(index, offset, length);
+  if (first == last) {
+    std::shared_ptr<arrow::Schema> schema;
+    if (auto status = reader->GetSchema(&schema); !status.ok()) {
+      GALOIS_LOG_DEBUG("arrow error: {}", status);
+      return tsuba::ErrorCode::ArrowError;
+    }
+    if (auto res = CheckSchema(schema, expected_name); !res) {
+      return res.error();
     }
-    cumulative_rows += new_rows;
-    cumulative_bytes += new_bytes;
+    auto empty = std::make_shared<arrow::ChunkedArray>(
+        arrow::ArrayVector{}, schema->field(0)->type());
+    std::shared_ptr<arrow::Table> table =
+        arrow::Table::Make(schema, {empty}, 0);
+    if (dictionary) {
+      return AsDictionary(table);
+    }
+    return table;
   }
 
-  if (auto res = fv->Fill(file_offset, cumulative_bytes, false); !res) {
-    return res.error();
+  if (!prefetched) {
+    if (auto res = fv->Fill(index.offsets[first], index.offsets[last], false);
+        !res) {
+      return res.error();
+    }
+  }
+
+  std::vector<int> row_groups;
+  for (size_t i = first; i < last; ++i) {
+    row_groups.push_back(i);
   }
 
   std::shared_ptr<arrow::Table> out;
@@ -113,37 +331,160 @@ DoLoadTableSlice(
     return tsuba::ErrorCode::ArrowError;
   }
 
-  auto combine_result = out->CombineChunks(arrow::default_memory_pool());
-  if (!combine_result.ok()) {
-    GALOIS_LOG_DEBUG("arrow error: {}", combine_result.status());
-    return tsuba::ErrorCode::ArrowError;
+  if (auto res = CheckSchema(out->schema(), expected_name); !res) {
+    return res.error();
   }
 
-  out = std::move(combine_result.ValueOrDie());
+  if (dictionary) {
+    auto dict_result = AsDictionary(out);
+    if (!dict_result) {
+      return dict_result.error();
+    }
+    out = std::move(dict_result.value());
+  }
 
-  std::shared_ptr<arrow::Schema> schema = out->schema();
-  if (schema->num_fields() != 1) {
-    GALOIS_LOG_DEBUG("expected 1 field found {} instead", schema->num_fields());
-    return tsuba::ErrorCode::InvalidArgument;
+  // Slicing a table with one chunk per row group does not copy it
+  return out->Slice(offset - index.rows[first], length);
+}
+
+int
+LoadConcurrency() {
+  static int concurrency = []() {
+    int val = 8;
+    if (galois::GetEnv("TSUBA_LOAD_CONCURRENCY", &val) && val < 1) {
+      GALOIS_LOG_WARN("ignoring TSUBA_LOAD_CONCURRENCY={}", val);
+      val = 8;
+    }
+    return val;
+  }();
+  return concurrency;
+}
+
+using LoadFn = std::function<Result<std::shared_ptr<arrow::Table>>(
+    const tsuba::PropStorageInfo&, const galois::Uri&)>;
+
+/// Run load on each property with at most LoadConcurrency() loads in flight
+Result<std::vector<std::shared_ptr<arrow::Table>>>
+RunLoads(
+    const galois::Uri& dir,
+    const std::vector<tsuba::PropStorageInfo>& properties,
+    const LoadFn& load) {
+  // Slots stay empty for loads skipped after another load failed
+  std::vector<std::optional<Result<std::shared_ptr<arrow::Table>>>> results(
+      properties.size());
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+
+  auto worker = [&]() {
+    for (size_t i = next++; i < properties.size() && !failed; i = next++) {
+      const tsuba::PropStorageInfo& prop = properties[i];
+      auto start = std::chrono::steady_clock::now();
+      results[i] = load(prop, dir.Join(prop.path));
+      if (!*results[i]) {
+        failed = true;
+        continue;
+      }
+      auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start);
+      GALOIS_LOG_VERBOSE(
+          "loaded property {} in {} us", prop.name, elapsed.count());
+      tsuba::StatAdd("PropertyLoadMicroseconds." + prop.name, elapsed.count());
+      tsuba::StatAdd("PropertyLoadMicroseconds", elapsed.count());
+    }
+  };
+
+  // The calling thread is one of the workers
+  size_t num_workers = std::min<size_t>(properties.size(), LoadConcurrency());
+  std::vector<std::future<void>> helpers;
+  for (size_t i = 1; i < num_workers; ++i) {
+    helpers.emplace_back(std::async(std::launch::async, worker));
+  }
+  worker();
+  for (auto& helper : helpers) {
+    helper.get();
   }
 
-  if (schema->field(0)->name() != expected_name) {
-    GALOIS_LOG_DEBUG(
-        "expected {} found {} instead", expected_name,
-        schema->field(0)->name());
-    return tsuba::ErrorCode::InvalidArgument;
+  for (size_t i = 0; i < results.size(); ++i) {
+    if (results[i] && !*results[i]) {
+      GALOIS_LOG_DEBUG(
+          "loading property {}: {}", properties[i].name, results[i]->error());
+      return results[i]->error();
+    }
   }
 
-  return out->Slice(row_offset, length);
+  std::vector<std::shared_ptr<arrow::Table>> tables;
+  for (std::optional<Result<std::shared_ptr<arrow::Table>>>& res : results) {
+    // Every load runs unless one fails
+    GALOIS_LOG_ASSERT(res);
+    tables.emplace_back(std::move(res->value()));
+  }
+  return tables;
 }
 
 }  // namespace
 
+tsuba::RowGroupIndex
+tsuba::MakeRowGroupIndex(const parquet::FileMetaData& md) {
+  RowGroupIndex index;
+  if (md.num_row_groups() == 0) {
+    return index;
+  }
+
+  int64_t rows = 0;
+  int64_t end = 0;
+  for (int i = 0, n = md.num_row_groups(); i < n; ++i) {
+    std::unique_ptr<parquet::RowGroupMetaData> rg_md = md.RowGroup(i);
+    // Properties are single column tables
+    std::unique_ptr<parquet::ColumnChunkMetaData> col_md =
+        rg_md->ColumnChunk(0);
+    int64_t begin = col_md->has_dictionary_page()
+                        ? col_md->dictionary_page_offset()
+                        : col_md->data_page_offset();
+    index.rows.push_back(rows);
+    index.offsets.push_back(begin);
+    rows += rg_md->num_rows();
+    end = begin + col_md->total_compressed_size();
+  }
+  index.rows.push_back(rows);
+  index.offsets.push_back(end);
+  return index;
+}
+
+Result<std::vector<std::shared_ptr<arrow::Table>>>
+tsuba::LoadTables(
+    const galois::Uri& dir, const std::vector<PropStorageInfo>& properties) {
+  return RunLoads(
+      dir, properties,
+      [](const PropStorageInfo& prop, const galois::Uri& path) {
+        return LoadTable(prop.name, path, prop.format, prop.dictionary);
+      });
+}
+
+Result<std::vector<std::shared_ptr<arrow::Table>>>
+tsuba::LoadTableSlices(
+    const galois::Uri& dir, const std::vector<PropStorageInfo>& properties,
+    int64_t offset, int64_t length) {
+  return RunLoads(
+      dir, properties,
+      [offset, length](const PropStorageInfo& prop, const galois::Uri& path) {
+        return LoadTableSlice(
+            prop.name, path, offset, length, prop.format, prop.row_groups,
+            prop.dictionary);
+      });
+}
+
 Result<std::shared_ptr<arrow::Table>>
 tsuba::LoadTable(
-    const std::string& expected_name, const galois::Uri& file_path) {
+    const std::string& expected_name, const galois::Uri& file_path,
+    PropStorageFormat format, bool dictionary) {
   try {
-    return DoLoadTable(expected_name, file_path);
+    switch (format) {
+    case PropStorageFormat::ArrowIPC:
+      return DoLoadTableIPC(expected_name, file_path);
+    case PropStorageFormat::Parquet:
+      break;
+    }
+    return DoLoadTable(expected_name, file_path, dictionary);
   } catch (const std::exception& exp) {
     GALOIS_LOG_DEBUG("arrow exception: {}", exp.what());
     return tsuba::ErrorCode::ArrowError;
@@ -153,9 +494,27 @@ tsuba::LoadTable(
 galois::Result<std::shared_ptr<arrow::Table>>
 tsuba::LoadTableSlice(
     const std::string& expected_name, const galois::Uri& file_path,
-    int64_t offset, int64_t length) {
+    int64_t offset, int64_t length, PropStorageFormat format,
+    const RowGroupIndex& row_groups, bool dictionary) {
   try {
-    return DoLoadTableSlice(expected_name, file_path, offset, length);
+    switch (format) {
+    case PropStorageFormat::ArrowIPC: {
+      // Loading maps rather than reads the file, so slicing the whole table
+      // only touches the pages in the slice
+      if (offset < 0 || length < 0) {
+        return ErrorCode::InvalidArgument;
+      }
+      auto load_result = DoLoadTableIPC(expected_name, file_path);
+      if (!load_result) {
+        return load_result.error();
+      }
+      return load_result.value()->Slice(offset, length);
+    }
+    case PropStorageFormat::Parquet:
+      break;
+    }
+    return DoLoadTableSlice(
+        expected_name, file_path, offset, length, row_groups, dictionary);
   } catch (const std::exception& exp) {
     GALOIS_LOG_DEBUG("arrow exception: {}", exp.what());
     return ErrorCode::ArrowError;
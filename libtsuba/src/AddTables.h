@@ -1,7 +1,11 @@
 #ifndef GALOIS_LIBTSUBA_ADDTABLES_H_
 #define GALOIS_LIBTSUBA_ADDTABLES_H_
 
+#include <memory>
+#include <vector>
+
 #include <arrow/api.h>
+#include <parquet/metadata.h>
 
 #include "RDGPartHeader.h"
 #include "galois/Result.h"
@@ -9,28 +13,54 @@
 
 namespace tsuba {
 
+/// Load a stored property. If dictionary is set (see
+/// PropStorageInfo::dictionary), a Parquet property is loaded as an
+/// arrow::DictionaryArray.
 GALOIS_EXPORT galois::Result<std::shared_ptr<arrow::Table>> LoadTable(
-    const std::string& expected_name, const galois::Uri& file_path);
+    const std::string& expected_name, const galois::Uri& file_path,
+    PropStorageFormat format = PropStorageFormat::Parquet,
+    bool dictionary = false);
 
+/// Load rows [offset, offset + length) of a stored property. For Parquet
+/// files, only the row groups that overlap the slice are read. If row_groups
+/// is not empty, it is used to start fetching them before the file footer has
+/// been read.
 GALOIS_EXPORT galois::Result<std::shared_ptr<arrow::Table>> LoadTableSlice(
     const std::string& expected_name, const galois::Uri& file_path,
-    int64_t offset, int64_t length);
+    int64_t offset, int64_t length,
+    PropStorageFormat format = PropStorageFormat::Parquet,
+    const RowGroupIndex& row_groups = RowGroupIndex(),
+    bool dictionary = false);
+
+/// Compute the row group index of a single column Parquet file
+RowGroupIndex MakeRowGroupIndex(const parquet::FileMetaData& md);
+
+/// Load the tables for properties stored relative to dir. Tables are fetched
+/// and decoded concurrently, at most TSUBA_LOAD_CONCURRENCY (default 8) at a
+/// time, and returned in the same order as properties.
+GALOIS_EXPORT galois::Result<std::vector<std::shared_ptr<arrow::Table>>>
+LoadTables(
+    const galois::Uri& dir,
+    const std::vector<tsuba::PropStorageInfo>& properties);
+
+/// Like LoadTables but only load rows [offset, offset + length) of each table
+GALOIS_EXPORT galois::Result<std::vector<std::shared_ptr<arrow::Table>>>
+LoadTableSlices(
+    const galois::Uri& dir,
+    const std::vector<tsuba::PropStorageInfo>& properties, int64_t offset,
+    int64_t length);
 
 template <typename AddFn>
 galois::Result<void>
 AddTables(
     const galois::Uri& uri,
     const std::vector<tsuba::PropStorageInfo>& properties, AddFn add_fn) {
-  for (const tsuba::PropStorageInfo& properties : properties) {
-    auto p_path = uri.Join(properties.path);
-
-    auto load_result = LoadTable(properties.name, p_path);
-    if (!load_result) {
-      return load_result.error();
-    }
-
-    std::shared_ptr<arrow::Table> table = load_result.value();
+  auto load_result = LoadTables(uri, properties);
+  if (!load_result) {
+    return load_result.error();
+  }
 
+  for (const std::shared_ptr<arrow::Table>& table : load_result.value()) {
     auto add_result = add_fn(table);
     if (!add_result) {
       return add_result.error();
@@ -46,17 +76,13 @@ AddTablesSlice(
     const galois::Uri& dir,
     const std::vector<tsuba::PropStorageInfo>& properties,
     std::pair<uint64_t, uint64_t> range, AddFn add_fn) {
-  for (const tsuba::PropStorageInfo& properties : properties) {
-    galois::Uri p_path = dir.Join(properties.path);
-
-    auto load_result = LoadTableSlice(
-        properties.name, p_path, range.first, range.second - range.first);
-    if (!load_result) {
-      return load_result.error();
-    }
-
-    std::shared_ptr<arrow::Table> table = load_result.value();
+  auto load_result = LoadTableSlices(
+      dir, properties, range.first, range.second - range.first);
+  if (!load_result) {
+    return load_result.error();
+  }
 
+  for (const std::shared_ptr<arrow::Table>& table : load_result.value()) {
     auto add_result = add_fn(table);
     if (!add_result) {
       return add_result.error();
@@ -0,0 +1,94 @@
+#include "CachingNameServerClient.h"
+
+#include "galois/Logging.h"
+#include "tsuba/Stats.h"
+
+namespace tsuba {
+
+void
+CachingNameServerClient::Insert(const std::string& key, const RDGMeta& meta) {
+  Clock::time_point expires = Clock::now() + ttl_;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    entries_.emplace(key, Entry{meta, expires});
+    return;
+  }
+  if (it->second.meta.version() > meta.version()) {
+    return;
+  }
+  it->second = Entry{meta, expires};
+}
+
+void
+CachingNameServerClient::Forget(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.erase(key);
+}
+
+galois::Result<RDGMeta>
+CachingNameServerClient::Get(const galois::Uri& rdg_name) {
+  std::string key = rdg_name.Encode();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      if (Clock::now() < it->second.expires) {
+        StatAdd("NameServerCacheHits", 1);
+        return it->second.meta;
+      }
+      entries_.erase(it);
+    }
+  }
+
+  StatAdd("NameServerCacheMisses", 1);
+  auto meta_res = backend_->Get(rdg_name);
+  if (!meta_res) {
+    return meta_res.error();
+  }
+  Insert(key, meta_res.value());
+  return meta_res;
+}
+
+galois::Result<void>
+CachingNameServerClient::CreateIfAbsent(
+    const galois::Uri& rdg_name, const RDGMeta& meta) {
+  std::string key = rdg_name.Encode();
+  if (auto res = backend_->CreateIfAbsent(rdg_name, meta); !res) {
+    Forget(key);
+    return res.error();
+  }
+  // Open registers names it has not seen before, so this is called on every
+  // open; dropping the entry here would mean Get never hits. On success the
+  // name has meta's version, whether or not it existed before.
+  Insert(key, meta);
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+CachingNameServerClient::Delete(const galois::Uri& rdg_name) {
+  std::string key = rdg_name.Encode();
+  Forget(key);
+  auto res = backend_->Delete(rdg_name);
+  // a Get that raced with the delete may have cached the deleted entry
+  Forget(key);
+  return res;
+}
+
+galois::Result<void>
+CachingNameServerClient::Update(
+    const galois::Uri& rdg_name, uint64_t old_version, const RDGMeta& meta) {
+  std::string key = rdg_name.Encode();
+  if (auto res = backend_->Update(rdg_name, old_version, meta); !res) {
+    // e.g., BadVersion: someone else updated the name and what is cached
+    // is out of date
+    GALOIS_LOG_DEBUG("dropping cached {}: {}", key, res.error());
+    Forget(key);
+    return res.error();
+  }
+  Insert(key, meta);
+  return galois::ResultSuccess();
+}
+
+}  // namespace tsuba
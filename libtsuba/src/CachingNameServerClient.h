@@ -0,0 +1,66 @@
+#ifndef GALOIS_LIBTSUBA_CACHINGNAMESERVERCLIENT_H_
+#define GALOIS_LIBTSUBA_CACHINGNAMESERVERCLIENT_H_
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "RDGMeta.h"
+#include "galois/Result.h"
+#include "tsuba/NameServerClient.h"
+
+namespace tsuba {
+
+/// CachingNameServerClient wraps another NameServerClient and remembers the
+/// result of Get for a while, so that opening the same RDG repeatedly does not
+/// cost a name server round trip each time.
+///
+/// Changes made through this client are reflected immediately: a successful
+/// CreateIfAbsent or Update caches the version it leaves the name at, and
+/// Delete or any failed operation on a name drops its entry. Changes made by
+/// other processes become visible once the cached entry is older than ttl.
+/// Entries only ever move forward in version, so a slow Get that races with
+/// an Update cannot put back an older version.
+class CachingNameServerClient : public NameServerClient {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  CachingNameServerClient(NameServerClient* backend, Clock::duration ttl)
+      : backend_(backend), ttl_(ttl) {}
+
+  galois::Result<RDGMeta> Get(const galois::Uri& rdg_name) override;
+
+  galois::Result<void> CreateIfAbsent(
+      const galois::Uri& rdg_name, const RDGMeta& meta) override;
+
+  galois::Result<void> Delete(const galois::Uri& rdg_name) override;
+
+  galois::Result<void> Update(
+      const galois::Uri& rdg_name, uint64_t old_version,
+      const RDGMeta& meta) override;
+
+  galois::Result<void> CheckHealth() override {
+    return backend_->CheckHealth();
+  }
+
+private:
+  struct Entry {
+    RDGMeta meta;
+    Clock::time_point expires;
+  };
+
+  NameServerClient* backend_;
+  Clock::duration ttl_;
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, Entry> entries_;
+
+  /// Cache meta for key unless a newer version is already cached
+  void Insert(const std::string& key, const RDGMeta& meta);
+  void Forget(const std::string& key);
+};
+
+}  // namespace tsuba
+
+#endif
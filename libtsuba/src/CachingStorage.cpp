@@ -0,0 +1,443 @@
+#include "CachingStorage.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <tuple>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <fmt/format.h>
+
+#include "galois/Logging.h"
+#include "galois/Random.h"
+#include "galois/Uri.h"
+#include "tsuba/Errors.h"
+#include "tsuba/Stats.h"
+#include "tsuba/file.h"
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+constexpr std::string_view kTmpSuffix = ".tmp";
+
+/// FNV-1a, which unlike std::hash is the same in every process, so cached
+/// files can be found again after a restart
+uint64_t
+HashUri(const std::string& uri) {
+  uint64_t hash = UINT64_C(0xcbf29ce484222325);
+  for (char c : uri) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= UINT64_C(0x100000001b3);
+  }
+  return hash;
+}
+
+std::string
+UriPrefix(const std::string& uri) {
+  return fmt::format("{:016x}-", HashUri(uri));
+}
+
+/// Block files start with the size of the URI of their object, the URI
+/// itself, and the size and modification time of the object
+uint64_t
+HeaderSize(const std::string& uri) {
+  return 3 * sizeof(uint64_t) + uri.size();
+}
+
+bool
+SameObject(const tsuba::StatBuf& a, const tsuba::StatBuf& b) {
+  return a.size == b.size && a.mtime_ns == b.mtime_ns;
+}
+
+struct BlockHeader {
+  std::string uri;
+  tsuba::StatBuf object;
+};
+
+/// Return the header of a block file of file_size bytes
+galois::Result<BlockHeader>
+ReadHeader(const std::string& path, uint64_t file_size) {
+  if (file_size < 3 * sizeof(uint64_t)) {
+    return tsuba::ErrorCode::InvalidArgument;
+  }
+  std::ifstream ifile(path);
+  uint64_t uri_size = 0;
+  ifile.read(reinterpret_cast<char*>(&uri_size), sizeof(uri_size)); /* NOLINT */
+  if (!ifile.good() || uri_size > file_size - 3 * sizeof(uint64_t)) {
+    return tsuba::ErrorCode::InvalidArgument;
+  }
+  BlockHeader header;
+  header.uri.resize(uri_size);
+  ifile.read(header.uri.data(), uri_size);
+  ifile.read(
+      reinterpret_cast<char*>(&header.object.size), /* NOLINT */
+      sizeof(header.object.size));
+  ifile.read(
+      reinterpret_cast<char*>(&header.object.mtime_ns), /* NOLINT */
+      sizeof(header.object.mtime_ns));
+  if (!ifile.good()) {
+    return tsuba::ErrorCode::InvalidArgument;
+  }
+  return header;
+}
+
+}  // namespace
+
+tsuba::CachingStorage::CachingStorage(
+    FileStorage* backend, std::string cache_dir, uint64_t capacity)
+    : FileStorage(backend->uri_scheme()),
+      backend_(backend),
+      cache_dir_(std::move(cache_dir)),
+      capacity_(capacity) {}
+
+std::string
+tsuba::CachingStorage::BlockName(const std::string& uri, uint64_t block) const {
+  return UriPrefix(uri) + std::to_string(block);
+}
+
+std::string
+tsuba::CachingStorage::BlockPath(const std::string& name) const {
+  return galois::Uri::JoinPath(cache_dir_, name);
+}
+
+galois::Result<void>
+tsuba::CachingStorage::Init() {
+  if (auto res = backend_->Init(); !res) {
+    return res.error();
+  }
+
+  boost::system::error_code err;
+  fs::create_directories(cache_dir_, err);
+  if (err) {
+    GALOIS_LOG_ERROR(
+        "creating cache directory {}: {}", cache_dir_, err.message());
+    return err;
+  }
+
+  // Rebuild the index from a previous run, oldest first
+  std::vector<std::tuple<std::time_t, std::string, BlockHeader, uint64_t>>
+      found;
+  for (fs::directory_iterator it(cache_dir_, err), end; !err && it != end;
+       it.increment(err)) {
+    const fs::path& path = it->path();
+    std::string name = path.filename().string();
+    if (name.find(kTmpSuffix) != std::string::npos) {
+      // left over from an interrupted insert
+      fs::remove(path, err);
+      continue;
+    }
+    uint64_t size = fs::file_size(path, err);
+    std::time_t mtime = fs::last_write_time(path, err);
+    if (err) {
+      err.clear();
+      continue;
+    }
+    auto header_res = ReadHeader(path.string(), size);
+    if (!header_res || name.rfind(UriPrefix(header_res.value().uri), 0) != 0) {
+      GALOIS_LOG_DEBUG("removing unrecognized cache file {}", path.string());
+      fs::remove(path, err);
+      err.clear();
+      continue;
+    }
+    found.emplace_back(
+        mtime, std::move(name), std::move(header_res.value()), size);
+  }
+  std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) {
+    return std::get<0>(a) < std::get<0>(b);
+  });
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& [mtime, name, header, size] : found) {
+    AddEntryLocked(name, header.uri, header.object, size);
+  }
+  EvictLocked();
+  GALOIS_LOG_DEBUG(
+      "cache {} has {} blocks, {} bytes", cache_dir_, entries_.size(),
+      cached_bytes_);
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+tsuba::CachingStorage::Fini() {
+  return backend_->Fini();
+}
+
+galois::Result<tsuba::StatBuf>
+tsuba::CachingStorage::ObjectStat(const std::string& uri) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = object_stats_.find(uri); it != object_stats_.end()) {
+      return it->second;
+    }
+  }
+  StatBuf buf;
+  if (auto res = Stat(uri, &buf); !res) {
+    return res.error();
+  }
+  return buf;
+}
+
+galois::Result<void>
+tsuba::CachingStorage::Stat(const std::string& uri, StatBuf* size) {
+  if (auto res = backend_->Stat(uri, size); !res) {
+    return res.error();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  object_stats_[uri] = *size;
+  return galois::ResultSuccess();
+}
+
+uint64_t
+tsuba::CachingStorage::generation() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return generation_;
+}
+
+bool
+tsuba::CachingStorage::Contains(
+    const std::string& name, const std::string& uri, const StatBuf& object) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(name);
+  return it != entries_.end() && it->second.uri == uri &&
+         SameObject(it->second.object, object);
+}
+
+bool
+tsuba::CachingStorage::ReadCached(
+    const std::string& name, const std::string& uri, const StatBuf& object,
+    uint64_t offset, uint64_t size, uint8_t* out) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    if (it == entries_.end() || it->second.uri != uri ||
+        !SameObject(it->second.object, object) ||
+        it->second.size < HeaderSize(uri) + offset + size) {
+      return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+  }
+  offset += HeaderSize(uri);
+
+  std::string path = BlockPath(name);
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  bool ok = fd >= 0;
+  uint64_t done = 0;
+  while (ok && done < size) {
+    ssize_t ret = pread(fd, out + done, size - done, offset + done);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    ok = ret > 0;
+    if (ok) {
+      done += ret;
+    }
+  }
+  if (fd >= 0) {
+    // Keep recency across restarts; see Init
+    futimens(fd, nullptr);
+    close(fd);
+  }
+
+  if (!ok) {
+    // e.g., removed by someone else
+    GALOIS_LOG_DEBUG("dropping unreadable cached block {}", path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    RemoveEntryLocked(name);
+    return false;
+  }
+  return true;
+}
+
+void
+tsuba::CachingStorage::Insert(
+    const std::string& name, const std::string& uri, const StatBuf& object,
+    const uint8_t* data, uint64_t size, uint64_t generation) {
+  std::string path = BlockPath(name);
+  std::string tmp_path = path + std::string(kTmpSuffix) +
+                         galois::RandomAlphanumericString(8);
+  {
+    std::ofstream ofile(tmp_path);
+    uint64_t uri_size = uri.size();
+    ofile.write(
+        reinterpret_cast<const char*>(&uri_size), /* NOLINT */
+        sizeof(uri_size));
+    ofile.write(uri.data(), uri_size);
+    ofile.write(
+        reinterpret_cast<const char*>(&object.size), /* NOLINT */
+        sizeof(object.size));
+    ofile.write(
+        reinterpret_cast<const char*>(&object.mtime_ns), /* NOLINT */
+        sizeof(object.mtime_ns));
+    ofile.write(reinterpret_cast<const char*>(data), size); /* NOLINT */
+    if (!ofile.good()) {
+      GALOIS_LOG_DEBUG("could not write cached block {}", tmp_path);
+      unlink(tmp_path.c_str());
+      return;
+    }
+  }
+
+  // Publish the block under the lock so that a concurrent Forget either
+  // removes it or causes it to be dropped here
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (generation != generation_) {
+    unlink(tmp_path.c_str());
+    return;
+  }
+  if (auto it = entries_.find(name); it != entries_.end()) {
+    if (it->second.uri == uri && SameObject(it->second.object, object)) {
+      // the same block fetched twice; the files are identical
+      lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+      unlink(tmp_path.c_str());
+      return;
+    }
+    // a block of another version of the object, or of another object whose
+    // URI has the same hash
+    RemoveEntryLocked(name);
+  }
+  if (rename(tmp_path.c_str(), path.c_str()) != 0) {
+    GALOIS_LOG_DEBUG("rename: {}: {}", tmp_path, std::strerror(errno));
+    unlink(tmp_path.c_str());
+    return;
+  }
+  AddEntryLocked(name, uri, object, HeaderSize(uri) + size);
+  EvictLocked();
+}
+
+void
+tsuba::CachingStorage::AddEntryLocked(
+    const std::string& name, const std::string& uri, const StatBuf& object,
+    uint64_t size) {
+  lru_.emplace_front(name);
+  entries_.emplace(
+      name, Entry{
+                .size = size,
+                .uri = uri,
+                .object = object,
+                .lru_pos = lru_.begin(),
+            });
+  cached_bytes_ += size;
+}
+
+void
+tsuba::CachingStorage::RemoveEntryLocked(const std::string& name) {
+  auto it = entries_.find(name);
+  if (it == entries_.end()) {
+    return;
+  }
+  unlink(BlockPath(name).c_str());
+  cached_bytes_ -= it->second.size;
+  lru_.erase(it->second.lru_pos);
+  entries_.erase(it);
+}
+
+void
+tsuba::CachingStorage::EvictLocked() {
+  while (cached_bytes_ > capacity_ && !lru_.empty()) {
+    std::string victim = lru_.back();
+    StatAdd("CacheEvictedBytes", entries_.at(victim).size);
+    RemoveEntryLocked(victim);
+  }
+}
+
+void
+tsuba::CachingStorage::Forget(const std::string& uri) {
+  std::string prefix = UriPrefix(uri);
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++generation_;
+  object_stats_.erase(uri);
+  std::vector<std::string> to_remove;
+  for (const auto& [name, entry] : entries_) {
+    if (name.compare(0, prefix.size(), prefix) == 0 && entry.uri == uri) {
+      to_remove.emplace_back(name);
+    }
+  }
+  for (const auto& name : to_remove) {
+    RemoveEntryLocked(name);
+  }
+}
+
+galois::Result<void>
+tsuba::CachingStorage::GetMultiSync(
+    const std::string& uri, uint64_t start, uint64_t size,
+    uint8_t* result_buf) {
+  if (size == 0) {
+    return galois::ResultSuccess();
+  }
+  auto stat_res = ObjectStat(uri);
+  if (!stat_res) {
+    return stat_res.error();
+  }
+  const StatBuf& object = stat_res.value();
+  uint64_t object_size = object.size;
+  uint64_t end = std::min(start + size, object_size);
+  if (end <= start) {
+    // let the backend decide what reading past the end means
+    return backend_->GetMultiSync(uri, start, size, result_buf);
+  }
+
+  auto block_end = [&](uint64_t block) {
+    return std::min((block + 1) * kCacheBlockSize, object_size);
+  };
+
+  uint64_t first = start / kCacheBlockSize;
+  uint64_t last = (end - 1) / kCacheBlockSize;
+  for (uint64_t block = first; block <= last;) {
+    uint64_t lo = std::max(start, block * kCacheBlockSize);
+    uint64_t hi = std::min(end, block_end(block));
+    if (ReadCached(
+            BlockName(uri, block), uri, object, lo - block * kCacheBlockSize,
+            hi - lo, result_buf + (lo - start))) {
+      StatAdd("CacheHits", 1);
+      StatAdd("CacheHitBytes", hi - lo);
+      ++block;
+      continue;
+    }
+
+    // Fetch consecutive missing blocks with one request
+    uint64_t run_end = block + 1;
+    while (run_end <= last &&
+           !Contains(BlockName(uri, run_end), uri, object)) {
+      ++run_end;
+    }
+    uint64_t fetch_generation = generation();
+    uint64_t fetch_start = block * kCacheBlockSize;
+    uint64_t fetch_size = block_end(run_end - 1) - fetch_start;
+    std::vector<uint8_t> buf(fetch_size);
+    if (auto res =
+            backend_->GetMultiSync(uri, fetch_start, fetch_size, buf.data());
+        !res) {
+      return res.error();
+    }
+    StatAdd("CacheMisses", run_end - block);
+    StatAdd("CacheMissBytes", fetch_size);
+
+    for (uint64_t b = block; b < run_end; ++b) {
+      uint64_t b_start = b * kCacheBlockSize;
+      Insert(
+          BlockName(uri, b), uri, object, buf.data() + (b_start - fetch_start),
+          block_end(b) - b_start, fetch_generation);
+    }
+    uint64_t copy_end = std::min(end, fetch_start + fetch_size);
+    std::memcpy(
+        result_buf + (lo - start), buf.data() + (lo - fetch_start),
+        copy_end - lo);
+    block = run_end;
+  }
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+tsuba::CachingStorage::Delete(
+    const std::string& directory,
+    const std::unordered_set<std::string>& files) {
+  for (const auto& file : files) {
+    Forget(galois::Uri::JoinPath(directory, file));
+  }
+  return backend_->Delete(directory, files);
+}
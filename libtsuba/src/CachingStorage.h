@@ -0,0 +1,163 @@
+#ifndef GALOIS_LIBTSUBA_CACHINGSTORAGE_H_
+#define GALOIS_LIBTSUBA_CACHINGSTORAGE_H_
+
+#include <cstdint>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "galois/Result.h"
+#include "tsuba/FileStorage.h"
+#include "tsuba/file.h"
+
+namespace tsuba {
+
+/// CachingStorage wraps another FileStorage and keeps what is read through it
+/// in a local directory, e.g., on an SSD, so that reading the same data again
+/// costs a local read rather than a remote one.
+///
+/// Objects are cached in aligned blocks of kCacheBlockSize bytes, each in its
+/// own file, and the least recently used blocks are evicted when the cache
+/// grows past its capacity. The cache directory persists across processes.
+///
+/// Block files are named after a hash of the object URI, so two objects may
+/// map to the same name. Each block file starts with the full URI of its
+/// object, and a block is only used to read the object it was fetched from.
+///
+/// Some names are reused, e.g., part headers when an RDG is deleted and
+/// created again, possibly by another process. So each block file also
+/// records the size and modification time that Stat reported for its object
+/// when the block was fetched, and a block is only used while Stat still
+/// reports them. The first read of an object in a process stats it. Cached
+/// blocks of an object are dropped when it is written or deleted through
+/// this storage.
+class CachingStorage : public FileStorage {
+public:
+  static constexpr uint64_t kCacheBlockSize = UINT64_C(4) << 20; /* 4M */
+
+  CachingStorage(
+      FileStorage* backend, std::string cache_dir, uint64_t capacity);
+
+  galois::Result<void> Init() override;
+  galois::Result<void> Fini() override;
+  galois::Result<void> Stat(const std::string& uri, StatBuf* size) override;
+
+  uint32_t Priority() const override { return backend_->Priority(); }
+  uint8_t PageShift() const override { return backend_->PageShift(); }
+
+  galois::Result<void> GetMultiSync(
+      const std::string& uri, uint64_t start, uint64_t size,
+      uint8_t* result_buf) override;
+
+  galois::Result<void> PutMultiSync(
+      const std::string& uri, const uint8_t* data, uint64_t size) override {
+    Forget(uri);
+    return backend_->PutMultiSync(uri, data, size);
+  }
+
+  std::future<galois::Result<void>> PutAsync(
+      const std::string& uri, const uint8_t* data, uint64_t size) override {
+    Forget(uri);
+    return backend_->PutAsync(uri, data, size);
+  }
+  std::future<galois::Result<void>> GetAsync(
+      const std::string& uri, uint64_t start, uint64_t size,
+      uint8_t* result_buf) override {
+    return std::async(std::launch::async, [=]() -> galois::Result<void> {
+      return GetMultiSync(uri, start, size, result_buf);
+    });
+  }
+  std::future<galois::Result<void>> ListAsync(
+      const std::string& directory, std::vector<std::string>* list,
+      std::vector<uint64_t>* size) override {
+    return backend_->ListAsync(directory, list, size);
+  }
+  galois::Result<void> Delete(
+      const std::string& directory,
+      const std::unordered_set<std::string>& files) override;
+
+  galois::Result<uint8_t*> Mmap(
+      const std::string& uri, uint64_t size) override {
+    return backend_->Mmap(uri, size);
+  }
+
+  galois::Result<std::string> MultipartBegin(
+      const std::string& uri, uint64_t part_size) override {
+    Forget(uri);
+    return backend_->MultipartBegin(uri, part_size);
+  }
+  std::future<galois::Result<void>> MultipartPutAsync(
+      const std::string& uri, const std::string& upload_id,
+      uint64_t part_number, const uint8_t* data, uint64_t size) override {
+    return backend_->MultipartPutAsync(
+        uri, upload_id, part_number, data, size);
+  }
+  galois::Result<void> MultipartComplete(
+      const std::string& uri, const std::string& upload_id,
+      uint64_t num_parts) override {
+    Forget(uri);
+    return backend_->MultipartComplete(uri, upload_id, num_parts);
+  }
+  galois::Result<void> MultipartAbort(
+      const std::string& uri, const std::string& upload_id) override {
+    return backend_->MultipartAbort(uri, upload_id);
+  }
+
+private:
+  struct Entry {
+    // size of the block file, including its header
+    uint64_t size;
+    std::string uri;
+    // the object when the block was fetched
+    StatBuf object;
+    std::list<std::string>::iterator lru_pos;
+  };
+
+  FileStorage* backend_;
+  std::string cache_dir_;
+  uint64_t capacity_;
+
+  std::mutex mutex_;
+  // names of cached blocks, most recently used first
+  std::list<std::string> lru_;
+  std::unordered_map<std::string, Entry> entries_;
+  uint64_t cached_bytes_{0};
+  std::unordered_map<std::string, StatBuf> object_stats_;
+  // Number of calls to Forget; a block fetched before a Forget may be stale
+  // and is not inserted
+  uint64_t generation_{0};
+
+  std::string BlockName(const std::string& uri, uint64_t block) const;
+  std::string BlockPath(const std::string& name) const;
+
+  galois::Result<StatBuf> ObjectStat(const std::string& uri);
+
+  uint64_t generation();
+
+  bool Contains(
+      const std::string& name, const std::string& uri, const StatBuf& object);
+  /// Copy size bytes at offset of a cached block of uri to out. Returns false
+  /// if the block is not cached or was fetched from another version of the
+  /// object.
+  bool ReadCached(
+      const std::string& name, const std::string& uri, const StatBuf& object,
+      uint64_t offset, uint64_t size, uint8_t* out);
+  /// Cache a block of uri fetched when generation() was generation
+  void Insert(
+      const std::string& name, const std::string& uri, const StatBuf& object,
+      const uint8_t* data, uint64_t size, uint64_t generation);
+  void AddEntryLocked(
+      const std::string& name, const std::string& uri, const StatBuf& object,
+      uint64_t size);
+  void RemoveEntryLocked(const std::string& name);
+  void EvictLocked();
+
+  /// Drop any cached blocks of uri
+  void Forget(const std::string& uri);
+};
+
+}  // namespace tsuba
+
+#endif
@@ -2,14 +2,108 @@
 
 #include <sys/mman.h>
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <vector>
+
 #include "galois/Logging.h"
 #include "galois/Platform.h"
 #include "galois/Result.h"
 #include "tsuba/Errors.h"
+#include "tsuba/Stats.h"
 #include "tsuba/file.h"
 
 namespace tsuba {
 
+/// State of the multipart upload of a streaming FileFrame
+struct FileFrame::Upload {
+  struct Part {
+    std::future<galois::Result<void>> result;
+    std::vector<uint8_t> buf;
+  };
+
+  // empty until the first part is full
+  std::string upload_id;
+  uint64_t part_size{};
+  uint64_t max_parts_in_flight{};
+  // number of parts started so far
+  uint64_t num_parts{};
+  // the part being filled; its size is the number of bytes written to it.
+  // Until the first part is full, it only grows as needed, so that small
+  // files do not hold a whole part.
+  std::vector<uint8_t> part;
+  // parts being stored, oldest first
+  std::deque<Part> in_flight;
+  // buffers of stored parts, for reuse
+  std::vector<std::vector<uint8_t>> free_bufs;
+  // first error from storing a part
+  galois::Result<void> status{galois::ResultSuccess()};
+
+  /// Wait for the oldest part in flight and keep its buffer for reuse
+  void WaitOldest() {
+    Part done = std::move(in_flight.front());
+    in_flight.pop_front();
+    if (auto res = done.result.get(); !res && status) {
+      status = res.error();
+    }
+    done.buf.clear();
+    free_bufs.emplace_back(std::move(done.buf));
+  }
+
+  void WaitAll() {
+    while (!in_flight.empty()) {
+      WaitOldest();
+    }
+  }
+
+  uint64_t held_bytes() const {
+    uint64_t total = part.capacity();
+    for (const Part& p : in_flight) {
+      total += p.buf.capacity();
+    }
+    for (const std::vector<uint8_t>& buf : free_bufs) {
+      total += buf.capacity();
+    }
+    return total;
+  }
+};
+
+FileFrame::FileFrame() = default;
+
+FileFrame::FileFrame(FileFrame&& other) noexcept
+    : path_(other.path_),
+      map_start_(other.map_start_),
+      map_size_(other.map_size_),
+      region_size_(other.region_size_),
+      cursor_(other.cursor_),
+      valid_(other.valid_),
+      synced_(other.synced_),
+      finished_(other.finished_),
+      upload_(std::move(other.upload_)) {
+  other.valid_ = false;
+}
+
+FileFrame&
+FileFrame::operator=(FileFrame&& other) noexcept {
+  if (&other != this) {
+    if (auto res = Destroy(); !res) {
+      GALOIS_LOG_ERROR("Destroy: {}", res.error());
+    }
+    path_ = other.path_;
+    map_start_ = other.map_start_;
+    map_size_ = other.map_size_;
+    region_size_ = other.region_size_;
+    cursor_ = other.cursor_;
+    synced_ = other.synced_;
+    valid_ = other.valid_;
+    finished_ = other.finished_;
+    upload_ = std::move(other.upload_);
+    other.valid_ = false;
+  }
+  return *this;
+}
+
 FileFrame::~FileFrame() {
   if (auto res = Destroy(); !res) {
     GALOIS_LOG_ERROR("Destroy failed in ~FileFrame");
@@ -18,6 +112,9 @@ FileFrame::~FileFrame() {
 
 galois::Result<void>
 FileFrame::Destroy() {
+  if (upload_) {
+    AbortUpload();
+  }
   if (valid_) {
     int err = munmap(map_start_, map_size_);
     valid_ = false;
@@ -45,16 +142,135 @@ FileFrame::Init(uint64_t reserved_size) {
   map_size_ = map_size;
   map_start_ = static_cast<uint8_t*>(ptr);
   synced_ = false;
+  finished_ = false;
   valid_ = true;
   cursor_ = 0;
   return galois::ResultSuccess();
 }
 
+galois::Result<void>
+FileFrame::InitStreaming(
+    std::string_view path, uint64_t part_size, uint64_t max_in_flight_bytes) {
+  if (part_size == 0) {
+    return ErrorCode::InvalidArgument;
+  }
+  // Keep a small mapping so that the FileFrame is valid, but all data goes
+  // through upload_
+  if (auto res = Init(); !res) {
+    return res.error();
+  }
+  path_ = path;
+
+  auto upload = std::make_unique<Upload>();
+  upload->part_size = part_size;
+  // the part being filled counts against the budget
+  upload->max_parts_in_flight =
+      std::max<uint64_t>(1, max_in_flight_bytes / part_size) - 1;
+  upload_ = std::move(upload);
+  return galois::ResultSuccess();
+}
+
 void
 FileFrame::Bind(std::string_view filename) {
+  if (upload_) {
+    GALOIS_LOG_ERROR(
+        "cannot bind streaming FileFrame for {} to {}", path_, filename);
+    return;
+  }
   path_ = filename;
 }
 
+uint64_t
+FileFrame::buffered_bytes() const {
+  if (finished_) {
+    return 0;
+  }
+  if (upload_) {
+    return upload_->held_bytes();
+  }
+  return cursor_;
+}
+
+galois::Result<void>
+FileFrame::StartPart() {
+  Upload& upload = *upload_;
+  if (upload.upload_id.empty()) {
+    auto begin_res = FileMultipartBegin(path_, upload.part_size);
+    if (!begin_res) {
+      return begin_res.error();
+    }
+    upload.upload_id = std::move(begin_res.value());
+  }
+  // Even if the budget is smaller than two parts, let one part be stored
+  // while the next is filled
+  if (!upload.in_flight.empty() &&
+      upload.in_flight.size() >= upload.max_parts_in_flight) {
+    StatAdd("FileFrameBudgetWaits", 1);
+    upload.WaitOldest();
+  }
+  if (!upload.status) {
+    return upload.status.error();
+  }
+
+  uint64_t part_number = upload.num_parts++;
+  const uint8_t* data = upload.part.data();
+  uint64_t size = upload.part.size();
+  upload.in_flight.emplace_back(Upload::Part{
+      .result = FileMultipartPutAsync(
+          path_, upload.upload_id, part_number, data, size),
+      .buf = std::move(upload.part),
+  });
+  StatAdd("FileFrameParts", 1);
+
+  if (upload.free_bufs.empty()) {
+    upload.part = std::vector<uint8_t>();
+    upload.part.reserve(upload.part_size);
+  } else {
+    upload.part = std::move(upload.free_bufs.back());
+    upload.free_bufs.pop_back();
+  }
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+FileFrame::FinishUpload() {
+  if (upload_->upload_id.empty()) {
+    // Never more than one part, so store it whole
+    std::unique_ptr<Upload> upload = std::move(upload_);
+    finished_ = true;
+    return FileStore(path_, upload->part.data(), upload->part.size());
+  }
+  if (!upload_->part.empty()) {
+    if (auto res = StartPart(); !res) {
+      AbortUpload();
+      return res.error();
+    }
+  }
+  upload_->WaitAll();
+  if (!upload_->status) {
+    auto err = upload_->status.error();
+    AbortUpload();
+    return err;
+  }
+
+  std::unique_ptr<Upload> upload = std::move(upload_);
+  finished_ = true;
+  return FileMultipartComplete(path_, upload->upload_id, upload->num_parts);
+}
+
+void
+FileFrame::AbortUpload() {
+  std::unique_ptr<Upload> upload = std::move(upload_);
+  finished_ = true;
+  upload->WaitAll();
+  if (upload->upload_id.empty()) {
+    return;
+  }
+  if (auto res = FileMultipartAbort(path_, upload->upload_id); !res) {
+    GALOIS_LOG_DEBUG("aborting upload of {}: {}", path_, res.error());
+  }
+}
+
 galois::Result<void>
 FileFrame::GrowBuffer(int64_t accomodate) {
   // We need a bigger buffer
@@ -96,13 +312,16 @@ FileFrame::GrowBuffer(int64_t accomodate) {
 
 galois::Result<void>
 FileFrame::Persist() {
-  if (!valid_) {
+  if (!valid_ || finished_) {
     return tsuba::ErrorCode::InvalidArgument;
   }
   if (path_.empty()) {
     GALOIS_LOG_DEBUG("No path provided to FileFrame");
     return tsuba::ErrorCode::InvalidArgument;
   }
+  if (upload_) {
+    return FinishUpload();
+  }
   if (auto res = tsuba::FileStore(path_, map_start_, cursor_); !res) {
     return res.error();
   }
@@ -111,13 +330,18 @@ FileFrame::Persist() {
 
 std::future<galois::Result<void>>
 FileFrame::PersistAsync() {
-  if (!valid_) {
+  if (!valid_ || finished_) {
     return galois::AsyncError<void>(tsuba::ErrorCode::InvalidArgument);
   }
   if (path_.empty()) {
     GALOIS_LOG_DEBUG("No path provided to FileFrame");
     return galois::AsyncError<void>(tsuba::ErrorCode::InvalidArgument);
   }
+  if (upload_) {
+    // Most parts are already stored or in flight; the caller (e.g.,
+    // WriteGroup::StartStore) waits for the rest
+    return std::async(std::launch::deferred, [this]() { return Persist(); });
+  }
   return tsuba::FileStoreAsync(path_, map_start_, cursor_);
 }
 
@@ -141,18 +365,11 @@ FileFrame::Tell() const {
 
 bool
 FileFrame::closed() const {
-  return !valid_;
+  return !valid_ || finished_;
 }
 
 arrow::Status
-FileFrame::Write(const void* data, int64_t nbytes) {
-  if (!valid_) {
-    return arrow::Status(arrow::StatusCode::Invalid, "Invalid FileFrame");
-  }
-  if (nbytes < 0) {
-    return arrow::Status(
-        arrow::StatusCode::Invalid, "Cannot Write negative bytes");
-  }
+FileFrame::WriteBuffer(const uint8_t* data, uint64_t nbytes) {
   if (cursor_ + nbytes > map_size_) {
     if (auto res = GrowBuffer(nbytes); !res) {
       return arrow::Status(
@@ -165,6 +382,56 @@ FileFrame::Write(const void* data, int64_t nbytes) {
   return arrow::Status::OK();
 }
 
+arrow::Status
+FileFrame::Write(const void* data, int64_t nbytes) {
+  if (!valid_ || finished_) {
+    return arrow::Status(arrow::StatusCode::Invalid, "Invalid FileFrame");
+  }
+  if (nbytes < 0) {
+    return arrow::Status(
+        arrow::StatusCode::Invalid, "Cannot Write negative bytes");
+  }
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  while (upload_ && nbytes > 0) {
+    std::vector<uint8_t>& part = upload_->part;
+    uint64_t n = std::min<uint64_t>(nbytes, upload_->part_size - part.size());
+    if (part.size() + n > part.capacity()) {
+      // grow geometrically, but never past one part
+      part.reserve(std::min<uint64_t>(
+          upload_->part_size,
+          std::max<uint64_t>(2 * part.capacity(), part.size() + n)));
+    }
+    part.insert(part.end(), bytes, bytes + n);
+    bytes += n;
+    nbytes -= n;
+    cursor_ += n;
+    if (part.size() < upload_->part_size) {
+      continue;
+    }
+    auto res = StartPart();
+    if (!res && res.error() == ErrorCode::NotImplemented &&
+        upload_->upload_id.empty()) {
+      // No multipart uploads to this path; buffer what was written so far
+      // and everything after it
+      GALOIS_LOG_DEBUG(
+          "multipart upload not supported for {}; buffering", path_);
+      std::unique_ptr<Upload> upload = std::move(upload_);
+      cursor_ = 0;
+      if (auto status = WriteBuffer(upload->part.data(), upload->part.size());
+          !status.ok()) {
+        return status;
+      }
+    } else if (!res) {
+      return arrow::Status::IOError(
+          "FileFrame could not store part: ", res.error());
+    }
+  }
+  if (upload_) {
+    return arrow::Status::OK();
+  }
+  return WriteBuffer(bytes, nbytes);
+}
+
 arrow::Status
 FileFrame::Write(const std::shared_ptr<arrow::Buffer>& data) {
   return Write(data->data(), data->size());
@@ -1,6 +1,7 @@
 #include "tsuba/FileStorage.h"
 
 #include "FileStorage_internal.h"
+#include "tsuba/Errors.h"
 
 std::vector<tsuba::FileStorage*>&
 tsuba::GetRegisteredFileStorages() {
@@ -12,3 +13,40 @@ void
 tsuba::RegisterFileStorage(FileStorage* fs) {
   GetRegisteredFileStorages().emplace_back(fs);
 }
+
+galois::Result<uint8_t*>
+tsuba::FileStorage::Mmap(
+    [[maybe_unused]] const std::string& uri, [[maybe_unused]] uint64_t size) {
+  return ErrorCode::NotImplemented;
+}
+
+galois::Result<std::string>
+tsuba::FileStorage::MultipartBegin(
+    [[maybe_unused]] const std::string& uri,
+    [[maybe_unused]] uint64_t part_size) {
+  return ErrorCode::NotImplemented;
+}
+
+std::future<galois::Result<void>>
+tsuba::FileStorage::MultipartPutAsync(
+    [[maybe_unused]] const std::string& uri,
+    [[maybe_unused]] const std::string& upload_id,
+    [[maybe_unused]] uint64_t part_number,
+    [[maybe_unused]] const uint8_t* data, [[maybe_unused]] uint64_t size) {
+  return galois::AsyncError<void>(ErrorCode::NotImplemented);
+}
+
+galois::Result<void>
+tsuba::FileStorage::MultipartComplete(
+    [[maybe_unused]] const std::string& uri,
+    [[maybe_unused]] const std::string& upload_id,
+    [[maybe_unused]] uint64_t num_parts) {
+  return ErrorCode::NotImplemented;
+}
+
+galois::Result<void>
+tsuba::FileStorage::MultipartAbort(
+    [[maybe_unused]] const std::string& uri,
+    [[maybe_unused]] const std::string& upload_id) {
+  return ErrorCode::NotImplemented;
+}
@@ -3,13 +3,18 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdio>
+#include <cstring>
 #include <string>
 
+#include "galois/Env.h"
 #include "galois/Logging.h"
 #include "galois/Result.h"
 #include "tsuba/Errors.h"
+#include "tsuba/Stats.h"
 #include "tsuba/file.h"
 
 /*
@@ -30,8 +35,48 @@
  * somehow and also tell users to not modify our files?
  */
 
+namespace {
+
+bool
+TestBit(const std::vector<uint64_t>& bitmap, uint64_t page) {
+  return bitmap[page / 64] & (UINT64_C(1) << (63 - page % 64));
+}
+
+void
+SetBit(std::vector<uint64_t>* bitmap, uint64_t page) {
+  (*bitmap)[page / 64] |= UINT64_C(1) << (63 - page % 64);
+}
+
+void
+ClearBit(std::vector<uint64_t>* bitmap, uint64_t page) {
+  (*bitmap)[page / 64] &= ~(UINT64_C(1) << (63 - page % 64));
+}
+
+}  // namespace
+
 namespace tsuba {
 
+ReadAheadPolicy::~ReadAheadPolicy() = default;
+
+SequentialReadAhead::SequentialReadAhead() : max_window_(kDefaultMaxWindow) {
+  if (int mb = 0; galois::GetEnv("TSUBA_READ_AHEAD_MAX_MB", &mb) && mb >= 0) {
+    max_window_ = static_cast<uint64_t>(mb) << 20;
+  }
+}
+
+std::pair<uint64_t, uint64_t>
+SequentialReadAhead::NextRange(
+    uint64_t start, uint64_t size, uint64_t file_size) {
+  uint64_t end = start + size;
+  if (start == last_end_ && window_ > 0) {
+    window_ = std::min(window_ * 2, max_window_);
+  } else {
+    window_ = std::min(size + size / 10, max_window_);
+  }
+  last_end_ = end;
+  return std::make_pair(end, std::min(end + window_, file_size));
+}
+
 FileView::~FileView() {
   if (auto res = Unbind(); !res) {
     GALOIS_LOG_ERROR("Unbind: {}", res.error());
@@ -44,9 +89,16 @@ FileView::Unbind() {
   if (valid_) {
     // Resolve all outstanding reads so they don't write to the memory we are
     // about to unmap
-    if (auto res = Resolve(0, file_size_); !res) {
+    if (auto res = Resolve(0, file_size_, false); !res) {
       return res.error();
     }
+    uint64_t wasted_pages = 0;
+    for (uint64_t bits : prefetched_) {
+      wasted_pages += __builtin_popcountll(bits);
+    }
+    if (wasted_pages > 0) {
+      StatAdd("FileViewPrefetchWastedBytes", wasted_pages << page_shift_);
+    }
     if (map_start_ != nullptr) {
       if (int err = munmap(map_start_, file_size_); err) {
         return galois::ResultErrno();
@@ -70,19 +122,30 @@ FileView::Bind(
     return ErrorCode::InvalidArgument;
   }
 
-  // SCB 2020-07-23: Given that page_shift_ is treated as a compile-time
-  // constant, it seems silly to have it be a member of this class. But I can
-  // imagine one day wanting to set it dynamically based on file type, file
-  // size, type of backing storage, etc. So make it a class member and set it
-  // here.
-  page_shift_ = 20; /* 1M */
   void* tmp = nullptr;
+  bool mapped = false;
+
+  // If storage can map the file itself, the page cache does the filling and we
+  // avoid holding a private copy of every byte. Empty files cannot be mapped.
+  static bool do_not_mmap = galois::GetEnv("TSUBA_DO_NOT_MMAP");
+  if (buf.size > 0 && !do_not_mmap) {
+    if (auto res = FileMmap(filename_, buf.size); res) {
+      tmp = res.value();
+      mapped = true;
+    } else if (res.error() != ErrorCode::NotImplemented) {
+      GALOIS_LOG_DEBUG(
+          "FileMmap: {}: {}, falling back to reads", filename_, res.error());
+    }
+  }
 
-  // Map enough virtual memory to hold entire file, but do not populate it
-  tmp = mmap(nullptr, buf.size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-  if (tmp == MAP_FAILED) {
-    GALOIS_LOG_ERROR("mmap: {}", std::strerror(errno));
-    return galois::ResultErrno();
+  if (!mapped) {
+    // Map enough virtual memory to hold entire file, but do not populate it
+    tmp =
+        mmap(nullptr, buf.size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (tmp == MAP_FAILED) {
+      GALOIS_LOG_ERROR("mmap: {}", std::strerror(errno));
+      return galois::ResultErrno();
+    }
   }
 
   if (auto res = Unbind(); !res) {
@@ -90,8 +153,18 @@ FileView::Bind(
   }
 
   map_start_ = static_cast<uint8_t*>(tmp);
+  mapped_ = mapped;
   mem_start_ = -1;
-  filling_.resize(page_number(buf.size) / 64 + 1, 0);
+  // Storage with higher latency uses larger pages
+  page_shift_ = FilePageShift(filename_);
+  filling_.assign(page_number(buf.size) / 64 + 1, 0);
+  prefetched_.assign(filling_.size(), 0);
+  referenced_.assign(filling_.size(), 0);
+  resident_pages_ = 0;
+  clock_hand_ = 0;
+  if (!read_ahead_) {
+    read_ahead_ = std::make_unique<SequentialReadAhead>();
+  }
   file_size_ = buf.size;
   fetches_ = std::make_unique<std::vector<FillingRange>>();
   if (auto res = Fill(begin, in_end, resolve); !res) {
@@ -105,6 +178,13 @@ FileView::Bind(
 
 galois::Result<void>
 FileView::Fill(uint64_t begin, uint64_t end, bool resolve) {
+  return DoFill(begin, end, resolve, false, 0, 0);
+}
+
+galois::Result<void>
+FileView::DoFill(
+    uint64_t begin, uint64_t end, bool resolve, bool prefetch,
+    uint64_t pin_begin, uint64_t pin_end) {
   uint64_t in_end = std::min<uint64_t>(end, file_size_);
   uint64_t in_begin = std::min<uint64_t>(begin, in_end);
   uint64_t first_page = 0;
@@ -130,7 +210,14 @@ FileView::Fill(uint64_t begin, uint64_t end, bool resolve) {
     uint64_t map_size = std::min(
         (last_page + 1) * (1UL << page_shift_) - file_off,
         file_size_ - file_off);
-    if (found_empty) {
+    if (found_empty && mapped_) {
+      // The file already backs this region; just ask the kernel to start
+      // reading it so that later accesses do not fault synchronously
+      if (int err = madvise(map_start_ + file_off, map_size, MADV_WILLNEED);
+          err) {
+        GALOIS_LOG_DEBUG("madvise: {}", std::strerror(errno));
+      }
+    } else if (found_empty) {
       // Get physical pages for the region we are about to write
       int err =
           mprotect(map_start_ + file_off, map_size, PROT_READ | PROT_WRITE);
@@ -144,9 +231,26 @@ FileView::Fill(uint64_t begin, uint64_t end, bool resolve) {
       GALOIS_LOG_ASSERT(peek_fut.valid());
       FillingRange fetch = {first_page, last_page, std::move(peek_fut)};
       fetches_->push_back(std::move(fetch));
+    }
+    if (found_empty) {
+      for (uint64_t page = first_page; page <= last_page; ++page) {
+        if (!TestBit(filling_, page)) {
+          ++resident_pages_;
+        }
+        if (!prefetch) {
+          SetBit(&referenced_, page);
+        }
+      }
       if (auto res = MarkFilled(&filling_[0], first_page, last_page); !res) {
         return res.error();
       }
+      if (prefetch) {
+        if (auto res = MarkFilled(&prefetched_[0], first_page, last_page);
+            !res) {
+          return res.error();
+        }
+        StatAdd("FileViewPrefetchBytes", map_size);
+      }
       if (resolve) {
         if (auto res = Resolve(file_off, map_size); !res) {
           return res.error();
@@ -156,11 +260,46 @@ FileView::Fill(uint64_t begin, uint64_t end, bool resolve) {
       if (mem_start_ < 0 || signed_begin < mem_start_) {
         mem_start_ = signed_begin;
       }
+      if (residency_budget_ > 0) {
+        // an empty pinned range keeps no pages
+        uint64_t pin_first = 1;
+        uint64_t pin_last = 0;
+        if (pin_begin < pin_end) {
+          pin_first = page_number(pin_begin);
+          pin_last = page_number(pin_end - 1);
+        }
+        if (auto res = Evict(
+                page_number(in_begin), page_number(in_end - 1), pin_first,
+                pin_last);
+            !res) {
+          return res.error();
+        }
+      }
     }
   }
   return galois::ResultSuccess();
 }
 
+galois::Result<void>
+FileView::EnsureResident(uint64_t begin, uint64_t end) {
+  if (!valid_) {
+    return ErrorCode::InvalidArgument;
+  }
+  if (auto res = Fill(begin, end, true); !res) {
+    return res.error();
+  }
+  // The region may have been filled earlier but still be in flight, e.g., if
+  // it was prefetched
+  uint64_t in_end = std::min<uint64_t>(end, file_size_);
+  if (begin < in_end) {
+    if (auto res = Resolve(begin, in_end - begin); !res) {
+      return res.error();
+    }
+    MarkRead(begin, in_end - begin);
+  }
+  return galois::ResultSuccess();
+}
+
 bool
 FileView::Equals(const FileView& other) const {
   if (!valid_ || !other.valid_) {
@@ -230,24 +369,37 @@ FileView::Read(int64_t nbytes) {
   if (cursor_ + nbytes > file_size_) {
     nbytes_internal = file_size_ - cursor_;
   }
-  // fetch data from storage if necessary
-  if (auto res = Fill(cursor_, cursor_ + nbytes_internal, true); !res) {
+  // start fetching data from storage if necessary
+  if (auto res = Fill(cursor_, cursor_ + nbytes_internal, false); !res) {
     return arrow::Status(arrow::StatusCode::IOError, "FileView::Fill");
   }
+  // prefetch before waiting so that the read ahead is requested while this
+  // read is still in flight
+  if (auto res = PreFetch(cursor_, nbytes_internal); !res) {
+    // TODO (scober): Include res.error() as part of arrow Status
+    return arrow::Status(arrow::StatusCode::IOError, "prefetching");
+  }
   // resolve outstanding relevant fetches
   if (auto res = Resolve(cursor_, nbytes_internal); !res) {
     // TODO (scober): Include res.error() as part of arrow Status
     return arrow::Status(
         arrow::StatusCode::IOError, "Resolving asynchronous reads");
   }
-  // prefetch
-  if (auto res = PreFetch(cursor_, nbytes_internal); !res) {
-    // TODO (scober): Include res.error() as part of arrow Status
-    return arrow::Status(arrow::StatusCode::IOError, "prefetching");
-  }
+  MarkRead(cursor_, nbytes_internal);
   // and return the requested data
-  auto ret =
-      std::make_shared<arrow::Buffer>(map_start_ + cursor_, nbytes_internal);
+  std::shared_ptr<arrow::Buffer> ret;
+  if (residency_budget_ > 0) {
+    // The pages under a zero-copy buffer could be released by a later fill
+    auto alloc_res = arrow::AllocateBuffer(nbytes_internal);
+    if (!alloc_res.ok()) {
+      return alloc_res.status();
+    }
+    ret = std::move(alloc_res.ValueOrDie());
+    std::memcpy(ret->mutable_data(), map_start_ + cursor_, nbytes_internal);
+  } else {
+    ret =
+        std::make_shared<arrow::Buffer>(map_start_ + cursor_, nbytes_internal);
+  }
   cursor_ += nbytes_internal;
   return ret;
 }
@@ -265,21 +417,23 @@ FileView::Read(int64_t nbytes, void* out) {
   if (cursor_ + nbytes > file_size_) {
     nbytes_internal = file_size_ - cursor_;
   }
-  // fetch data from storage if necessary
-  if (auto res = Fill(cursor_, cursor_ + nbytes_internal, true); !res) {
+  // start fetching data from storage if necessary
+  if (auto res = Fill(cursor_, cursor_ + nbytes_internal, false); !res) {
     return arrow::Status(arrow::StatusCode::IOError, "FileView::Fill");
   }
+  // prefetch before waiting so that the read ahead is requested while this
+  // read is still in flight
+  if (auto res = PreFetch(cursor_, nbytes_internal); !res) {
+    // TODO (scober): Include res.error() as part of arrow Status
+    return arrow::Status(arrow::StatusCode::IOError, "prefetching");
+  }
   // resolve outstanding relevant fetches
   if (auto res = Resolve(cursor_, nbytes_internal); !res) {
     // TODO (scober): Include res.error() as part of arrow Status
     return arrow::Status(
         arrow::StatusCode::IOError, "Resolving asynchronous reads");
   }
-  // prefetch
-  if (auto res = PreFetch(cursor_, nbytes_internal); !res) {
-    // TODO (scober): Include res.error() as part of arrow Status
-    return arrow::Status(arrow::StatusCode::IOError, "prefetching");
-  }
+  MarkRead(cursor_, nbytes_internal);
   // and return the requested data
   std::memcpy(out, map_start_ + cursor_, nbytes_internal);
   cursor_ += nbytes_internal;
@@ -452,16 +606,27 @@ FileView::MarkFilled(uint64_t* bitmap, uint64_t begin, uint64_t end) {
 }
 
 galois::Result<void>
-FileView::Resolve(int64_t start, int64_t size) {
+FileView::Resolve(int64_t start, int64_t size, bool record_stalls) {
+  if (size <= 0) {
+    return galois::ResultSuccess();
+  }
+  uint64_t first = page_number(start);
+  uint64_t last = page_number(start + size - 1);
+  auto stall_start = std::chrono::steady_clock::now();
+  bool stalled = false;
+
   // This loop could do less work by sorting the vector or storing an
   // interval tree, but that seems like overkill unless this becomes a
   // bottleneck
   for (auto it = fetches_->begin(); it != fetches_->end();) {
     auto fetch = it;
-    if (fetch->first_page <= page_number(start + size) ||
-        fetch->last_page >= page_number(start)) {
+    if (fetch->first_page <= last && fetch->last_page >= first) {
       // Complete the remaining work if there is some
       if (fetch->work.valid()) {
+        if (fetch->work.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready) {
+          stalled = true;
+        }
         if (auto res = fetch->work.get(); !res) {
           return res.error();
         }
@@ -473,21 +638,100 @@ FileView::Resolve(int64_t start, int64_t size) {
       ++it;
     }
   }
+
+  if (stalled && record_stalls) {
+    StatAdd("FileViewStalls", 1);
+    StatAdd(
+        "FileViewStallMicroseconds",
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - stall_start)
+            .count());
+  }
+  return galois::ResultSuccess();
+}
+
+void
+FileView::MarkRead(int64_t start, int64_t size) {
+  if (size <= 0) {
+    return;
+  }
+  for (uint64_t page = page_number(start),
+                last = page_number(start + size - 1);
+       page <= last; ++page) {
+    ClearBit(&prefetched_, page);
+    SetBit(&referenced_, page);
+  }
+}
+
+bool
+FileView::InFlight(uint64_t page) const {
+  for (const FillingRange& fetch : *fetches_) {
+    if (fetch.first_page <= page && page <= fetch.last_page) {
+      return true;
+    }
+  }
+  return false;
+}
+
+galois::Result<void>
+FileView::Evict(
+    uint64_t keep_first, uint64_t keep_last, uint64_t pin_first,
+    uint64_t pin_last) {
+  uint64_t num_pages = page_number(file_size_ - 1) + 1;
+  uint64_t page_size = UINT64_C(1) << page_shift_;
+
+  // CLOCK replacement: the hand clears the referenced bit of each resident
+  // page it passes and releases pages whose bit was already clear. Two
+  // sweeps visit every page with its bit clear at least once.
+  for (uint64_t scanned = 0;
+       resident_bytes() > residency_budget_ && scanned < 2 * num_pages;
+       ++scanned) {
+    uint64_t page = clock_hand_;
+    clock_hand_ = (clock_hand_ + 1) % num_pages;
+    if (!TestBit(filling_, page) || (keep_first <= page && page <= keep_last) ||
+        (pin_first <= page && page <= pin_last) || InFlight(page)) {
+      continue;
+    }
+    if (TestBit(referenced_, page)) {
+      ClearBit(&referenced_, page);
+      continue;
+    }
+
+    uint64_t offset = page * page_size;
+    uint64_t size = std::min<uint64_t>(page_size, file_size_ - offset);
+    if (int err = madvise(map_start_ + offset, size, MADV_DONTNEED); err) {
+      GALOIS_LOG_ERROR("madvise: {}", std::strerror(errno));
+      return galois::ResultErrno();
+    }
+    // Anonymous memory reads as zeroes after MADV_DONTNEED; protect it again
+    // so that stale accesses fault rather than see wrong data
+    if (!mapped_) {
+      if (int err = mprotect(map_start_ + offset, size, PROT_NONE); err) {
+        GALOIS_LOG_ERROR("mprotect: {}", std::strerror(errno));
+        return galois::ResultErrno();
+      }
+    }
+    ClearBit(&filling_, page);
+    ClearBit(&prefetched_, page);
+    --resident_pages_;
+    StatAdd("FileViewEvictedBytes", size);
+  }
   return galois::ResultSuccess();
 }
 
 galois::Result<void>
 FileView::PreFetch(int64_t start, int64_t size) {
-  // Our highly sophisticated prefetching algorithm is to crudely approximate
-  // the size of the last read plus 10%. This is largely motivated by parquet
-  // files, which consecutively read row groups that are (in theory)
-  // approximately the same size.
-  int64_t fetch_size = (size / 10) * 11;
-  // Make sure we haven't overflown
-  assert(fetch_size >= 0);
-  uint64_t begin = static_cast<uint64_t>(start + size);
-  uint64_t end = static_cast<uint64_t>(start + size + fetch_size);
-  if (auto res = Fill(begin, end, false); !res) {
+  if (!read_ahead_) {
+    return galois::ResultSuccess();
+  }
+  auto [begin, end] = read_ahead_->NextRange(start, size, file_size_);
+  if (begin >= end) {
+    return galois::ResultSuccess();
+  }
+  // The pages of the current read may be resident but not yet copied out, so
+  // they must not be released to make room for the read ahead
+  uint64_t read_end = std::min<uint64_t>(start + size, file_size_);
+  if (auto res = DoFill(begin, end, false, true, start, read_end); !res) {
     return res.error();
   }
   return galois::ResultSuccess();
@@ -2,15 +2,19 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 
 #include "FileStorage_internal.h"
 #include "MemoryNameServerClient.h"
+#include "galois/Env.h"
 #include "galois/Logging.h"
 #include "galois/Result.h"
 #include "tsuba/Errors.h"
 
 namespace {
 
+constexpr uint64_t kDefaultCacheMB = 10 << 10; /* 10G */
+
 galois::Result<std::unique_ptr<tsuba::NameServerClient>>
 GetMemoryClient() {
   return std::make_unique<tsuba::MemoryNameServerClient>();
@@ -45,6 +49,19 @@ tsuba::GlobalState::FS(std::string_view uri) const {
   return GetDefaultFS();
 }
 
+void
+tsuba::GlobalState::WrapWithCache(
+    const std::string& cache_dir, uint64_t capacity) {
+  for (FileStorage*& fs : file_stores_) {
+    if (fs == &local_storage_) {
+      continue;
+    }
+    caching_storages_.emplace_back(
+        std::make_unique<CachingStorage>(fs, cache_dir, capacity));
+    fs = caching_storages_.back().get();
+  }
+}
+
 tsuba::NameServerClient*
 tsuba::GlobalState::NS() const {
   return name_server_client_;
@@ -69,6 +86,30 @@ tsuba::GlobalState::Init(
   }
   registered.clear();
 
+  if (std::string cache_dir; galois::GetEnv("TSUBA_CACHE_DIR", &cache_dir)) {
+    uint64_t cache_mb = kDefaultCacheMB;
+    if (int mb = 0; galois::GetEnv("TSUBA_CACHE_MB", &mb)) {
+      if (mb < 0) {
+        GALOIS_LOG_WARN("ignoring TSUBA_CACHE_MB={}", mb);
+      } else {
+        cache_mb = mb;
+      }
+    }
+    global_state->WrapWithCache(cache_dir, cache_mb << 20);
+  }
+
+  if (int ttl_ms = 0; galois::GetEnv("TSUBA_NS_CACHE_TTL_MS", &ttl_ms)) {
+    if (ttl_ms <= 0) {
+      GALOIS_LOG_WARN("ignoring TSUBA_NS_CACHE_TTL_MS={}", ttl_ms);
+    } else {
+      global_state->caching_name_server_client_ =
+          std::make_unique<CachingNameServerClient>(
+              ns, std::chrono::milliseconds(ttl_ms));
+      global_state->name_server_client_ =
+          global_state->caching_name_server_client_.get();
+    }
+  }
+
   std::sort(
       global_state->file_stores_.begin(), global_state->file_stores_.end(),
       [](const FileStorage* lhs, const FileStorage* rhs) {
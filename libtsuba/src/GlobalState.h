@@ -4,7 +4,10 @@
 #include <memory>
 #include <vector>
 
+#include "CachingNameServerClient.h"
+#include "CachingStorage.h"
 #include "LocalStorage.h"
+#include "SimStorage.h"
 #include "galois/CommBackend.h"
 #include "galois/Logging.h"
 #include "galois/Result.h"
@@ -24,10 +27,19 @@ class GlobalState {
   tsuba::NameServerClient* name_server_client_;
 
   tsuba::LocalStorage local_storage_;
+  tsuba::SimStorage sim_storage_;
+  // wrappers of remote storage backends when TSUBA_CACHE_DIR is set
+  std::vector<std::unique_ptr<tsuba::CachingStorage>> caching_storages_;
+  // wrapper of the name server client when TSUBA_NS_CACHE_TTL_MS is set
+  std::unique_ptr<tsuba::CachingNameServerClient> caching_name_server_client_;
+
+  /// Put a CachingStorage in front of every backend except local storage
+  void WrapWithCache(const std::string& cache_dir, uint64_t capacity);
 
   GlobalState(galois::CommBackend* comm, tsuba::NameServerClient* ns)
       : comm_(comm), name_server_client_(ns) {
     file_stores_.emplace_back(&local_storage_);
+    file_stores_.emplace_back(&sim_storage_);
   }
 
   FileStorage* GetDefaultFS() const;
@@ -50,6 +62,7 @@ public:
   /// abfs://...  -> AzureStore
   /// gs://...    -> GSStore
   /// file://...  -> LocalStore
+  /// sim://...   -> SimStore
   /// {no scheme} -> LocalStore
   FileStorage* FS(std::string_view uri) const;
 
@@ -6,19 +6,76 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
 #include <fstream>
+#include <vector>
 
 #include <boost/filesystem.hpp>
 
 #include "GlobalState.h"
+#include "galois/Env.h"
 #include "galois/Logging.h"
+#include "galois/Random.h"
 #include "galois/Result.h"
 #include "galois/Uri.h"
 #include "tsuba/Errors.h"
+#include "tsuba/Stats.h"
 #include "tsuba/file.h"
 
 namespace fs = boost::filesystem;
 
+namespace {
+
+/// Read up to size bytes at offset, retrying short reads until the end of the
+/// file. Returns the number of bytes read.
+galois::Result<uint64_t>
+PRead(int fd, uint8_t* data, uint64_t offset, uint64_t size) {
+  uint64_t done = 0;
+  while (done < size) {
+    ssize_t ret = pread(fd, data + done, size - done, offset + done);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return galois::ResultErrno();
+    }
+    if (ret == 0) {
+      break;
+    }
+    done += ret;
+  }
+  return done;
+}
+
+/// Write size bytes at offset, retrying short writes
+galois::Result<void>
+PWrite(int fd, const uint8_t* data, uint64_t offset, uint64_t size) {
+  uint64_t done = 0;
+  while (done < size) {
+    ssize_t ret = pwrite(fd, data + done, size - done, offset + done);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return galois::ResultErrno();
+    }
+    done += ret;
+  }
+  return galois::ResultSuccess();
+}
+
+constexpr uint64_t kUploadIdLen = 12;
+
+std::string
+UploadPath(const std::string& path, const std::string& upload_id) {
+  return path + ".upload-" + upload_id;
+}
+
+}  // namespace
+
 void
 tsuba::LocalStorage::CleanUri(std::string* uri) {
   if (uri->find(uri_scheme()) != 0) {
@@ -27,10 +84,25 @@ tsuba::LocalStorage::CleanUri(std::string* uri) {
   *uri = std::string(uri->begin() + uri_scheme().size(), uri->end());
 }
 
+tsuba::LocalStorage::OpenFile::~OpenFile() {
+  if (close(fd_) != 0) {
+    GALOIS_LOG_DEBUG("close: {}", std::strerror(errno));
+  }
+}
+
+bool
+tsuba::LocalStorage::OpenFile::Matches(const struct stat& stat) const {
+  return stat.st_dev == stat_.st_dev && stat.st_ino == stat_.st_ino &&
+         stat.st_size == stat_.st_size &&
+         stat.st_mtim.tv_sec == stat_.st_mtim.tv_sec &&
+         stat.st_mtim.tv_nsec == stat_.st_mtim.tv_nsec;
+}
+
 galois::Result<void>
 tsuba::LocalStorage::WriteFile(
     std::string uri, const uint8_t* data, uint64_t size) {
   CleanUri(&uri);
+  ForgetOpenFile(uri);
   fs::path m_path{uri};
   fs::path dir = m_path.parent_path();
   if (boost::system::error_code err; !fs::create_directories(dir, err)) {
@@ -51,31 +123,227 @@ tsuba::LocalStorage::WriteFile(
 }
 
 galois::Result<void>
-tsuba::LocalStorage::ReadFile(
-    std::string uri, uint64_t start, uint64_t size, uint8_t* data) {
+tsuba::LocalStorage::WritePart(
+    std::string uri, const std::string& upload_id, uint64_t part_number,
+    const uint8_t* data, uint64_t size) {
   CleanUri(&uri);
-  std::ifstream ifile(uri);
+  uint64_t part_size = 0;
+  {
+    std::lock_guard<std::mutex> lock(uploads_mutex_);
+    auto it = uploads_.find(upload_id);
+    if (it == uploads_.end()) {
+      GALOIS_LOG_DEBUG("unknown upload {} for {}", upload_id, uri);
+      return ErrorCode::InvalidArgument;
+    }
+    part_size = it->second;
+  }
+  if (size > part_size) {
+    GALOIS_LOG_DEBUG("part of {} bytes larger than {}", size, part_size);
+    return ErrorCode::InvalidArgument;
+  }
 
-  ifile.seekg(start);
-  if (!ifile) {
-    GALOIS_LOG_DEBUG("failed to seek");
+  std::string tmp_path = UploadPath(uri, upload_id);
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CLOEXEC);
+  if (fd < 0) {
+    GALOIS_LOG_DEBUG("open: {}: {}", tmp_path, std::strerror(errno));
     return ErrorCode::LocalStorageError;
   }
+  auto res = PWrite(fd, data, part_number * part_size, size);
+  if (close(fd) != 0 && res) {
+    res = galois::ResultErrno();
+  }
+  if (!res) {
+    GALOIS_LOG_DEBUG("write: {}: {}", tmp_path, res.error());
+    return ErrorCode::LocalStorageError;
+  }
+  StatAdd("LocalWriteBytes", size);
+  return galois::ResultSuccess();
+}
 
-  ifile.read(reinterpret_cast<char*>(data), size); /* NOLINT */
-  if (!ifile) {
-    GALOIS_LOG_DEBUG("failed to read");
+galois::Result<void>
+tsuba::LocalStorage::ReadFile(
+    std::string uri, uint64_t start, uint64_t size, uint8_t* data) {
+  CleanUri(&uri);
+  auto file_res = OpenForRead(uri);
+  if (!file_res) {
+    GALOIS_LOG_DEBUG("failed to open {}: {}", uri, file_res.error());
     return ErrorCode::LocalStorageError;
   }
+  std::shared_ptr<OpenFile> file = std::move(file_res.value());
+
+  if (size == 0) {
+    return galois::ResultSuccess();
+  }
+
+  // Chunk boundaries are aligned in the file rather than relative to start so
+  // that concurrent requests for neighboring ranges issue aligned reads
+  uint64_t first_chunk = start / kReadChunkSize;
+  uint64_t last_chunk = (start + size - 1) / kReadChunkSize;
+  uint64_t num_chunks = last_chunk - first_chunk + 1;
+
+  std::atomic<uint64_t> next_chunk{first_chunk};
+  std::atomic<uint64_t> bytes_read{0};
+  auto read_chunks = [&]() -> galois::Result<void> {
+    for (uint64_t chunk = next_chunk++; chunk <= last_chunk;
+         chunk = next_chunk++) {
+      uint64_t chunk_start = std::max(start, chunk * kReadChunkSize);
+      uint64_t chunk_end = std::min(start + size, (chunk + 1) * kReadChunkSize);
+      auto res = PRead(
+          file->fd(), data + (chunk_start - start), chunk_start,
+          chunk_end - chunk_start);
+      if (!res) {
+        GALOIS_LOG_DEBUG("failed to read {}: {}", uri, res.error());
+        return ErrorCode::LocalStorageError;
+      }
+      bytes_read += res.value();
+    }
+    return galois::ResultSuccess();
+  };
+
+  StartRead();
+
+  // The calling thread reads too, so at most num_chunks - 1 helpers are
+  // useful; fewer are started when other requests hold the shared budget
+  uint64_t num_helpers = AcquireHelpers(num_chunks - 1);
+  std::vector<std::future<galois::Result<void>>> helpers;
+  for (uint64_t i = 0; i < num_helpers; ++i) {
+    helpers.emplace_back(std::async(std::launch::async, read_chunks));
+  }
+  galois::Result<void> res = read_chunks();
+  for (auto& helper : helpers) {
+    if (auto helper_res = helper.get(); !helper_res && res) {
+      res = helper_res.error();
+    }
+  }
+  ReleaseHelpers(num_helpers);
+
+  FinishRead(bytes_read);
+
+  if (!res) {
+    return res.error();
+  }
 
   // if the difference in what was read from what we wanted is less  than a
   // block it's because the file size isn't well aligned so don't complain.
-  if (size - ifile.gcount() > kBlockSize) {
+  if (size - bytes_read > kBlockSize) {
+    GALOIS_LOG_DEBUG("short read of {}", uri);
     return ErrorCode::LocalStorageError;
   }
   return galois::ResultSuccess();
 }
 
+galois::Result<std::shared_ptr<tsuba::LocalStorage::OpenFile>>
+tsuba::LocalStorage::OpenForRead(const std::string& filename) {
+  struct stat path_stat;
+  if (stat(filename.c_str(), &path_stat) != 0) {
+    auto err = galois::ResultErrno();
+    // e.g., removed by someone else; don't keep the old file open
+    ForgetOpenFile(filename);
+    return err;
+  }
+
+  std::lock_guard<std::mutex> lock(open_files_mutex_);
+  if (auto it = open_files_.find(filename); it != open_files_.end()) {
+    if (it->second->Matches(path_stat)) {
+      return it->second;
+    }
+    // replaced or modified by someone else since it was opened
+    open_files_.erase(it);
+  }
+
+  int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return galois::ResultErrno();
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    auto err = galois::ResultErrno();
+    close(fd);
+    return err;
+  }
+  auto file = std::make_shared<OpenFile>(fd, file_stat);
+
+  // Readers hold their own reference, so dropping an arbitrary entry is
+  // always safe
+  if (open_files_.size() >= kMaxOpenFiles) {
+    open_files_.erase(open_files_.begin());
+  }
+  open_files_.emplace(filename, file);
+  return file;
+}
+
+void
+tsuba::LocalStorage::ForgetOpenFile(const std::string& filename) {
+  std::lock_guard<std::mutex> lock(open_files_mutex_);
+  open_files_.erase(filename);
+}
+
+uint64_t
+tsuba::LocalStorage::AcquireHelpers(uint64_t wanted) {
+  std::lock_guard<std::mutex> lock(helpers_mutex_);
+  uint64_t taken = std::min(wanted, idle_helpers_);
+  idle_helpers_ -= taken;
+  return taken;
+}
+
+void
+tsuba::LocalStorage::ReleaseHelpers(uint64_t count) {
+  std::lock_guard<std::mutex> lock(helpers_mutex_);
+  idle_helpers_ += count;
+}
+
+void
+tsuba::LocalStorage::StartRead() {
+  std::lock_guard<std::mutex> lock(read_stats_mutex_);
+  if (reads_in_flight_++ == 0) {
+    read_busy_start_ = std::chrono::steady_clock::now();
+  }
+}
+
+void
+tsuba::LocalStorage::FinishRead(uint64_t bytes) {
+  std::lock_guard<std::mutex> lock(read_stats_mutex_);
+  bytes_read_ += bytes;
+  StatAdd("LocalReadBytes", bytes);
+  StatAdd("LocalReads", 1);
+
+  assert(reads_in_flight_ > 0);
+  if (--reads_in_flight_ > 0) {
+    return;
+  }
+  auto busy = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - read_busy_start_);
+  read_busy_us_ += busy.count();
+  StatAdd("LocalReadBusyMicroseconds", busy.count());
+  if (read_busy_us_ > 0) {
+    // bytes per microsecond is 1e-3 GB/s
+    StatSet(
+        "LocalReadGBPerSec",
+        static_cast<double>(bytes_read_) / read_busy_us_ / 1e3);
+  }
+}
+
+galois::Result<void>
+tsuba::LocalStorage::Init() {
+  if (int depth = 0; galois::GetEnv("TSUBA_LOCAL_READ_DEPTH", &depth)) {
+    if (depth < 1) {
+      GALOIS_LOG_WARN("ignoring TSUBA_LOCAL_READ_DEPTH={}", depth);
+    } else {
+      read_depth_ = depth;
+    }
+  }
+  std::lock_guard<std::mutex> lock(helpers_mutex_);
+  idle_helpers_ = read_depth_ - 1;
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+tsuba::LocalStorage::Fini() {
+  std::lock_guard<std::mutex> lock(open_files_mutex_);
+  open_files_.clear();
+  return galois::ResultSuccess();
+}
+
 galois::Result<void>
 tsuba::LocalStorage::Stat(const std::string& uri, StatBuf* s_buf) {
   std::string filename = uri;
@@ -86,66 +354,250 @@ tsuba::LocalStorage::Stat(const std::string& uri, StatBuf* s_buf) {
     return galois::ResultErrno();
   }
   s_buf->size = local_s_buf.st_size;
+  s_buf->mtime_ns = local_s_buf.st_mtim.tv_sec * UINT64_C(1000000000) +
+                    local_s_buf.st_mtim.tv_nsec;
   return galois::ResultSuccess();
 }
 
-// Current implementation is not async
-std::future<galois::Result<void>>
-tsuba::LocalStorage::ListAsync(
-    const std::string& uri, std::vector<std::string>* list,
+galois::Result<uint8_t*>
+tsuba::LocalStorage::Mmap(const std::string& uri, uint64_t size) {
+  std::string filename = uri;
+  CleanUri(&filename);
+
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return galois::ResultErrno();
+  }
+  // MAP_PRIVATE rather than MAP_SHARED: callers (e.g., topology sorting)
+  // update mapped data in place and those writes must not reach the file.
+  // Untouched pages are still shared with the page cache.
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (ptr == MAP_FAILED) {
+    auto err = galois::ResultErrno();
+    close(fd);
+    GALOIS_LOG_DEBUG("mmap: {}: {}", filename, err.message());
+    return err;
+  }
+  // the mapping holds its own reference to the file
+  if (close(fd) != 0) {
+    GALOIS_LOG_DEBUG("close: {}: {}", filename, std::strerror(errno));
+  }
+  return static_cast<uint8_t*>(ptr);
+}
+
+galois::Result<std::string>
+tsuba::LocalStorage::MultipartBegin(
+    const std::string& uri, uint64_t part_size) {
+  if (part_size == 0) {
+    return ErrorCode::InvalidArgument;
+  }
+  std::string filename = uri;
+  CleanUri(&filename);
+  fs::path dir = fs::path{filename}.parent_path();
+  if (boost::system::error_code err; !fs::create_directories(dir, err)) {
+    if (err) {
+      return err;
+    }
+  }
+
+  std::string upload_id = galois::RandomAlphanumericString(kUploadIdLen);
+  std::string tmp_path = UploadPath(filename, upload_id);
+  int fd =
+      open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    GALOIS_LOG_DEBUG("open: {}: {}", tmp_path, std::strerror(errno));
+    return ErrorCode::LocalStorageError;
+  }
+  if (close(fd) != 0) {
+    GALOIS_LOG_DEBUG("close: {}: {}", tmp_path, std::strerror(errno));
+  }
+
+  std::lock_guard<std::mutex> lock(uploads_mutex_);
+  uploads_.emplace(upload_id, part_size);
+  return upload_id;
+}
+
+galois::Result<void>
+tsuba::LocalStorage::MultipartComplete(
+    const std::string& uri, const std::string& upload_id,
+    [[maybe_unused]] uint64_t num_parts) {
+  {
+    std::lock_guard<std::mutex> lock(uploads_mutex_);
+    if (uploads_.erase(upload_id) == 0) {
+      return ErrorCode::InvalidArgument;
+    }
+  }
+  std::string filename = uri;
+  CleanUri(&filename);
+  std::string tmp_path = UploadPath(filename, upload_id);
+  if (rename(tmp_path.c_str(), filename.c_str()) != 0) {
+    GALOIS_LOG_DEBUG(
+        "rename: {} to {}: {}", tmp_path, filename, std::strerror(errno));
+    unlink(tmp_path.c_str());
+    return ErrorCode::LocalStorageError;
+  }
+  // Only after the rename: a read between forgetting and renaming would
+  // cache a descriptor for the replaced file
+  ForgetOpenFile(filename);
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+tsuba::LocalStorage::MultipartAbort(
+    const std::string& uri, const std::string& upload_id) {
+  {
+    std::lock_guard<std::mutex> lock(uploads_mutex_);
+    if (uploads_.erase(upload_id) == 0) {
+      return ErrorCode::InvalidArgument;
+    }
+  }
+  std::string filename = uri;
+  CleanUri(&filename);
+  unlink(UploadPath(filename, upload_id).c_str());
+  return galois::ResultSuccess();
+}
+
+std::shared_ptr<const tsuba::LocalStorage::DirListing>
+tsuba::LocalStorage::FindListing(
+    const std::string& dirname, const struct timespec& mtime) {
+  std::lock_guard<std::mutex> lock(listings_mutex_);
+  auto it = listings_.find(dirname);
+  if (it == listings_.end()) {
+    return nullptr;
+  }
+  const struct timespec& cached = it->second->mtime;
+  if (cached.tv_sec != mtime.tv_sec || cached.tv_nsec != mtime.tv_nsec) {
+    listings_.erase(it);
+    return nullptr;
+  }
+  return it->second;
+}
+
+void
+tsuba::LocalStorage::CacheListing(
+    const std::string& dirname, std::shared_ptr<const DirListing> listing) {
+  std::lock_guard<std::mutex> lock(listings_mutex_);
+  if (listings_.size() >= kMaxCachedListings &&
+      listings_.find(dirname) == listings_.end()) {
+    listings_.erase(listings_.begin());
+  }
+  listings_[dirname] = std::move(listing);
+}
+
+galois::Result<void>
+tsuba::LocalStorage::ListDir(
+    const std::string& dirname, std::vector<std::string>* list,
     std::vector<uint64_t>* size) {
-  // Implement with synchronous calls
-  DIR* dirp;
-  struct dirent* dp;
-  std::string dirname = uri;
-  CleanUri(&dirname);
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
 
-  if ((dirp = opendir(dirname.c_str())) == nullptr) {
+  DIR* dirp = opendir(dirname.c_str());
+  if (dirp == nullptr) {
     if (errno == ENOENT) {
       // other storage backends are flat and so return an empty list here
-      return std::async(
-          []() -> galois::Result<void> { return galois::ResultSuccess(); });
+      return galois::ResultSuccess();
     }
     GALOIS_LOG_DEBUG(
         "\n  Open dir failed: {}: {}", dirname,
         galois::ResultErrno().message());
-    return std::async(
-        []() -> galois::Result<void> { return ErrorCode::LocalStorageError; });
+    return ErrorCode::LocalStorageError;
   }
-
   int dfd = dirfd(dirp);
-  struct stat stat_buf;
-  do {
-    errno = 0;
-    if ((dp = readdir(dirp)) != nullptr) {
-      // I am filtering "." and ".." from local listing because I can't see how
-      // to filter in clients in a reasonable way.
-      if (strcmp(".", dp->d_name) && strcmp("..", dp->d_name)) {
-        list->emplace_back(dp->d_name);
-        if (size) {
-          if (fstatat(dfd, dp->d_name, &stat_buf, 0) == 0) {
-            size->emplace_back(stat_buf.st_size);
+
+  struct stat dir_stat;
+  bool have_mtime = fstat(dfd, &dir_stat) == 0;
+  std::shared_ptr<const DirListing> listing;
+  if (have_mtime) {
+    listing = FindListing(dirname, dir_stat.st_mtim);
+  }
+
+  if (listing) {
+    StatAdd("LocalListCacheHits", 1);
+  } else {
+    auto new_listing = std::make_shared<DirListing>();
+    struct dirent* dp;
+    do {
+      errno = 0;
+      if ((dp = readdir(dirp)) != nullptr) {
+        // I am filtering "." and ".." from local listing because I can't see
+        // how to filter in clients in a reasonable way.
+        if (strcmp(".", dp->d_name) && strcmp("..", dp->d_name)) {
+          new_listing->names.emplace_back(dp->d_name);
+        }
+      }
+    } while (dp != nullptr);
+
+    if (errno != 0) {
+      GALOIS_LOG_ERROR(
+          "\n  readdir failed: {}: {}", dirname,
+          galois::ResultErrno().message());
+      (void)closedir(dirp);
+      return ErrorCode::LocalStorageError;
+    }
+
+    if (have_mtime &&
+        dir_stat.st_mtim.tv_sec + kMinListingAgeSeconds <= now.tv_sec) {
+      new_listing->mtime = dir_stat.st_mtim;
+      CacheListing(dirname, new_listing);
+    }
+    listing = std::move(new_listing);
+  }
+
+  const std::vector<std::string>& names = listing->names;
+  if (size) {
+    // Sizes are not cached because files can be rewritten in place without
+    // changing the directory
+    std::vector<uint64_t> sizes(names.size());
+    std::atomic<size_t> next_page{0};
+    auto stat_pages = [&]() {
+      for (size_t page = next_page++; page * kListPageSize < names.size();
+           page = next_page++) {
+        size_t end = std::min(names.size(), (page + 1) * kListPageSize);
+        for (size_t i = page * kListPageSize; i < end; ++i) {
+          struct stat stat_buf;
+          if (fstatat(dfd, names[i].c_str(), &stat_buf, 0) == 0) {
+            sizes[i] = stat_buf.st_size;
           } else {
-            size->emplace_back(0UL);
             GALOIS_LOG_DEBUG(
                 "dir file stat failed dir: {} file: {} : {}", dirname,
-                dp->d_name, galois::ResultErrno().message());
+                names[i], galois::ResultErrno().message());
           }
         }
       }
+    };
+
+    // The listing thread stats too, so at most num_pages - 1 helpers are
+    // useful
+    size_t num_pages = (names.size() + kListPageSize - 1) / kListPageSize;
+    uint64_t num_helpers =
+        num_pages > 1 ? AcquireHelpers(num_pages - 1) : 0;
+    std::vector<std::future<void>> helpers;
+    for (uint64_t i = 0; i < num_helpers; ++i) {
+      helpers.emplace_back(std::async(std::launch::async, stat_pages));
     }
-  } while (dp != nullptr);
+    stat_pages();
+    for (auto& helper : helpers) {
+      helper.get();
+    }
+    ReleaseHelpers(num_helpers);
 
-  if (errno != 0) {
-    GALOIS_LOG_ERROR(
-        "\n  readdir failed: {}: {}", dirname, galois::ResultErrno().message());
-    return std::async(
-        []() -> galois::Result<void> { return ErrorCode::LocalStorageError; });
+    size->insert(size->end(), sizes.begin(), sizes.end());
   }
   (void)closedir(dirp);
 
-  return std::async(
-      []() -> galois::Result<void> { return galois::ResultSuccess(); });
+  list->insert(list->end(), names.begin(), names.end());
+  return galois::ResultSuccess();
+}
+
+std::future<galois::Result<void>>
+tsuba::LocalStorage::ListAsync(
+    const std::string& uri, std::vector<std::string>* list,
+    std::vector<uint64_t>* size) {
+  std::string dirname = uri;
+  CleanUri(&dirname);
+  return std::async(std::launch::async, [=]() -> galois::Result<void> {
+    return ListDir(dirname, list, size);
+  });
 }
 
 galois::Result<void>
@@ -160,6 +612,7 @@ tsuba::LocalStorage::Delete(
   } else {
     for (const auto& file : files) {
       auto path = galois::Uri::JoinPath(dir, file);
+      ForgetOpenFile(path);
       unlink(path.c_str());
     }
   }
@@ -2,31 +2,143 @@
 #define GALOIS_LIBTSUBA_LOCALSTORAGE_H_
 
 #include <sys/mman.h>
+#include <sys/stat.h>
 
+#include <chrono>
 #include <cstdint>
 #include <future>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "galois/Result.h"
 #include "tsuba/FileStorage.h"
 
 namespace tsuba {
 
-/// Store byte arrays to the local file system; Provided as a convenience for
-/// testing only (un-optimized)
+/// Store byte arrays to the local file system
+///
+/// Reads use pread on file descriptors that are cached across requests. A
+/// cached descriptor is only used while a stat of its path still finds the
+/// same, unmodified file, since files may be replaced or removed by other
+/// processes or through another LocalStorage.
+///
+/// Large reads are split into aligned chunks that are read concurrently so
+/// that devices that need a deep queue (e.g., NVMe arrays) can reach full
+/// bandwidth. Chunks are read by the requesting thread and by helper threads
+/// drawn from a budget shared by all requests, so the total number of
+/// concurrent chunk reads stays bounded however many requests are in flight.
+/// The budget can be set with the environment variable TSUBA_LOCAL_READ_DEPTH.
+///
+/// Multipart uploads write parts at their offsets in a temporary file next to
+/// the destination, which is renamed into place when the upload completes.
+///
+/// Listings run on a background thread and stat files concurrently, a page of
+/// entries at a time. The names in a directory are cached and reused while the
+/// modification time of the directory, which changes whenever an entry is
+/// added, removed or renamed, stays the same.
 class LocalStorage : public FileStorage {
+  /// An open file descriptor that is closed when the last reader is done
+  /// with it
+  class OpenFile {
+    int fd_;
+    // the file when it was opened
+    struct stat stat_;
+
+  public:
+    OpenFile(int fd, const struct stat& stat) : fd_(fd), stat_(stat) {}
+    OpenFile(const OpenFile& no_copy) = delete;
+    OpenFile& operator=(const OpenFile& no_copy) = delete;
+    ~OpenFile();
+
+    int fd() const { return fd_; }
+
+    /// True if stat describes the file as it was opened, i.e., the path was
+    /// not replaced and the file not modified since
+    bool Matches(const struct stat& stat) const;
+  };
+
+  /// Names in a listed directory and the modification time of the directory
+  /// when they were listed
+  struct DirListing {
+    struct timespec mtime;
+    std::vector<std::string> names;
+  };
+
+  static constexpr uint64_t kReadChunkSize = UINT64_C(8) << 20; /* 8M */
+  static constexpr size_t kMaxOpenFiles = 256;
+  /// Number of directory entries stat'ed by a listing worker at a time
+  static constexpr size_t kListPageSize = 256;
+  static constexpr size_t kMaxCachedListings = 64;
+  /// Listings of directories modified more recently than this are not
+  /// cached, since a later change in the same clock tick would not change
+  /// the modification time
+  static constexpr time_t kMinListingAgeSeconds = 2;
+
+  int read_depth_{16};
+
+  // Helper threads that may still be started, shared by all reads and
+  // listings so that concurrent requests do not each start read_depth_ - 1
+  std::mutex helpers_mutex_;
+  uint64_t idle_helpers_{15};
+
+  // part size of each upload in progress by upload id
+  std::mutex uploads_mutex_;
+  std::unordered_map<std::string, uint64_t> uploads_;
+
+  std::mutex open_files_mutex_;
+  std::unordered_map<std::string, std::shared_ptr<OpenFile>> open_files_;
+
+  std::mutex listings_mutex_;
+  std::unordered_map<std::string, std::shared_ptr<const DirListing>>
+      listings_;
+
+  // Time is only counted while at least one read is outstanding, so that
+  // bytes_read_ / read_busy_us_ is the achieved bandwidth
+  std::mutex read_stats_mutex_;
+  uint64_t reads_in_flight_{0};
+  std::chrono::steady_clock::time_point read_busy_start_;
+  uint64_t read_busy_us_{0};
+  uint64_t bytes_read_{0};
+
   void CleanUri(std::string* uri);
   galois::Result<void> WriteFile(
       std::string, const uint8_t* data, uint64_t size);
   galois::Result<void> ReadFile(
       std::string uri, uint64_t start, uint64_t size, uint8_t* data);
 
+  galois::Result<void> WritePart(
+      std::string uri, const std::string& upload_id, uint64_t part_number,
+      const uint8_t* data, uint64_t size);
+
+  galois::Result<std::shared_ptr<OpenFile>> OpenForRead(
+      const std::string& filename);
+  void ForgetOpenFile(const std::string& filename);
+
+  galois::Result<void> ListDir(
+      const std::string& dirname, std::vector<std::string>* list,
+      std::vector<uint64_t>* size);
+  std::shared_ptr<const DirListing> FindListing(
+      const std::string& dirname, const struct timespec& mtime);
+  void CacheListing(
+      const std::string& dirname, std::shared_ptr<const DirListing> listing);
+
+  /// Take up to wanted helpers from the shared budget; returns the number
+  /// taken, which may be zero
+  uint64_t AcquireHelpers(uint64_t wanted);
+  void ReleaseHelpers(uint64_t count);
+
+  void StartRead();
+  void FinishRead(uint64_t bytes);
+
 public:
   LocalStorage() : FileStorage("file://") {}
 
-  galois::Result<void> Init() override { return galois::ResultSuccess(); }
-  galois::Result<void> Fini() override { return galois::ResultSuccess(); }
+  galois::Result<void> Init() override;
+  galois::Result<void> Fini() override;
   galois::Result<void> Stat(const std::string& uri, StatBuf* size) override;
 
   uint32_t Priority() const override { return 1; }
@@ -56,13 +168,9 @@ public:
   std::future<galois::Result<void>> GetAsync(
       const std::string& uri, uint64_t start, uint64_t size,
       uint8_t* result_buf) override {
-    // I suppose there is no need for AsyncGet to local storage either
-    if (auto read_res = ReadFile(uri, start, size, result_buf); !read_res) {
-      return std::async(
-          [=]() -> galois::Result<void> { return read_res.error(); });
-    }
-    return std::async(
-        []() -> galois::Result<void> { return galois::ResultSuccess(); });
+    return std::async(std::launch::async, [=]() -> galois::Result<void> {
+      return ReadFile(uri, start, size, result_buf);
+    });
   }
   std::future<galois::Result<void>> ListAsync(
       const std::string& uri, std::vector<std::string>* list,
@@ -71,6 +179,23 @@ public:
   galois::Result<void> Delete(
       const std::string& directory,
       const std::unordered_set<std::string>& files) override;
+
+  galois::Result<uint8_t*> Mmap(const std::string& uri, uint64_t size) override;
+
+  galois::Result<std::string> MultipartBegin(
+      const std::string& uri, uint64_t part_size) override;
+  std::future<galois::Result<void>> MultipartPutAsync(
+      const std::string& uri, const std::string& upload_id,
+      uint64_t part_number, const uint8_t* data, uint64_t size) override {
+    return std::async(std::launch::async, [=]() -> galois::Result<void> {
+      return WritePart(uri, upload_id, part_number, data, size);
+    });
+  }
+  galois::Result<void> MultipartComplete(
+      const std::string& uri, const std::string& upload_id,
+      uint64_t num_parts) override;
+  galois::Result<void> MultipartAbort(
+      const std::string& uri, const std::string& upload_id) override;
 };
 
 }  // namespace tsuba
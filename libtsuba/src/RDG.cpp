@@ -1,19 +1,23 @@
 #include "tsuba/RDG.h"
 
+#include <algorithm>
 #include <cassert>
 #include <exception>
 #include <fstream>
 #include <memory>
+#include <optional>
 #include <regex>
 #include <unordered_set>
 
 #include <arrow/filesystem/api.h>
+#include <arrow/ipc/writer.h>
 #include <parquet/arrow/reader.h>
 #include <parquet/arrow/schema.h>
 #include <parquet/arrow/writer.h>
 #include <parquet/file_reader.h>
 #include <parquet/platform.h>
 #include <parquet/properties.h>
+#include <parquet/types.h>
 
 #include "AddTables.h"
 #include "GlobalState.h"
@@ -39,14 +43,21 @@ const char* kMasterNodesPropName = "master_nodes";
 const char* kLocalToTGlobalPropName = "local_to_global_vector";
 
 std::shared_ptr<parquet::WriterProperties>
-StandardWriterProperties() {
+StandardWriterProperties(const tsuba::PropWriteOptions& options) {
   // int64 timestamps with nanosecond resolution requires Parquet version 2.0.
   // In Arrow to Parquet version 1.0, nanosecond timestamps will get truncated
   // to milliseconds.
-  return parquet::WriterProperties::Builder()
-      .version(parquet::ParquetVersion::PARQUET_2_0)
+  parquet::WriterProperties::Builder builder;
+  builder.version(parquet::ParquetVersion::PARQUET_2_0)
       ->data_page_version(parquet::ParquetDataPageVersion::V2)
-      ->build();
+      ->compression(options.codec)
+      ->compression_level(options.compression_level);
+  if (options.dictionary) {
+    builder.enable_dictionary();
+  } else {
+    builder.disable_dictionary();
+  }
+  return builder.build();
 }
 
 std::shared_ptr<parquet::ArrowWriterProperties>
@@ -54,45 +65,134 @@ StandardArrowProperties() {
   return parquet::ArrowWriterProperties::Builder().build();
 }
 
-/// Store the arrow array as a table in a unique file, return
-/// the final name of that file
-galois::Result<std::string>
+galois::Result<tsuba::RowGroupIndex>
+WriteParquet(
+    const std::shared_ptr<arrow::Table>& column,
+    const std::shared_ptr<tsuba::FileFrame>& ff,
+    const tsuba::PropWriteOptions& options) {
+  std::unique_ptr<parquet::arrow::FileWriter> writer;
+  auto open_result = parquet::arrow::FileWriter::Open(
+      *column->schema(), arrow::default_memory_pool(), ff,
+      StandardWriterProperties(options), StandardArrowProperties(), &writer);
+  if (!open_result.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", open_result);
+    return tsuba::ErrorCode::ArrowError;
+  }
+
+  if (auto status = writer->WriteTable(*column, options.row_group_size);
+      !status.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", status);
+    return tsuba::ErrorCode::ArrowError;
+  }
+  if (auto status = writer->Close(); !status.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", status);
+    return tsuba::ErrorCode::ArrowError;
+  }
+
+  return tsuba::MakeRowGroupIndex(*writer->metadata());
+}
+
+galois::Result<void>
+WriteArrowIPC(
+    const std::shared_ptr<arrow::Table>& column,
+    const std::shared_ptr<tsuba::FileFrame>& ff) {
+  // Readers use the column in place, which is simplest if it is a single
+  // record batch. Chunks of a dictionary column can only be combined once
+  // they share a dictionary.
+  std::shared_ptr<arrow::Table> unified = column;
+  if (column->num_columns() == 1 &&
+      column->column(0)->type()->id() == arrow::Type::DICTIONARY) {
+    auto unify_result = arrow::DictionaryUnifier::UnifyTable(*column);
+    if (!unify_result.ok()) {
+      GALOIS_LOG_DEBUG("arrow error: {}", unify_result.status());
+      return tsuba::ErrorCode::ArrowError;
+    }
+    unified = std::move(unify_result.ValueOrDie());
+  }
+  auto combine_result = unified->CombineChunks(arrow::default_memory_pool());
+  if (!combine_result.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", combine_result.status());
+    return tsuba::ErrorCode::ArrowError;
+  }
+  std::shared_ptr<arrow::Table> combined =
+      std::move(combine_result.ValueOrDie());
+
+  auto writer_result = arrow::ipc::MakeFileWriter(ff, combined->schema());
+  if (!writer_result.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", writer_result.status());
+    return tsuba::ErrorCode::ArrowError;
+  }
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> writer =
+      std::move(writer_result.ValueOrDie());
+
+  if (auto status = writer->WriteTable(*combined); !status.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", status);
+    return tsuba::ErrorCode::ArrowError;
+  }
+  if (auto status = writer->Close(); !status.ok()) {
+    GALOIS_LOG_DEBUG("arrow error: {}", status);
+    return tsuba::ErrorCode::ArrowError;
+  }
+  return galois::ResultSuccess();
+}
+
+/// Store the arrow array as a table in a unique file, return where and how
+/// it was stored
+galois::Result<tsuba::PropStorageInfo>
 DoStoreArrowArrayAtName(
     const std::shared_ptr<arrow::ChunkedArray>& array, const galois::Uri& dir,
-    const std::string& name, tsuba::WriteGroup* desc) {
+    const std::string& name, tsuba::PropStorageFormat format,
+    const tsuba::PropWriteOptions& options, tsuba::WriteGroup* desc) {
   galois::Uri next_path = dir.RandFile(name);
 
   // Metadata paths should relative to dir
   std::shared_ptr<arrow::Table> column = arrow::Table::Make(
       arrow::schema({arrow::field(name, array->type())}), {array});
 
+  // Stream the file so that it is stored while it is being written rather
+  // than buffered whole
   auto ff = std::make_shared<tsuba::FileFrame>();
-  if (auto res = ff->Init(); !res) {
+  if (auto res = ff->InitStreaming(next_path.string()); !res) {
     return res.error();
   }
 
-  auto write_result = parquet::arrow::WriteTable(
-      *column, arrow::default_memory_pool(), ff,
-      std::numeric_limits<int64_t>::max(), StandardWriterProperties(),
-      StandardArrowProperties());
-
-  if (!write_result.ok()) {
-    GALOIS_LOG_DEBUG("arrow error: {}", write_result);
-    return tsuba::ErrorCode::ArrowError;
+  tsuba::RowGroupIndex row_groups;
+  switch (format) {
+  case tsuba::PropStorageFormat::Parquet: {
+    auto write_result = WriteParquet(column, ff, options);
+    if (!write_result) {
+      return write_result.error();
+    }
+    row_groups = std::move(write_result.value());
+    break;
+  }
+  case tsuba::PropStorageFormat::ArrowIPC: {
+    if (auto write_result = WriteArrowIPC(column, ff); !write_result) {
+      return write_result.error();
+    }
+    break;
+  }
   }
 
-  ff->Bind(next_path.string());
   TSUBA_PTP(tsuba::internal::FaultSensitivity::Normal);
   desc->StartStore(std::move(ff));
-  return next_path.BaseName();
+  return tsuba::PropStorageInfo{
+      .name = name,
+      .path = next_path.BaseName(),
+      .persist = true,
+      .format = format,
+      .row_groups = std::move(row_groups),
+      .dictionary = array->type()->id() == arrow::Type::DICTIONARY,
+  };
 }
 
-galois::Result<std::string>
+galois::Result<tsuba::PropStorageInfo>
 StoreArrowArrayAtName(
     const std::shared_ptr<arrow::ChunkedArray>& array, const galois::Uri& dir,
-    const std::string& name, tsuba::WriteGroup* desc) {
+    const std::string& name, tsuba::PropStorageFormat format,
+    const tsuba::PropWriteOptions& options, tsuba::WriteGroup* desc) {
   try {
-    return DoStoreArrowArrayAtName(array, dir, name, desc);
+    return DoStoreArrowArrayAtName(array, dir, name, format, options, desc);
   } catch (const std::exception& exp) {
     GALOIS_LOG_DEBUG("arrow exception: {}", exp.what());
     return tsuba::ErrorCode::ArrowError;
@@ -113,36 +213,29 @@ galois::Result<std::vector<tsuba::PropStorageInfo>>
 WriteTable(
     const arrow::Table& table,
     const std::vector<tsuba::PropStorageInfo>& properties,
-    const galois::Uri& dir, tsuba::WriteGroup* desc) {
+    const galois::Uri& dir, const tsuba::PropWriteOptions& options,
+    tsuba::WriteGroup* desc) {
   const auto& schema = table.schema();
 
-  std::vector<std::string> next_paths;
-  for (size_t i = 0, n = properties.size(); i < n; ++i) {
-    if (!properties[i].persist || !properties[i].path.empty()) {
+  std::vector<tsuba::PropStorageInfo> next_properties = properties;
+  for (size_t i = 0, n = next_properties.size(); i < n; ++i) {
+    tsuba::PropStorageInfo& prop = next_properties[i];
+    if (!prop.persist || !prop.path.empty()) {
       continue;
     }
-    auto name = properties[i].name.empty() ? schema->field(i)->name()
-                                           : properties[i].name;
-    auto name_res = StoreArrowArrayAtName(table.column(i), dir, name, desc);
-    if (!name_res) {
-      return name_res.error();
+    auto name = prop.name.empty() ? schema->field(i)->name() : prop.name;
+    auto store_res = StoreArrowArrayAtName(
+        table.column(i), dir, name, prop.format,
+        prop.write_options ? *prop.write_options : options, desc);
+    if (!store_res) {
+      return store_res.error();
     }
-    next_paths.emplace_back(name_res.value());
+    prop.path = std::move(store_res.value().path);
+    prop.row_groups = std::move(store_res.value().row_groups);
+    prop.dictionary = store_res.value().dictionary;
   }
   TSUBA_PTP(tsuba::internal::FaultSensitivity::Normal);
 
-  if (next_paths.empty()) {
-    return properties;
-  }
-
-  std::vector<tsuba::PropStorageInfo> next_properties = properties;
-  auto it = next_paths.begin();
-  for (auto& v : next_properties) {
-    if (v.persist && v.path.empty()) {
-      v.path = *it++;
-    }
-  }
-
   return next_properties;
 }
 
@@ -199,8 +292,99 @@ CommitRDG(
   return ret;
 }
 
+/// Return properties, the storage info of the columns of table, with the
+/// locations of those columns that were stored from stored_table and have
+/// not changed since
+std::vector<tsuba::PropStorageInfo>
+AdoptLocations(
+    const arrow::Table& table,
+    const std::vector<tsuba::PropStorageInfo>& properties,
+    const arrow::Table& stored_table,
+    const std::vector<tsuba::PropStorageInfo>& stored_properties) {
+  std::vector<tsuba::PropStorageInfo> next_properties = properties;
+  for (size_t i = 0, n = next_properties.size(); i < n; ++i) {
+    tsuba::PropStorageInfo& prop = next_properties[i];
+    if (!prop.persist || !prop.path.empty()) {
+      continue;
+    }
+    const std::string& name = table.schema()->field(i)->name();
+    int j = stored_table.schema()->GetFieldIndex(name);
+    if (j < 0) {
+      continue;
+    }
+    const tsuba::PropStorageInfo& stored = stored_properties[j];
+    // A column that was replaced, or whose layout was changed, since it was
+    // stored must be written again
+    if (stored.path.empty() || stored.format != prop.format ||
+        stored.write_options != prop.write_options ||
+        table.column(i) != stored_table.column(j)) {
+      continue;
+    }
+    prop.path = stored.path;
+    prop.row_groups = stored.row_groups;
+    prop.dictionary = stored.dictionary;
+  }
+  return next_properties;
+}
+
+/// Check that table can replace the values of current and forget where the
+/// replaced values are stored
+galois::Result<std::vector<tsuba::PropStorageInfo>>
+UnbindReplacedProperties(
+    const arrow::Table& table, const arrow::Table& current,
+    const std::vector<tsuba::PropStorageInfo>& properties) {
+  if (!table.schema()->Equals(*current.schema())) {
+    GALOIS_LOG_DEBUG(
+        "replacement schema {} does not match {}", table.schema()->ToString(),
+        current.schema()->ToString());
+    return tsuba::ErrorCode::InvalidArgument;
+  }
+  std::vector<tsuba::PropStorageInfo> next_properties = properties;
+  for (tsuba::PropStorageInfo& prop : next_properties) {
+    prop.path = "";
+    prop.row_groups = {};
+  }
+  return next_properties;
+}
+
+/// Check that no column of table has the name of a property that is stored
+/// but not loaded yet; loading it later would add a second property with the
+/// same name
+galois::Result<void>
+CheckNotUnloaded(
+    const std::shared_ptr<arrow::Table>& table,
+    const std::vector<tsuba::PropStorageInfo>& unloaded) {
+  for (const std::string& name : table->ColumnNames()) {
+    if (std::any_of(
+            unloaded.begin(), unloaded.end(),
+            [&name](const tsuba::PropStorageInfo& p) {
+              return p.name == name;
+            })) {
+      GALOIS_LOG_DEBUG("failed: property `{}` is stored but not loaded", name);
+      return tsuba::ErrorCode::Exists;
+    }
+  }
+  return galois::ResultSuccess();
+}
+
 }  // namespace
 
+galois::Result<void>
+tsuba::ValidatePropWriteOptions(const PropWriteOptions& options) {
+  if (options.row_group_size <= 0) {
+    GALOIS_LOG_DEBUG("invalid row group size {}", options.row_group_size);
+    return ErrorCode::InvalidArgument;
+  }
+  if (!arrow::util::Codec::IsAvailable(options.codec) ||
+      !parquet::IsCodecSupported(options.codec)) {
+    GALOIS_LOG_DEBUG(
+        "codec {} is not available",
+        arrow::util::Codec::GetCodecAsString(options.codec));
+    return ErrorCode::NotImplemented;
+  }
+  return galois::ResultSuccess();
+}
+
 galois::Result<void>
 tsuba::RDG::AddPartitionMetadataArray(
     const std::shared_ptr<arrow::Table>& table) {
@@ -243,46 +427,67 @@ tsuba::RDG::WritePartArrays(const galois::Uri& dir, tsuba::WriteGroup* desc) {
 
   for (unsigned i = 0; i < mirror_nodes_.size(); ++i) {
     auto name = MirrorPropName(i);
-    auto mirr_res = StoreArrowArrayAtName(mirror_nodes_[i], dir, name, desc);
+    auto mirr_res = StoreArrowArrayAtName(
+        mirror_nodes_[i], dir, name, PropStorageFormat::Parquet,
+        core_->part_header().prop_write_options(), desc);
     if (!mirr_res) {
       return mirr_res.error();
     }
-    next_properties.emplace_back(tsuba::PropStorageInfo{
-        .name = name,
-        .path = std::move(mirr_res.value()),
-        .persist = true,
-    });
+    next_properties.emplace_back(std::move(mirr_res.value()));
   }
 
   for (unsigned i = 0; i < master_nodes_.size(); ++i) {
     auto name = MasterPropName(i);
-    auto mast_res = StoreArrowArrayAtName(master_nodes_[i], dir, name, desc);
+    auto mast_res = StoreArrowArrayAtName(
+        master_nodes_[i], dir, name, PropStorageFormat::Parquet,
+        core_->part_header().prop_write_options(), desc);
     if (!mast_res) {
       return mast_res.error();
     }
-    next_properties.emplace_back(tsuba::PropStorageInfo{
-        .name = name,
-        .path = std::move(mast_res.value()),
-        .persist = true,
-    });
+    next_properties.emplace_back(std::move(mast_res.value()));
   }
 
   if (local_to_global_vector_ != nullptr) {
     auto l2g_res = StoreArrowArrayAtName(
-        local_to_global_vector_, dir, kLocalToTGlobalPropName, desc);
+        local_to_global_vector_, dir, kLocalToTGlobalPropName,
+        PropStorageFormat::Parquet, core_->part_header().prop_write_options(),
+        desc);
     if (!l2g_res) {
       return l2g_res.error();
     }
-    next_properties.emplace_back(tsuba::PropStorageInfo{
-        .name = kLocalToTGlobalPropName,
-        .path = std::move(l2g_res.value()),
-        .persist = true,
-    });
+    next_properties.emplace_back(std::move(l2g_res.value()));
   }
 
   return next_properties;
 }
 
+galois::Result<void>
+tsuba::RDG::WriteTopologyArrays(
+    const galois::Uri& dir, tsuba::WriteGroup* desc) {
+  // copy because storing an array updates its info
+  std::vector<tsuba::PropStorageInfo> infos =
+      core_->part_header().topology_array_info_list();
+  for (const tsuba::PropStorageInfo& info : infos) {
+    if (!info.path.empty()) {
+      continue;
+    }
+    auto it = topology_arrays_.find(info.name);
+    if (it == topology_arrays_.end()) {
+      GALOIS_LOG_DEBUG(
+          "topology array {} is neither stored nor loaded", info.name);
+      return ErrorCode::InvalidArgument;
+    }
+    auto store_res = StoreArrowArrayAtName(
+        it->second, dir, info.name, PropStorageFormat::ArrowIPC,
+        core_->part_header().prop_write_options(), desc);
+    if (!store_res) {
+      return store_res.error();
+    }
+    core_->part_header().SetTopologyArrayInfo(std::move(store_res.value()));
+  }
+  return galois::ResultSuccess();
+}
+
 galois::Result<void>
 tsuba::RDG::DoStore(
     RDGHandle handle, const std::string& command_line,
@@ -303,7 +508,8 @@ tsuba::RDG::DoStore(
 
   auto node_write_result = WriteTable(
       *core_->node_table(), core_->part_header().node_prop_info_list(),
-      handle.impl_->rdg_meta().dir(), write_group.get());
+      handle.impl_->rdg_meta().dir(),
+      core_->part_header().prop_write_options(), write_group.get());
   if (!node_write_result) {
     GALOIS_LOG_DEBUG("failed to write node properties");
     return node_write_result.error();
@@ -315,7 +521,8 @@ tsuba::RDG::DoStore(
 
   auto edge_write_result = WriteTable(
       *core_->edge_table(), core_->part_header().edge_prop_info_list(),
-      handle.impl_->rdg_meta().dir(), write_group.get());
+      handle.impl_->rdg_meta().dir(),
+      core_->part_header().prop_write_options(), write_group.get());
   if (!edge_write_result) {
     GALOIS_LOG_DEBUG("failed to write edge properties");
     return edge_write_result.error();
@@ -335,6 +542,13 @@ tsuba::RDG::DoStore(
   core_->part_header().set_part_properties(
       std::move(part_write_result.value()));
 
+  if (auto res = WriteTopologyArrays(
+          handle.impl_->rdg_meta().dir(), write_group.get());
+      !res) {
+    GALOIS_LOG_DEBUG("failed to write topology arrays");
+    return res.error();
+  }
+
   if (auto write_result = core_->part_header().Write(handle, write_group.get());
       !write_result) {
     GALOIS_LOG_DEBUG("error: metadata write");
@@ -399,7 +613,7 @@ tsuba::RDG::DoMake(const galois::Uri& metadata_dir) {
 galois::Result<tsuba::RDG>
 tsuba::RDG::Make(
     const RDGMeta& meta, const std::vector<std::string>* node_props,
-    const std::vector<std::string>* edge_props) {
+    const std::vector<std::string>* edge_props, bool defer_others) {
   if (!meta.IsEmptyRDG() && meta.num_hosts() != Comm()->Num) {
     GALOIS_LOG_ERROR(
         "number of hosts for partitioned graph does not current number of "
@@ -428,8 +642,16 @@ tsuba::RDG::Make(
 
   RDG rdg(std::make_unique<RDGCore>(std::move(part_header_res.value())));
 
-  if (auto res = rdg.core_->part_header().PrunePropsTo(node_props, edge_props);
-      !res) {
+  if (defer_others) {
+    assert(node_props != nullptr && edge_props != nullptr);
+    if (auto res = rdg.core_->part_header().DeferPropsExcept(
+            *node_props, *edge_props);
+        !res) {
+      return res.error();
+    }
+  } else if (auto res = rdg.core_->part_header().PrunePropsTo(
+                 node_props, edge_props);
+             !res) {
     return res.error();
   }
 
@@ -464,6 +686,185 @@ tsuba::RDG::Make(
   return RDG::Make(handle.impl_->rdg_meta(), node_props, edge_props);
 }
 
+galois::Result<tsuba::RDG>
+tsuba::RDG::MakeLazy(
+    RDGHandle handle, const std::vector<std::string>& node_props,
+    const std::vector<std::string>& edge_props) {
+  if (!handle.impl_->AllowsRead()) {
+    GALOIS_LOG_DEBUG("failed: handle does not allow full read");
+    return ErrorCode::InvalidArgument;
+  }
+  return RDG::Make(handle.impl_->rdg_meta(), &node_props, &edge_props, true);
+}
+
+galois::Result<void>
+tsuba::RDG::LoadNodeProperty(const std::string& name) {
+  const auto& unloaded = core_->part_header().unloaded_node_prop_info_list();
+  auto it = std::find_if(
+      unloaded.begin(), unloaded.end(),
+      [&name](const PropStorageInfo& p) { return p.name == name; });
+  if (it == unloaded.end()) {
+    return ErrorCode::PropertyNotFound;
+  }
+
+  auto load_result = LoadTable(
+      it->name, rdg_dir_.Join(it->path), it->format, it->dictionary);
+  if (!load_result) {
+    return load_result.error();
+  }
+  if (auto res = core_->AddNodeProperties(load_result.value()); !res) {
+    return res.error();
+  }
+  return core_->part_header().MarkNodePropertyLoaded(name);
+}
+
+galois::Result<void>
+tsuba::RDG::LoadEdgeProperty(const std::string& name) {
+  const auto& unloaded = core_->part_header().unloaded_edge_prop_info_list();
+  auto it = std::find_if(
+      unloaded.begin(), unloaded.end(),
+      [&name](const PropStorageInfo& p) { return p.name == name; });
+  if (it == unloaded.end()) {
+    return ErrorCode::PropertyNotFound;
+  }
+
+  auto load_result = LoadTable(
+      it->name, rdg_dir_.Join(it->path), it->format, it->dictionary);
+  if (!load_result) {
+    return load_result.error();
+  }
+  if (auto res = core_->AddEdgeProperties(load_result.value()); !res) {
+    return res.error();
+  }
+  return core_->part_header().MarkEdgePropertyLoaded(name);
+}
+
+galois::Result<void>
+tsuba::RDG::LoadAllProperties() {
+  // Load concurrently, then move the properties over in their stored order
+  std::vector<PropStorageInfo> node_props =
+      core_->part_header().unloaded_node_prop_info_list();
+  std::vector<PropStorageInfo> edge_props =
+      core_->part_header().unloaded_edge_prop_info_list();
+
+  auto node_result = AddTables(
+      rdg_dir_, node_props,
+      [rdg = this](const std::shared_ptr<arrow::Table>& table) {
+        if (auto res = rdg->core_->AddNodeProperties(table); !res) {
+          return res;
+        }
+        return rdg->core_->part_header().MarkNodePropertyLoaded(
+            table->field(0)->name());
+      });
+  if (!node_result) {
+    return node_result.error();
+  }
+
+  return AddTables(
+      rdg_dir_, edge_props,
+      [rdg = this](const std::shared_ptr<arrow::Table>& table) {
+        if (auto res = rdg->core_->AddEdgeProperties(table); !res) {
+          return res;
+        }
+        return rdg->core_->part_header().MarkEdgePropertyLoaded(
+            table->field(0)->name());
+      });
+}
+
+galois::Result<void>
+tsuba::RDG::SetTopologyArray(
+    const std::string& name,
+    const std::shared_ptr<arrow::ChunkedArray>& array) {
+  if (name.empty() || !array) {
+    return ErrorCode::InvalidArgument;
+  }
+  topology_arrays_[name] = array;
+  core_->part_header().SetTopologyArrayInfo(tsuba::PropStorageInfo{
+      .name = name,
+      .path = "",
+      .persist = true,
+      .format = PropStorageFormat::ArrowIPC,
+  });
+  return galois::ResultSuccess();
+}
+
+galois::Result<std::shared_ptr<arrow::ChunkedArray>>
+tsuba::RDG::LoadTopologyArray(const std::string& name) {
+  if (auto it = topology_arrays_.find(name); it != topology_arrays_.end()) {
+    return it->second;
+  }
+
+  const auto& infos = core_->part_header().topology_array_info_list();
+  auto it = std::find_if(
+      infos.begin(), infos.end(),
+      [&name](const PropStorageInfo& p) { return p.name == name; });
+  if (it == infos.end() || it->path.empty()) {
+    return ErrorCode::PropertyNotFound;
+  }
+
+  auto load_result = LoadTable(it->name, rdg_dir_.Join(it->path), it->format);
+  if (!load_result) {
+    return load_result.error();
+  }
+  std::shared_ptr<arrow::ChunkedArray> array = load_result.value()->column(0);
+  topology_arrays_.emplace(name, array);
+  return array;
+}
+
+bool
+tsuba::RDG::HasTopologyArray(const std::string& name) const {
+  const auto& infos = core_->part_header().topology_array_info_list();
+  return std::any_of(infos.begin(), infos.end(), [&name](const auto& p) {
+    return p.name == name;
+  });
+}
+
+void
+tsuba::RDG::ClearTopologyArrays() {
+  topology_arrays_.clear();
+  core_->part_header().ClearTopologyArrays();
+}
+
+galois::Result<void>
+tsuba::RDG::LoadAllTopologyArrays() {
+  for (const auto& info : core_->part_header().topology_array_info_list()) {
+    if (auto res = LoadTopologyArray(info.name); !res) {
+      return res.error();
+    }
+  }
+  return galois::ResultSuccess();
+}
+
+std::vector<std::string>
+tsuba::RDG::UnloadedNodePropertyNames() const {
+  std::vector<std::string> names;
+  for (const auto& prop :
+       core_->part_header().unloaded_node_prop_info_list()) {
+    names.emplace_back(prop.name);
+  }
+  return names;
+}
+
+std::vector<std::string>
+tsuba::RDG::UnloadedEdgePropertyNames() const {
+  std::vector<std::string> names;
+  for (const auto& prop :
+       core_->part_header().unloaded_edge_prop_info_list()) {
+    names.emplace_back(prop.name);
+  }
+  return names;
+}
+
+galois::Result<void>
+tsuba::RDG::RemoveUnloadedNodeProperty(const std::string& name) {
+  return core_->part_header().RemoveUnloadedNodeProperty(name);
+}
+
+galois::Result<void>
+tsuba::RDG::RemoveUnloadedEdgeProperty(const std::string& name) {
+  return core_->part_header().RemoveUnloadedEdgeProperty(name);
+}
+
 galois::Result<void>
 tsuba::RDG::Store(
     RDGHandle handle, const std::string& command_line,
@@ -481,6 +882,13 @@ tsuba::RDG::Store(
       handle.impl_->rdg_meta().policy_id(), tsuba::Comm()->Num,
       core_->part_header().metadata().policy_id_);
   if (handle.impl_->rdg_meta().dir() != rdg_dir_) {
+    // Properties that were never loaded must be copied to the new location
+    if (auto res = LoadAllProperties(); !res) {
+      return res.error();
+    }
+    if (auto res = LoadAllTopologyArrays(); !res) {
+      return res.error();
+    }
     core_->part_header().UnbindFromStorage();
   }
 
@@ -504,8 +912,111 @@ tsuba::RDG::Store(
   return DoStore(handle, command_line, std::move(desc));
 }
 
+galois::Result<tsuba::RDG>
+tsuba::RDG::Snapshot(RDGHandle handle, bool new_topology) {
+  if (!handle.impl_->AllowsWrite()) {
+    GALOIS_LOG_DEBUG("failed: handle does not allow write");
+    return ErrorCode::InvalidArgument;
+  }
+
+  std::string old_topology;
+  if (!core_->part_header().topology_path().empty()) {
+    old_topology =
+        rdg_dir_.Join(core_->part_header().topology_path()).string();
+  }
+  // Same preparation as Store, done here so that the snapshot does not need
+  // to load anything
+  if (handle.impl_->rdg_meta().dir() != rdg_dir_) {
+    if (auto res = LoadAllProperties(); !res) {
+      return res.error();
+    }
+    if (auto res = LoadAllTopologyArrays(); !res) {
+      return res.error();
+    }
+    core_->part_header().UnbindFromStorage();
+  }
+
+  RDGPartHeader part_header = core_->part_header();
+  RDG snapshot(std::make_unique<RDGCore>(std::move(part_header)));
+  snapshot.core_->set_node_table(
+      std::shared_ptr<arrow::Table>(core_->node_table()));
+  snapshot.core_->set_edge_table(
+      std::shared_ptr<arrow::Table>(core_->edge_table()));
+
+  if (snapshot.core_->part_header().topology_path().empty() && !new_topology) {
+    // The snapshot cannot share this RDG's topology storage, so read its own
+    // copy of the stored topology
+    if (old_topology.empty()) {
+      GALOIS_LOG_DEBUG("failed: no stored topology to snapshot");
+      return ErrorCode::InvalidArgument;
+    }
+    if (auto res =
+            snapshot.core_->topology_file_storage().Bind(old_topology, true);
+        !res) {
+      return res.error();
+    }
+  }
+
+  snapshot.mirror_nodes_ = mirror_nodes_;
+  snapshot.master_nodes_ = master_nodes_;
+  snapshot.local_to_global_vector_ = local_to_global_vector_;
+  snapshot.topology_arrays_ = topology_arrays_;
+  snapshot.rdg_dir_ = handle.impl_->rdg_meta().dir();
+  snapshot.lineage_ = lineage_;
+
+  return RDG(std::move(snapshot));
+}
+
+void
+tsuba::RDG::AdoptStoredLocations(
+    const RDG& snapshot, const std::string& command_line,
+    bool adopt_topology) {
+  const RDGPartHeader& stored_header = snapshot.core_->part_header();
+  // Snapshot already unbound this RDG if the snapshot was stored elsewhere,
+  // so every location adopted below is relative to the snapshot's directory
+  rdg_dir_ = snapshot.rdg_dir_;
+
+  if (adopt_topology && !stored_header.topology_path().empty()) {
+    core_->part_header().set_topology_path(stored_header.topology_path());
+    if (!core_->topology_file_storage().Valid()) {
+      std::string t_path =
+          rdg_dir_.Join(stored_header.topology_path()).string();
+      if (auto res = core_->topology_file_storage().Bind(t_path, true); !res) {
+        // the next Store writes the topology again
+        GALOIS_LOG_DEBUG("binding stored topology {}: {}", t_path, res.error());
+      }
+    }
+  }
+
+  core_->part_header().set_node_prop_info_list(AdoptLocations(
+      *core_->node_table(), core_->part_header().node_prop_info_list(),
+      *snapshot.core_->node_table(), stored_header.node_prop_info_list()));
+  core_->part_header().set_edge_prop_info_list(AdoptLocations(
+      *core_->edge_table(), core_->part_header().edge_prop_info_list(),
+      *snapshot.core_->edge_table(), stored_header.edge_prop_info_list()));
+
+  for (const PropStorageInfo& stored :
+       stored_header.topology_array_info_list()) {
+    auto it = topology_arrays_.find(stored.name);
+    auto stored_it = snapshot.topology_arrays_.find(stored.name);
+    if (stored.path.empty() || it == topology_arrays_.end() ||
+        stored_it == snapshot.topology_arrays_.end() ||
+        it->second != stored_it->second) {
+      continue;
+    }
+    core_->part_header().SetTopologyArrayInfo(PropStorageInfo(stored));
+  }
+
+  lineage_.AddCommandLine(command_line);
+}
+
 galois::Result<void>
 tsuba::RDG::AddNodeProperties(const std::shared_ptr<arrow::Table>& table) {
+  if (auto res = CheckNotUnloaded(
+          table, core_->part_header().unloaded_node_prop_info_list());
+      !res) {
+    return res.error();
+  }
   if (auto res = core_->AddNodeProperties(table); !res) {
     return res.error();
   }
@@ -527,6 +1038,11 @@ tsuba::RDG::AddNodeProperties(const std::shared_ptr<arrow::Table>& table) {
 
 galois::Result<void>
 tsuba::RDG::AddEdgeProperties(const std::shared_ptr<arrow::Table>& table) {
+  if (auto res = CheckNotUnloaded(
+          table, core_->part_header().unloaded_edge_prop_info_list());
+      !res) {
+    return res.error();
+  }
   if (auto res = core_->AddEdgeProperties(table); !res) {
     return res.error();
   }
@@ -556,6 +1072,37 @@ tsuba::RDG::RemoveEdgeProperty(uint32_t i) {
   return core_->RemoveEdgeProperty(i);
 }
 
+galois::Result<void>
+tsuba::RDG::ReplaceProperties(
+    const std::shared_ptr<arrow::Table>& node_table,
+    const std::shared_ptr<arrow::Table>& edge_table, bool unbind_topology) {
+  auto node_props_res = UnbindReplacedProperties(
+      *node_table, *core_->node_table(),
+      core_->part_header().node_prop_info_list());
+  if (!node_props_res) {
+    return node_props_res.error();
+  }
+  auto edge_props_res = UnbindReplacedProperties(
+      *edge_table, *core_->edge_table(),
+      core_->part_header().edge_prop_info_list());
+  if (!edge_props_res) {
+    return edge_props_res.error();
+  }
+  if (unbind_topology) {
+    if (auto res = UnbindTopologyFileStorage(); !res) {
+      return res.error();
+    }
+  }
+
+  core_->set_node_table(std::shared_ptr<arrow::Table>(node_table));
+  core_->part_header().set_node_prop_info_list(
+      std::move(node_props_res.value()));
+  core_->set_edge_table(std::shared_ptr<arrow::Table>(edge_table));
+  core_->part_header().set_edge_prop_info_list(
+      std::move(edge_props_res.value()));
+  return galois::ResultSuccess();
+}
+
 void
 tsuba::RDG::MarkAllPropertiesPersistent() {
   core_->part_header().MarkAllPropertiesPersistent();
@@ -573,6 +1120,50 @@ tsuba::RDG::MarkEdgePropertiesPersistent(
   return core_->part_header().MarkEdgePropertiesPersistent(persist_edge_props);
 }
 
+galois::Result<void>
+tsuba::RDG::SetNodePropertyStorageFormat(
+    const std::string& name, PropStorageFormat format) {
+  return core_->part_header().SetNodePropertyStorageFormat(name, format);
+}
+
+galois::Result<void>
+tsuba::RDG::SetEdgePropertyStorageFormat(
+    const std::string& name, PropStorageFormat format) {
+  return core_->part_header().SetEdgePropertyStorageFormat(name, format);
+}
+
+galois::Result<void>
+tsuba::RDG::SetNodePropertyWriteOptions(
+    const std::string& name, const PropWriteOptions& options) {
+  if (auto res = ValidatePropWriteOptions(options); !res) {
+    return res.error();
+  }
+  return core_->part_header().SetNodePropertyWriteOptions(name, options);
+}
+
+galois::Result<void>
+tsuba::RDG::SetEdgePropertyWriteOptions(
+    const std::string& name, const PropWriteOptions& options) {
+  if (auto res = ValidatePropWriteOptions(options); !res) {
+    return res.error();
+  }
+  return core_->part_header().SetEdgePropertyWriteOptions(name, options);
+}
+
+galois::Result<void>
+tsuba::RDG::SetPropWriteOptions(const PropWriteOptions& options) {
+  if (auto res = ValidatePropWriteOptions(options); !res) {
+    return res.error();
+  }
+  core_->part_header().set_prop_write_options(options);
+  return galois::ResultSuccess();
+}
+
+const tsuba::PropWriteOptions&
+tsuba::RDG::prop_write_options() const {
+  return core_->part_header().prop_write_options();
+}
+
 const tsuba::PartitionMetadata&
 tsuba::RDG::part_metadata() const {
   return core_->part_header().metadata();
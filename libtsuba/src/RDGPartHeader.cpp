@@ -1,5 +1,9 @@
 #include "RDGPartHeader.h"
 
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 #include "Constants.h"
 #include "GlobalState.h"
 #include "RDGHandleImpl.h"
@@ -7,6 +11,8 @@
 #include "tsuba/Errors.h"
 #include "tsuba/FaultTest.h"
 #include "tsuba/FileView.h"
+#include "tsuba/Stats.h"
+#include "tsuba/file.h"
 
 template <typename T>
 using Result = galois::Result<T>;
@@ -28,6 +34,8 @@ const char* kNodePropertyKey = "kg.v1.node_property";
 const char* kEdgePropertyKey = "kg.v1.edge_property";
 const char* kPartPropertyFilesKey = "kg.v1.part_property_files";
 const char* kPartProperyMetaKey = "kg.v1.part_property_meta";
+const char* kTopologyArrayFilesKey = "kg.v1.topology_array_files";
+const char* kPropWriteOptionsKey = "kg.v1.prop_write_options";
 //
 //constexpr std::string_view  mirror_nodes_prop_name = "mirror_nodes";
 //constexpr std::string_view  master_nodes_prop_name = "master_nodes";
@@ -66,6 +74,215 @@ MakeProperties(std::vector<std::string>&& values) {
   return prop_info_list;
 }
 
+const char* kArrowIPCFormatName = "arrow_ipc";
+const char* kParquetFormatName = "parquet";
+
+// keys of the optional fields of a serialized PropStorageInfo
+const char* kPropFormatKey = "format";
+const char* kPropRowGroupsKey = "row_groups";
+const char* kPropWriteOptionsFieldKey = "write_options";
+const char* kPropDictionaryKey = "dictionary";
+
+tsuba::PropStorageFormat
+ParsePropStorageFormat(const std::string& format) {
+  if (format == kArrowIPCFormatName) {
+    return tsuba::PropStorageFormat::ArrowIPC;
+  }
+  if (format != kParquetFormatName) {
+    // nlohmann::json reports errors using exceptions
+    throw std::runtime_error("unknown property storage format " + format);
+  }
+  return tsuba::PropStorageFormat::Parquet;
+}
+
+galois::Result<void>
+SetStorageFormat(
+    std::vector<tsuba::PropStorageInfo>* prop_info_list,
+    const std::string& name, tsuba::PropStorageFormat format) {
+  auto it = std::find_if(
+      prop_info_list->begin(), prop_info_list->end(),
+      [&name](const tsuba::PropStorageInfo& p) { return p.name == name; });
+  if (it == prop_info_list->end()) {
+    GALOIS_LOG_DEBUG("failed: property `{}` not found", name);
+    return tsuba::ErrorCode::PropertyNotFound;
+  }
+  if (it->format != format) {
+    it->format = format;
+    // force the property to be rewritten in the new format
+    it->path = "";
+    it->row_groups = {};
+  }
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+SetWriteOptions(
+    std::vector<tsuba::PropStorageInfo>* prop_info_list,
+    const std::string& name, const tsuba::PropWriteOptions& options) {
+  auto it = std::find_if(
+      prop_info_list->begin(), prop_info_list->end(),
+      [&name](const tsuba::PropStorageInfo& p) { return p.name == name; });
+  if (it == prop_info_list->end()) {
+    GALOIS_LOG_DEBUG("failed: property `{}` not found", name);
+    return tsuba::ErrorCode::PropertyNotFound;
+  }
+  it->write_options = options;
+  // force the property to be rewritten with the new options
+  it->path = "";
+  it->row_groups = {};
+  return galois::ResultSuccess();
+}
+
+/// Split prop_info_list into the named properties, in the order given, and
+/// the remaining properties, in their original order
+galois::Result<void>
+SplitProps(
+    const std::vector<std::string>& names,
+    std::vector<tsuba::PropStorageInfo>* prop_info_list,
+    std::vector<tsuba::PropStorageInfo>* rest) {
+  std::unordered_map<std::string, size_t> positions;
+  for (size_t i = 0; i < prop_info_list->size(); ++i) {
+    positions.emplace((*prop_info_list)[i].name, i);
+  }
+
+  std::vector<bool> named(prop_info_list->size(), false);
+  std::vector<tsuba::PropStorageInfo> next_prop_info_list;
+  for (const std::string& name : names) {
+    auto it = positions.find(name);
+    if (it == positions.end()) {
+      GALOIS_LOG_DEBUG("failed: property `{}` not found", name);
+      return tsuba::ErrorCode::PropertyNotFound;
+    }
+    named[it->second] = true;
+    next_prop_info_list.emplace_back((*prop_info_list)[it->second]);
+  }
+
+  for (size_t i = 0; i < prop_info_list->size(); ++i) {
+    if (!named[i]) {
+      rest->emplace_back(std::move((*prop_info_list)[i]));
+    }
+  }
+  *prop_info_list = std::move(next_prop_info_list);
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+MarkLoaded(
+    const std::string& name, std::vector<tsuba::PropStorageInfo>* unloaded,
+    std::vector<tsuba::PropStorageInfo>* loaded) {
+  auto it = std::find_if(
+      unloaded->begin(), unloaded->end(),
+      [&name](const tsuba::PropStorageInfo& p) { return p.name == name; });
+  if (it == unloaded->end()) {
+    GALOIS_LOG_DEBUG("failed: unloaded property `{}` not found", name);
+    return tsuba::ErrorCode::PropertyNotFound;
+  }
+  loaded->emplace_back(std::move(*it));
+  unloaded->erase(it);
+  return galois::ResultSuccess();
+}
+
+galois::Result<void>
+RemoveUnloaded(
+    const std::string& name, std::vector<tsuba::PropStorageInfo>* unloaded) {
+  auto it = std::find_if(
+      unloaded->begin(), unloaded->end(),
+      [&name](const tsuba::PropStorageInfo& p) { return p.name == name; });
+  if (it == unloaded->end()) {
+    GALOIS_LOG_DEBUG("failed: unloaded property `{}` not found", name);
+    return tsuba::ErrorCode::PropertyNotFound;
+  }
+  unloaded->erase(it);
+  return galois::ResultSuccess();
+}
+
+/// Loaded properties are serialized before unloaded ones
+std::vector<tsuba::PropStorageInfo>
+AllProps(
+    const std::vector<tsuba::PropStorageInfo>& loaded,
+    const std::vector<tsuba::PropStorageInfo>& unloaded) {
+  std::vector<tsuba::PropStorageInfo> all = loaded;
+  all.insert(all.end(), unloaded.begin(), unloaded.end());
+  return all;
+}
+
+/// HeaderCache keeps recently parsed part headers by file name, along with
+/// the size and modification time of the file they were parsed from. A file
+/// name alone is not enough: a version number is reused when an RDG is
+/// deleted and created again at the same location, possibly by another
+/// process, so a cached header is only used while the file still has the
+/// size and modification time it had when it was read.
+class HeaderCache {
+public:
+  static constexpr size_t kCapacity = 64;
+
+  std::optional<tsuba::RDGPartHeader> Find(
+      const std::string& path, const tsuba::StatBuf& stat) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(path);
+    if (it == entries_.end()) {
+      return std::nullopt;
+    }
+    if (it->second.stat.size != stat.size ||
+        it->second.stat.mtime_ns != stat.mtime_ns) {
+      lru_.erase(it->second.lru_pos);
+      entries_.erase(it);
+      return std::nullopt;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+    return it->second.header;
+  }
+
+  /// Cache header as parsed from path, which had stat before it was read
+  void Insert(
+      const std::string& path, const tsuba::StatBuf& stat,
+      const tsuba::RDGPartHeader& header) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = entries_.find(path); it != entries_.end()) {
+      it->second.stat = stat;
+      it->second.header = header;
+      lru_.splice(lru_.begin(), lru_, it->second.lru_pos);
+      return;
+    }
+    lru_.emplace_front(path);
+    entries_.emplace(path, Entry{stat, header, lru_.begin()});
+    if (entries_.size() > kCapacity) {
+      entries_.erase(lru_.back());
+      lru_.pop_back();
+    }
+  }
+
+  /// Drop path, e.g., because it is about to be (re)written. A version whose
+  /// commit failed is retried under the same file name.
+  void Forget(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(path);
+    if (it == entries_.end()) {
+      return;
+    }
+    lru_.erase(it->second.lru_pos);
+    entries_.erase(it);
+  }
+
+private:
+  struct Entry {
+    tsuba::StatBuf stat;
+    tsuba::RDGPartHeader header;
+    std::list<std::string>::iterator lru_pos;
+  };
+
+  std::mutex mutex_;
+  // most recently used first
+  std::list<std::string> lru_;
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+HeaderCache&
+GetHeaderCache() {
+  static HeaderCache cache;
+  return cache;
+}
+
 }  // namespace
 
 namespace tsuba {
@@ -190,8 +407,22 @@ RDGPartHeader::MakeJson(const galois::Uri& partition_path) {
 
 galois::Result<RDGPartHeader>
 RDGPartHeader::Make(const galois::Uri& partition_path) {
+  std::string key = partition_path.string();
+  // stat before reading so that a change made while reading is noticed the
+  // next time
+  StatBuf stat;
+  if (auto res = FileStat(key, &stat); !res) {
+    GALOIS_LOG_DEBUG("cannot stat {}: {}", key, res.error());
+    return res.error();
+  }
+  if (auto cached = GetHeaderCache().Find(key, stat); cached) {
+    StatAdd("PartHeaderCacheHits", 1);
+    return std::move(cached.value());
+  }
+
   galois::Result<RDGPartHeader> res = MakeJson(partition_path);
   if (res) {
+    GetHeaderCache().Insert(key, stat, res.value());
     return res;
   }
 
@@ -199,7 +430,11 @@ RDGPartHeader::Make(const galois::Uri& partition_path) {
   GALOIS_LOG_ERROR("falling back on Parquet (deprecated)");
 
   try {
-    return MakeParquet(partition_path);
+    auto parquet_res = MakeParquet(partition_path);
+    if (parquet_res) {
+      GetHeaderCache().Insert(key, stat, parquet_res.value());
+    }
+    return parquet_res;
   } catch (const std::exception& exp) {
     GALOIS_LOG_DEBUG("arrow exception: {}", exp.what());
     return ErrorCode::ArrowError;
@@ -228,10 +463,11 @@ RDGPartHeader::Write(RDGHandle handle, WriteGroup* writes) const {
     return ArrowToTsuba(res.code());
   }
 
-  ff->Bind(RDGMeta::PartitionFileName(
-               handle.impl_->rdg_meta().dir(), Comm()->ID,
-               handle.impl_->rdg_meta().version() + 1)
-               .string());
+  galois::Uri path = RDGMeta::PartitionFileName(
+      handle.impl_->rdg_meta().dir(), Comm()->ID,
+      handle.impl_->rdg_meta().version() + 1);
+  GetHeaderCache().Forget(path.string());
+  ff->Bind(path.string());
 
   writes->StartStore(std::move(ff));
   TSUBA_PTP(internal::FaultSensitivity::Normal);
@@ -283,6 +519,39 @@ RDGPartHeader::PrunePropsTo(
   return galois::ResultSuccess();
 }
 
+galois::Result<void>
+RDGPartHeader::DeferPropsExcept(
+    const std::vector<std::string>& node_props,
+    const std::vector<std::string>& edge_props) {
+  if (auto res = SplitProps(
+          node_props, &node_prop_info_list_, &unloaded_node_prop_info_list_);
+      !res) {
+    return res.error();
+  }
+  return SplitProps(
+      edge_props, &edge_prop_info_list_, &unloaded_edge_prop_info_list_);
+}
+
+Result<void>
+RDGPartHeader::MarkNodePropertyLoaded(const std::string& name) {
+  return MarkLoaded(name, &unloaded_node_prop_info_list_, &node_prop_info_list_);
+}
+
+Result<void>
+RDGPartHeader::MarkEdgePropertyLoaded(const std::string& name) {
+  return MarkLoaded(name, &unloaded_edge_prop_info_list_, &edge_prop_info_list_);
+}
+
+Result<void>
+RDGPartHeader::RemoveUnloadedNodeProperty(const std::string& name) {
+  return RemoveUnloaded(name, &unloaded_node_prop_info_list_);
+}
+
+Result<void>
+RDGPartHeader::RemoveUnloadedEdgeProperty(const std::string& name) {
+  return RemoveUnloaded(name, &unloaded_edge_prop_info_list_);
+}
+
 Result<void>
 RDGPartHeader::Validate() const {
   for (const auto& md : node_prop_info_list_) {
@@ -316,13 +585,12 @@ RDGPartHeader::Validate() const {
 
 void
 RDGPartHeader::MarkAllPropertiesPersistent() {
-  std::for_each(
-      node_prop_info_list_.begin(), node_prop_info_list_.end(),
-      [](auto& p) { return p.persist = true; });
-
-  std::for_each(
-      edge_prop_info_list_.begin(), edge_prop_info_list_.end(),
-      [](auto& p) { return p.persist = true; });
+  for (auto* list :
+       {&node_prop_info_list_, &edge_prop_info_list_,
+        &unloaded_node_prop_info_list_, &unloaded_edge_prop_info_list_}) {
+    std::for_each(
+        list->begin(), list->end(), [](auto& p) { return p.persist = true; });
+  }
 }
 
 Result<void>
@@ -365,20 +633,62 @@ RDGPartHeader::MarkEdgePropertiesPersistent(
   return galois::ResultSuccess();
 }
 
+Result<void>
+RDGPartHeader::SetNodePropertyStorageFormat(
+    const std::string& name, PropStorageFormat format) {
+  return SetStorageFormat(&node_prop_info_list_, name, format);
+}
+
+Result<void>
+RDGPartHeader::SetEdgePropertyStorageFormat(
+    const std::string& name, PropStorageFormat format) {
+  return SetStorageFormat(&edge_prop_info_list_, name, format);
+}
+
+Result<void>
+RDGPartHeader::SetNodePropertyWriteOptions(
+    const std::string& name, const PropWriteOptions& options) {
+  return SetWriteOptions(&node_prop_info_list_, name, options);
+}
+
+Result<void>
+RDGPartHeader::SetEdgePropertyWriteOptions(
+    const std::string& name, const PropWriteOptions& options) {
+  return SetWriteOptions(&edge_prop_info_list_, name, options);
+}
+
 void
 RDGPartHeader::UnbindFromStorage() {
   for (PropStorageInfo& prop : node_prop_info_list_) {
     prop.path = "";
+    prop.row_groups = {};
   }
   for (PropStorageInfo& prop : edge_prop_info_list_) {
     prop.path = "";
+    prop.row_groups = {};
   }
   for (PropStorageInfo& prop : part_prop_info_list_) {
     prop.path = "";
+    prop.row_groups = {};
+  }
+  for (PropStorageInfo& prop : topology_array_info_list_) {
+    prop.path = "";
   }
   topology_path_ = "";
 }
 
+void
+RDGPartHeader::SetTopologyArrayInfo(PropStorageInfo&& info) {
+  auto it = std::find_if(
+      topology_array_info_list_.begin(), topology_array_info_list_.end(),
+      [&info](const PropStorageInfo& p) { return p.name == info.name; });
+  if (it == topology_array_info_list_.end()) {
+    topology_array_info_list_.emplace_back(std::move(info));
+  } else {
+    *it = std::move(info);
+  }
+}
+
 }  // namespace tsuba
 
 // specialized PropStorageInfo vec transformation to avoid nulls in the output
@@ -396,11 +706,24 @@ void
 tsuba::to_json(json& j, const tsuba::RDGPartHeader& header) {
   j = json{
       {kTopologyPathKey, header.topology_path_},
-      {kNodePropertyKey, header.node_prop_info_list_},
-      {kEdgePropertyKey, header.edge_prop_info_list_},
+      {kNodePropertyKey,
+       AllProps(
+           header.node_prop_info_list_, header.unloaded_node_prop_info_list_)},
+      {kEdgePropertyKey,
+       AllProps(
+           header.edge_prop_info_list_, header.unloaded_edge_prop_info_list_)},
       {kPartPropertyFilesKey, header.part_prop_info_list_},
       {kPartProperyMetaKey, header.metadata_},
   };
+  // Only present if there are topology arrays so that other headers are
+  // unchanged
+  if (!header.topology_array_info_list_.empty()) {
+    j[kTopologyArrayFilesKey] = header.topology_array_info_list_;
+  }
+  // Likewise only present if the options are not the defaults
+  if (header.prop_write_options_ != PropWriteOptions()) {
+    j[kPropWriteOptionsKey] = header.prop_write_options_;
+  }
 }
 
 void
@@ -410,6 +733,16 @@ tsuba::from_json(const json& j, tsuba::RDGPartHeader& header) {
   j.at(kEdgePropertyKey).get_to(header.edge_prop_info_list_);
   j.at(kPartPropertyFilesKey).get_to(header.part_prop_info_list_);
   j.at(kPartProperyMetaKey).get_to(header.metadata_);
+  if (j.contains(kTopologyArrayFilesKey)) {
+    j.at(kTopologyArrayFilesKey).get_to(header.topology_array_info_list_);
+    // these are always persisted
+    for (PropStorageInfo& prop : header.topology_array_info_list_) {
+      prop.persist = true;
+    }
+  }
+  if (j.contains(kPropWriteOptionsKey)) {
+    j.at(kPropWriteOptionsKey).get_to(header.prop_write_options_);
+  }
 }
 
 void
@@ -451,16 +784,119 @@ tsuba::from_json(const json& j, tsuba::PartitionMetadata& pmd) {
   }
 }
 
+// PropStorageInfo is serialized as [name, path] and, when any of the
+// optional fields differs from its default, [name, path, fields], where
+// fields is an object holding only the non-default fields by name. Headers
+// written before the fields were keyed store them positionally as
+// [name, path, format, row_group_index, write_options, dictionary], cut
+// after the last non-default field, with null for missing write_options;
+// those are still read.
 void
 tsuba::from_json(const nlohmann::json& j, tsuba::PropStorageInfo& propmd) {
   j.at(0).get_to(propmd.name);
   j.at(1).get_to(propmd.path);
+  propmd.format = PropStorageFormat::Parquet;
+  propmd.row_groups = {};
+  propmd.write_options = std::nullopt;
+  propmd.dictionary = false;
+  if (j.size() < 3) {
+    return;
+  }
+
+  const json& fields = j.at(2);
+  if (fields.is_object()) {
+    if (fields.contains(kPropFormatKey)) {
+      propmd.format =
+          ParsePropStorageFormat(fields.at(kPropFormatKey).get<std::string>());
+    }
+    if (fields.contains(kPropRowGroupsKey)) {
+      fields.at(kPropRowGroupsKey).get_to(propmd.row_groups);
+    }
+    if (fields.contains(kPropWriteOptionsFieldKey)) {
+      fields.at(kPropWriteOptionsFieldKey)
+          .get_to(propmd.write_options.emplace());
+    }
+    if (fields.contains(kPropDictionaryKey)) {
+      fields.at(kPropDictionaryKey).get_to(propmd.dictionary);
+    }
+    return;
+  }
+
+  propmd.format = ParsePropStorageFormat(fields.get<std::string>());
+  if (j.size() > 3) {
+    j.at(3).get_to(propmd.row_groups);
+  }
+  if (j.size() > 4 && !j.at(4).is_null()) {
+    j.at(4).get_to(propmd.write_options.emplace());
+  }
+  if (j.size() > 5) {
+    j.at(5).get_to(propmd.dictionary);
+  }
 }
 
 void
 tsuba::to_json(json& j, const tsuba::PropStorageInfo& propmd) {
   if (propmd.persist) {
     j = json{propmd.name, propmd.path};
+    // fields are left out while they have their default values
+    json fields = json::object();
+    if (propmd.format != PropStorageFormat::Parquet) {
+      fields[kPropFormatKey] = kArrowIPCFormatName;
+    }
+    if (!propmd.row_groups.empty()) {
+      fields[kPropRowGroupsKey] = propmd.row_groups;
+    }
+    if (propmd.write_options) {
+      fields[kPropWriteOptionsFieldKey] = propmd.write_options.value();
+    }
+    if (propmd.dictionary) {
+      fields[kPropDictionaryKey] = true;
+    }
+    if (!fields.empty()) {
+      j.push_back(std::move(fields));
+    }
   }
   // creates a null value if property wasn't supposed to be persisted
 }
+
+void
+tsuba::to_json(json& j, const tsuba::RowGroupIndex& index) {
+  j = json{{"rows", index.rows}, {"offsets", index.offsets}};
+}
+
+void
+tsuba::from_json(const json& j, tsuba::RowGroupIndex& index) {
+  j.at("rows").get_to(index.rows);
+  j.at("offsets").get_to(index.offsets);
+
+  if (index.rows.size() != index.offsets.size() || index.rows.size() == 1) {
+    // nlohmann::json reports errors using exceptions
+    throw std::runtime_error("malformed row group index");
+  }
+}
+
+void
+tsuba::to_json(json& j, const tsuba::PropWriteOptions& options) {
+  j = json{
+      {"row_group_size", options.row_group_size},
+      {"codec", arrow::util::Codec::GetCodecAsString(options.codec)},
+      {"compression_level", options.compression_level},
+      {"dictionary", options.dictionary},
+  };
+}
+
+void
+tsuba::from_json(const json& j, tsuba::PropWriteOptions& options) {
+  j.at("row_group_size").get_to(options.row_group_size);
+  j.at("compression_level").get_to(options.compression_level);
+  j.at("dictionary").get_to(options.dictionary);
+
+  std::string codec;
+  j.at("codec").get_to(codec);
+  auto codec_result = arrow::util::Codec::GetCompressionType(codec);
+  if (!codec_result.ok()) {
+    // nlohmann::json reports errors using exceptions
+    throw std::runtime_error("unknown codec " + codec);
+  }
+  options.codec = codec_result.ValueOrDie();
+}
@@ -2,6 +2,7 @@
 #define GALOIS_LIBTSUBA_RDGPARTHEADER_H_
 
 #include <cassert>
+#include <optional>
 #include <vector>
 
 #include <arrow/api.h>
@@ -10,15 +11,35 @@
 #include "galois/Result.h"
 #include "galois/Uri.h"
 #include "tsuba/PartitionMetadata.h"
+#include "tsuba/RDG.h"
 #include "tsuba/WriteGroup.h"
 #include "tsuba/tsuba.h"
 
 namespace tsuba {
 
+/// Where the row groups of a property stored as Parquet begin. Row group i
+/// holds rows [rows[i], rows[i + 1]) and its column data is in bytes
+/// [offsets[i], offsets[i + 1]) of the file. Empty if unknown, e.g., for
+/// properties written before the index was recorded.
+struct RowGroupIndex {
+  std::vector<int64_t> rows;
+  std::vector<int64_t> offsets;
+
+  bool empty() const { return rows.empty(); }
+};
+
 struct PropStorageInfo {
   std::string name;
   std::string path;
   bool persist{false};
+  PropStorageFormat format{PropStorageFormat::Parquet};
+  RowGroupIndex row_groups{};
+  /// Options to write this property with instead of the RDG wide ones
+  std::optional<PropWriteOptions> write_options{};
+  /// The property was an arrow::DictionaryArray when it was stored and is
+  /// loaded as one. Parquet files only record the values, which are loaded
+  /// as plain arrays otherwise.
+  bool dictionary{false};
 };
 
 class GALOIS_EXPORT RDGPartHeader {
@@ -31,6 +52,12 @@ public:
       const std::vector<std::string>* node_props,
       const std::vector<std::string>* edge_props);
 
+  /// Like PrunePropsTo, but rather than dropping the properties that are not
+  /// named, keep them as unloaded properties that can be loaded later
+  galois::Result<void> DeferPropsExcept(
+      const std::vector<std::string>& node_props,
+      const std::vector<std::string>& edge_props);
+
   galois::Result<void> Write(RDGHandle handle, WriteGroup* writes) const;
 
   void UnbindFromStorage();
@@ -59,6 +86,14 @@ public:
     p.erase(p.begin() + i);
   }
 
+  /// Move a property from the unloaded list to the end of the loaded list
+  galois::Result<void> MarkNodePropertyLoaded(const std::string& name);
+  galois::Result<void> MarkEdgePropertyLoaded(const std::string& name);
+
+  /// Drop a property from the unloaded list
+  galois::Result<void> RemoveUnloadedNodeProperty(const std::string& name);
+  galois::Result<void> RemoveUnloadedEdgeProperty(const std::string& name);
+
   //
   // Property persistence
   //
@@ -71,6 +106,18 @@ public:
   galois::Result<void> MarkEdgePropertiesPersistent(
       const std::vector<std::string>& persist_edge_props);
 
+  galois::Result<void> SetNodePropertyStorageFormat(
+      const std::string& name, PropStorageFormat format);
+
+  galois::Result<void> SetEdgePropertyStorageFormat(
+      const std::string& name, PropStorageFormat format);
+
+  galois::Result<void> SetNodePropertyWriteOptions(
+      const std::string& name, const PropWriteOptions& options);
+
+  galois::Result<void> SetEdgePropertyWriteOptions(
+      const std::string& name, const PropWriteOptions& options);
+
   //
   // Accessors/Mutators
   //
@@ -94,9 +141,25 @@ public:
     edge_prop_info_list_ = std::move(edge_prop_info_list);
   }
 
+  /// Properties that are stored but not present in the in-memory tables
+  const std::vector<PropStorageInfo>& unloaded_node_prop_info_list() const {
+    return unloaded_node_prop_info_list_;
+  }
+  const std::vector<PropStorageInfo>& unloaded_edge_prop_info_list() const {
+    return unloaded_edge_prop_info_list_;
+  }
+
   const std::vector<PropStorageInfo>& part_prop_info_list() const {
     return part_prop_info_list_;
   }
+
+  /// Arrays derived from the topology; see RDG::SetTopologyArray
+  const std::vector<PropStorageInfo>& topology_array_info_list() const {
+    return topology_array_info_list_;
+  }
+  /// Add info about a topology array, replacing any with the same name
+  void SetTopologyArrayInfo(PropStorageInfo&& info);
+  void ClearTopologyArrays() { topology_array_info_list_.clear(); }
   void set_part_properties(std::vector<PropStorageInfo>&& part_prop_info_list) {
     part_prop_info_list_ = std::move(part_prop_info_list);
   }
@@ -104,6 +167,14 @@ public:
   const PartitionMetadata& metadata() const { return metadata_; }
   void set_metadata(const PartitionMetadata& metadata) { metadata_ = metadata; }
 
+  /// Options for properties that do not have their own write_options
+  const PropWriteOptions& prop_write_options() const {
+    return prop_write_options_;
+  }
+  void set_prop_write_options(const PropWriteOptions& options) {
+    prop_write_options_ = options;
+  }
+
   friend void to_json(nlohmann::json& j, const RDGPartHeader& header);
   friend void from_json(const nlohmann::json& j, RDGPartHeader& header);
 
@@ -116,11 +187,16 @@ private:
   std::vector<PropStorageInfo> part_prop_info_list_;
   std::vector<PropStorageInfo> node_prop_info_list_;
   std::vector<PropStorageInfo> edge_prop_info_list_;
+  std::vector<PropStorageInfo> unloaded_node_prop_info_list_;
+  std::vector<PropStorageInfo> unloaded_edge_prop_info_list_;
+  std::vector<PropStorageInfo> topology_array_info_list_;
 
   /// Metadata filled in by CuSP, or from storage (meta partition file)
   PartitionMetadata metadata_;
 
   std::string topology_path_;
+
+  PropWriteOptions prop_write_options_;
 };
 
 void to_json(nlohmann::json& j, const RDGPartHeader& header);
@@ -129,6 +205,12 @@ void from_json(const nlohmann::json& j, RDGPartHeader& header);
 void to_json(nlohmann::json& j, const PropStorageInfo& propmd);
 void from_json(const nlohmann::json& j, PropStorageInfo& propmd);
 
+void to_json(nlohmann::json& j, const RowGroupIndex& index);
+void from_json(const nlohmann::json& j, RowGroupIndex& index);
+
+void to_json(nlohmann::json& j, const PropWriteOptions& options);
+void from_json(const nlohmann::json& j, PropWriteOptions& options);
+
 void to_json(nlohmann::json& j, const PartitionMetadata& propmd);
 void from_json(const nlohmann::json& j, PartitionMetadata& propmd);
 
@@ -1,11 +1,21 @@
 #include "tsuba/RDGPrefix.h"
 
+#include <cmath>
+
 #include "RDGHandleImpl.h"
 #include "RDGPartHeader.h"
 #include "galois/Result.h"
 #include "tsuba/Errors.h"
 #include "tsuba/file.h"
 
+namespace {
+
+// Only uncompressed topology files have an array of node indexes after the
+// header
+constexpr uint64_t kPlainTopologyVersion = 1;
+
+}  // namespace
+
 namespace tsuba {
 
 galois::Result<tsuba::RDGPrefix>
@@ -53,4 +63,77 @@ RDGPrefix::Make(RDGHandle handle) {
   return DoMakePrefix(handle.impl_->rdg_meta());
 }
 
+RDGSlice::SliceArg
+RDGPrefix::MakeSliceArg(uint64_t first_node, uint64_t last_node) const {
+  assert(first_node <= last_node && last_node <= num_nodes());
+  uint64_t first_edge = edges_before(first_node);
+  uint64_t last_edge = edges_before(last_node);
+
+  uint64_t dests_off = sizeof(GRHeader) + num_nodes() * sizeof(uint64_t);
+  uint64_t topo_off = sizeof(GRHeader) + first_node * sizeof(uint64_t);
+  uint64_t topo_end = dests_off + last_edge * sizeof(uint32_t);
+
+  return RDGSlice::SliceArg{
+      .node_range = {first_node, last_node},
+      .edge_range = {first_edge, last_edge},
+      .topo_off = topo_off,
+      .topo_size = topo_end - topo_off,
+  };
+}
+
+galois::Result<std::vector<RDGSlice::SliceArg>>
+RDGPrefix::PlanSlices(uint32_t num_slices, const SliceWeights& weights) const {
+  if (prefix_ == nullptr) {
+    GALOIS_LOG_DEBUG("RDG has no topology");
+    return ErrorCode::InvalidArgument;
+  }
+  if (version() != kPlainTopologyVersion) {
+    GALOIS_LOG_DEBUG("cannot plan slices of topology version {}", version());
+    return ErrorCode::NotImplemented;
+  }
+  if (num_slices == 0 || weights.node_weight < 0 || weights.edge_weight < 0 ||
+      weights.node_weight + weights.edge_weight <= 0) {
+    GALOIS_LOG_DEBUG(
+        "bad slice plan arguments: {} slices, weights {} {}", num_slices,
+        weights.node_weight, weights.edge_weight);
+    return ErrorCode::InvalidArgument;
+  }
+
+  // weight of nodes [0, n); nondecreasing in n
+  auto weight = [&](uint64_t n) {
+    return weights.node_weight * n + weights.edge_weight * edges_before(n);
+  };
+  double total = weight(num_nodes());
+
+  std::vector<uint64_t> cuts{0};
+  for (uint32_t i = 1; i < num_slices; ++i) {
+    double target = total * i / num_slices;
+    // first n in [prev, num_nodes] with weight(n) >= target
+    uint64_t lo = cuts.back();
+    uint64_t hi = num_nodes();
+    while (lo < hi) {
+      uint64_t mid = lo + (hi - lo) / 2;
+      if (weight(mid) < target) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    // stopping just short of target may be closer
+    if (lo > cuts.back() &&
+        std::abs(target - weight(lo - 1)) < std::abs(weight(lo) - target)) {
+      --lo;
+    }
+    cuts.emplace_back(lo);
+  }
+  cuts.emplace_back(num_nodes());
+
+  std::vector<RDGSlice::SliceArg> slices;
+  slices.reserve(num_slices);
+  for (uint32_t i = 0; i < num_slices; ++i) {
+    slices.emplace_back(MakeSliceArg(cuts[i], cuts[i + 1]));
+  }
+  return slices;
+}
+
 }  // namespace tsuba
@@ -0,0 +1,176 @@
+#include "SimStorage.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "galois/Env.h"
+#include "galois/Logging.h"
+#include "tsuba/Errors.h"
+#include "tsuba/Stats.h"
+#include "tsuba/file.h"
+
+std::string
+tsuba::SimStorage::LocalUri(const std::string& uri) const {
+  if (uri.find(uri_scheme()) != 0) {
+    return uri;
+  }
+  return std::string(uri.begin() + uri_scheme().size(), uri.end());
+}
+
+galois::Result<void>
+tsuba::SimStorage::Init() {
+  if (int us = 0; galois::GetEnv("TSUBA_SIM_LATENCY_US", &us) && us >= 0) {
+    latency_ = std::chrono::microseconds(us);
+  }
+  if (int us = 0; galois::GetEnv("TSUBA_SIM_JITTER_US", &us) && us >= 0) {
+    jitter_ = std::chrono::microseconds(us);
+  }
+  if (double mbps = 0; galois::GetEnv("TSUBA_SIM_MBPS", &mbps) && mbps >= 0) {
+    // 1 MB/s is 1 byte per microsecond
+    bytes_per_us_ = mbps;
+  }
+  if (int n = 0; galois::GetEnv("TSUBA_SIM_MAX_REQUESTS", &n) && n >= 0) {
+    max_requests_ = n;
+  }
+  link_free_ = std::chrono::steady_clock::now();
+  return local_.Init();
+}
+
+galois::Result<void>
+tsuba::SimStorage::Fini() {
+  return local_.Fini();
+}
+
+galois::Result<void>
+tsuba::SimStorage::Simulate(
+    uint64_t size, const std::function<galois::Result<void>()>& op) {
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point done;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    request_done_.wait(lock, [&]() {
+      return max_requests_ == 0 || requests_ < max_requests_;
+    });
+    ++requests_;
+
+    auto delay = latency_;
+    if (jitter_.count() > 0) {
+      std::uniform_int_distribution<int64_t> dist(0, jitter_.count());
+      delay += std::chrono::microseconds(dist(rng_));
+    }
+    done = std::chrono::steady_clock::now() + delay;
+
+    // Requests share the link: a transfer starts once the link has sent
+    // everything queued before it
+    if (bytes_per_us_ > 0 && size > 0) {
+      auto transfer = std::chrono::microseconds(
+          static_cast<int64_t>(static_cast<double>(size) / bytes_per_us_));
+      link_free_ = std::max(link_free_, done) + transfer;
+      done = link_free_;
+    }
+  }
+
+  auto res = op();
+  std::this_thread::sleep_until(done);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --requests_;
+  }
+  request_done_.notify_one();
+
+  StatAdd("SimRequests", 1);
+  StatAdd("SimBytes", size);
+  StatAdd(
+      "SimRequestMicroseconds",
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count());
+  return res;
+}
+
+galois::Result<void>
+tsuba::SimStorage::Stat(const std::string& uri, StatBuf* size) {
+  return Simulate(0, [&]() { return local_.Stat(LocalUri(uri), size); });
+}
+
+galois::Result<void>
+tsuba::SimStorage::GetMultiSync(
+    const std::string& uri, uint64_t start, uint64_t size,
+    uint8_t* result_buf) {
+  return Simulate(size, [&]() {
+    return local_.GetMultiSync(LocalUri(uri), start, size, result_buf);
+  });
+}
+
+galois::Result<void>
+tsuba::SimStorage::PutMultiSync(
+    const std::string& uri, const uint8_t* data, uint64_t size) {
+  return Simulate(size, [&]() {
+    return local_.PutMultiSync(LocalUri(uri), data, size);
+  });
+}
+
+std::future<galois::Result<void>>
+tsuba::SimStorage::ListAsync(
+    const std::string& directory, std::vector<std::string>* list,
+    std::vector<uint64_t>* size) {
+  return std::async(std::launch::async, [=]() -> galois::Result<void> {
+    return Simulate(0, [&]() {
+      return local_.ListAsync(LocalUri(directory), list, size).get();
+    });
+  });
+}
+
+galois::Result<void>
+tsuba::SimStorage::Delete(
+    const std::string& directory,
+    const std::unordered_set<std::string>& files) {
+  return Simulate(
+      0, [&]() { return local_.Delete(LocalUri(directory), files); });
+}
+
+galois::Result<std::string>
+tsuba::SimStorage::MultipartBegin(const std::string& uri, uint64_t part_size) {
+  galois::Result<std::string> upload_id = ErrorCode::InvalidArgument;
+  auto res = Simulate(0, [&]() -> galois::Result<void> {
+    upload_id = local_.MultipartBegin(LocalUri(uri), part_size);
+    if (!upload_id) {
+      return upload_id.error();
+    }
+    return galois::ResultSuccess();
+  });
+  if (!res) {
+    return res.error();
+  }
+  return upload_id;
+}
+
+std::future<galois::Result<void>>
+tsuba::SimStorage::MultipartPutAsync(
+    const std::string& uri, const std::string& upload_id, uint64_t part_number,
+    const uint8_t* data, uint64_t size) {
+  return std::async(std::launch::async, [=]() -> galois::Result<void> {
+    return Simulate(size, [&]() {
+      return local_
+          .MultipartPutAsync(LocalUri(uri), upload_id, part_number, data, size)
+          .get();
+    });
+  });
+}
+
+galois::Result<void>
+tsuba::SimStorage::MultipartComplete(
+    const std::string& uri, const std::string& upload_id, uint64_t num_parts) {
+  return Simulate(0, [&]() {
+    return local_.MultipartComplete(LocalUri(uri), upload_id, num_parts);
+  });
+}
+
+galois::Result<void>
+tsuba::SimStorage::MultipartAbort(
+    const std::string& uri, const std::string& upload_id) {
+  return Simulate(0, [&]() {
+    return local_.MultipartAbort(LocalUri(uri), upload_id);
+  });
+}
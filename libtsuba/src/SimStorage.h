@@ -0,0 +1,107 @@
+#ifndef GALOIS_LIBTSUBA_SIMSTORAGE_H_
+#define GALOIS_LIBTSUBA_SIMSTORAGE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <random>
+#include <string>
+
+#include "LocalStorage.h"
+#include "galois/Result.h"
+#include "tsuba/FileStorage.h"
+
+namespace tsuba {
+
+/// SimStorage stores files on the local file system like LocalStorage, but
+/// under the sim:// scheme and with the performance of remote storage, so
+/// that I/O changes can be measured as if data were remote without leaving
+/// the machine. sim:///path/to/file is stored at /path/to/file.
+///
+/// Its behavior is set by environment variables read at Init:
+///
+///   TSUBA_SIM_LATENCY_US: added to every request (default 20000)
+///   TSUBA_SIM_JITTER_US: maximum random latency added on top (default 0)
+///   TSUBA_SIM_MBPS: bandwidth shared by all requests in MB/s; 0 means
+///     unlimited (default 100)
+///   TSUBA_SIM_MAX_REQUESTS: maximum concurrent requests; later requests
+///     wait; 0 means unlimited (default 0)
+///
+/// Unlike LocalStorage, SimStorage does not support Mmap.
+class SimStorage : public FileStorage {
+  LocalStorage local_;
+
+  std::chrono::microseconds latency_{20000};
+  std::chrono::microseconds jitter_{0};
+  double bytes_per_us_{100.0};
+  int max_requests_{0};
+
+  std::mutex mutex_;
+  std::condition_variable request_done_;
+  int requests_{0};
+  // when the simulated link has sent everything queued so far
+  std::chrono::steady_clock::time_point link_free_;
+  std::mt19937_64 rng_;
+
+  std::string LocalUri(const std::string& uri) const;
+
+  /// Delay as a request of size bytes would be delayed, then run op
+  galois::Result<void> Simulate(
+      uint64_t size, const std::function<galois::Result<void>()>& op);
+
+public:
+  SimStorage() : FileStorage("sim://") {}
+
+  galois::Result<void> Init() override;
+  galois::Result<void> Fini() override;
+  galois::Result<void> Stat(const std::string& uri, StatBuf* size) override;
+
+  // Larger pages than local storage, as for remote storage
+  uint8_t PageShift() const override { return 22; /* 4M */ }
+
+  galois::Result<void> GetMultiSync(
+      const std::string& uri, uint64_t start, uint64_t size,
+      uint8_t* result_buf) override;
+
+  galois::Result<void> PutMultiSync(
+      const std::string& uri, const uint8_t* data, uint64_t size) override;
+
+  std::future<galois::Result<void>> PutAsync(
+      const std::string& uri, const uint8_t* data, uint64_t size) override {
+    return std::async(std::launch::async, [=]() -> galois::Result<void> {
+      return PutMultiSync(uri, data, size);
+    });
+  }
+  std::future<galois::Result<void>> GetAsync(
+      const std::string& uri, uint64_t start, uint64_t size,
+      uint8_t* result_buf) override {
+    return std::async(std::launch::async, [=]() -> galois::Result<void> {
+      return GetMultiSync(uri, start, size, result_buf);
+    });
+  }
+  std::future<galois::Result<void>> ListAsync(
+      const std::string& directory, std::vector<std::string>* list,
+      std::vector<uint64_t>* size) override;
+
+  galois::Result<void> Delete(
+      const std::string& directory,
+      const std::unordered_set<std::string>& files) override;
+
+  galois::Result<std::string> MultipartBegin(
+      const std::string& uri, uint64_t part_size) override;
+  std::future<galois::Result<void>> MultipartPutAsync(
+      const std::string& uri, const std::string& upload_id,
+      uint64_t part_number, const uint8_t* data, uint64_t size) override;
+  galois::Result<void> MultipartComplete(
+      const std::string& uri, const std::string& upload_id,
+      uint64_t num_parts) override;
+  galois::Result<void> MultipartAbort(
+      const std::string& uri, const std::string& upload_id) override;
+};
+
+}  // namespace tsuba
+
+#endif
@@ -0,0 +1,63 @@
+#include "tsuba/Stats.h"
+
+#include <map>
+#include <mutex>
+
+namespace {
+
+struct StatStore {
+  std::mutex mutex;
+  std::map<std::string, int64_t> ints;
+  std::map<std::string, double> fps;
+};
+
+StatStore&
+GetStatStore() {
+  static StatStore store;
+  return store;
+}
+
+}  // namespace
+
+void
+tsuba::StatAdd(const std::string& name, int64_t value) {
+  StatStore& store = GetStatStore();
+  std::lock_guard<std::mutex> lock(store.mutex);
+  store.ints[name] += value;
+}
+
+void
+tsuba::StatSet(const std::string& name, double value) {
+  StatStore& store = GetStatStore();
+  std::lock_guard<std::mutex> lock(store.mutex);
+  store.fps[name] = value;
+}
+
+void
+tsuba::ForEachStat(
+    const std::function<void(const std::string&, int64_t)>& int_cb,
+    const std::function<void(const std::string&, double)>& fp_cb) {
+  StatStore& store = GetStatStore();
+  std::map<std::string, int64_t> ints;
+  std::map<std::string, double> fps;
+  {
+    // copy so that callbacks may record statistics themselves
+    std::lock_guard<std::mutex> lock(store.mutex);
+    ints = store.ints;
+    fps = store.fps;
+  }
+  for (const auto& [name, value] : ints) {
+    int_cb(name, value);
+  }
+  for (const auto& [name, value] : fps) {
+    fp_cb(name, value);
+  }
+}
+
+void
+tsuba::ResetStats() {
+  StatStore& store = GetStatStore();
+  std::lock_guard<std::mutex> lock(store.mutex);
+  store.ints.clear();
+  store.fps.clear();
+}
@@ -1,7 +1,9 @@
 #include "tsuba/WriteGroup.h"
 
 #include "GlobalState.h"
+#include "galois/Env.h"
 #include "galois/Random.h"
+#include "tsuba/Stats.h"
 
 template <typename T>
 using Result = galois::Result<T>;
@@ -10,50 +12,148 @@ namespace {
 
 constexpr uint32_t kTagLen = 12;
 
+uint64_t
+MicrosecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
 }  // namespace
 
 namespace tsuba {
 
 Result<std::unique_ptr<WriteGroup>>
 WriteGroup::Make() {
+  uint64_t max_in_flight_bytes = kDefaultMaxInFlightBytes;
+  uint64_t max_in_flight_ops = kDefaultMaxInFlightOps;
+  if (int ops = 0; galois::GetEnv("TSUBA_WRITE_MAX_OPS", &ops)) {
+    if (ops < 0) {
+      GALOIS_LOG_WARN("ignoring TSUBA_WRITE_MAX_OPS={}", ops);
+    } else {
+      max_in_flight_ops = ops;
+    }
+  }
+  if (int mb = 0; galois::GetEnv("TSUBA_WRITE_MAX_MB", &mb)) {
+    if (mb < 0) {
+      GALOIS_LOG_WARN("ignoring TSUBA_WRITE_MAX_MB={}", mb);
+    } else {
+      max_in_flight_bytes = static_cast<uint64_t>(mb) << 20;
+    }
+  }
+  return Make(max_in_flight_bytes, max_in_flight_ops);
+}
+
+Result<std::unique_ptr<WriteGroup>>
+WriteGroup::Make(uint64_t max_in_flight_bytes, uint64_t max_in_flight_ops) {
   // Don't use `OneHostOnly` because we can skip its broadcast
   std::string tag;
   if (Comm()->ID == 0) {
     tag = galois::RandomAlphanumericString(kTagLen);
   }
   tag = Comm()->Broadcast(0, tag, kTagLen);
-  return std::unique_ptr<WriteGroup>(new WriteGroup(tag));
+  return std::unique_ptr<WriteGroup>(
+      new WriteGroup(tag, max_in_flight_bytes, max_in_flight_ops));
 }
 
 Result<void>
 WriteGroup::Finish() {
-  Result<void> return_val = galois::ResultSuccess();
-  uint32_t errors = 0;
-
-  for (AsyncOp& op : pending_ops_) {
-    auto res = op.result.get();
-    if (!res) {
-      GALOIS_LOG_DEBUG(
-          "async write op for {} returned {}", op.location, res.error());
-      errors++;
-      return_val = res.error();
-    }
+  while (!pending_ops_.empty()) {
+    Retire(pending_ops_.begin());
   }
 
-  if (errors > 0) {
+  if (errors_ > 0) {
     GALOIS_LOG_ERROR(
-        "{} of {} async write ops returned errors", errors,
-        pending_ops_.size());
+        "{} of {} async write ops returned errors", errors_, total_ops_);
+  }
+
+  if (uint64_t us = MicrosecondsSince(start_); us > 0 && total_bytes_ > 0) {
+    // bytes per microsecond is 1e-3 GB/s
+    StatSet(
+        "WriteGroupGBPerSec", static_cast<double>(total_bytes_) / us / 1e3);
   }
 
+  StatSet("WriteGroupPeakRunningOps", peak_running_ops_);
+  peak_running_ops_ = 0;
+
+  Result<void> return_val = status_;
+  errors_ = 0;
+  status_ = galois::ResultSuccess();
   return return_val;
 }
 
+Result<void>
+WriteGroup::RunOp(const std::function<Result<void>()>& op) {
+  uint64_t running = ++running_ops_;
+  uint64_t peak = peak_running_ops_;
+  while (running > peak &&
+         !peak_running_ops_.compare_exchange_weak(peak, running)) {
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto res = op();
+  StatAdd("WriteGroupOpMicroseconds", MicrosecondsSince(start));
+  StatAdd("WriteGroupOps", 1);
+  --running_ops_;
+  return res;
+}
+
+void
+WriteGroup::Retire(std::list<AsyncOp>::iterator op) {
+  auto res = op->result.get();
+  if (!res) {
+    GALOIS_LOG_DEBUG(
+        "async write op for {} returned {}", op->location, res.error());
+    errors_++;
+    status_ = res.error();
+  }
+  in_flight_bytes_ -= op->size;
+  pending_ops_.erase(op);
+}
+
+void
+WriteGroup::WaitForRoom(uint64_t size) {
+  auto full = [&]() {
+    if (pending_ops_.empty()) {
+      return false;
+    }
+    return (max_in_flight_ops_ > 0 &&
+            pending_ops_.size() >= max_in_flight_ops_) ||
+           (max_in_flight_bytes_ > 0 &&
+            in_flight_bytes_ + size > max_in_flight_bytes_);
+  };
+  if (!full()) {
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  while (full()) {
+    // Prefer any op that is already done; otherwise wait for the oldest
+    auto done = pending_ops_.begin();
+    for (auto it = pending_ops_.begin(); it != pending_ops_.end(); ++it) {
+      if (it->result.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready) {
+        done = it;
+        break;
+      }
+    }
+    Retire(done);
+  }
+  StatAdd("WriteGroupBackpressureMicroseconds", MicrosecondsSince(start));
+}
+
 void
-WriteGroup::AddOp(std::future<galois::Result<void>> future, std::string file) {
+WriteGroup::AddOp(
+    std::future<galois::Result<void>> future, std::string file,
+    uint64_t size) {
+  in_flight_bytes_ += size;
+  total_bytes_ += size;
+  total_ops_++;
+  StatAdd("WriteGroupBytes", size);
   pending_ops_.emplace_back(AsyncOp{
       .result = std::move(future),
       .location = std::move(file),
+      .size = size,
   });
 }
 
@@ -62,12 +162,29 @@ WriteGroup::AddOp(std::future<galois::Result<void>> future, std::string file) {
 void
 WriteGroup::StartStore(std::shared_ptr<FileFrame> ff) {
   std::string file = ff->path();
+  // A streaming FileFrame has stored most of its data already, but still
+  // holds its last part and the parts that are being stored
+  uint64_t size = ff->buffered_bytes();
+  WaitForRoom(size);
 
   // wrap future to hold onto FileFrame, but free it as soon as possible
-  auto future = std::async(std::launch::async, [ff = std::move(ff)]() mutable {
-    return ff->PersistAsync().get();
+  auto future =
+      std::async(std::launch::async, [this, ff = std::move(ff)]() mutable {
+        return RunOp([&]() { return ff->PersistAsync().get(); });
+      });
+  AddOp(std::move(future), file, size);
+}
+
+void
+WriteGroup::StartStore(
+    const std::string& file, const uint8_t* buf, uint64_t size) {
+  WaitForRoom(size);
+  // Local storage puts synchronously, so the write needs its own thread; it
+  // starts only after WaitForRoom and so counts against the bounds
+  auto future = std::async(std::launch::async, [=]() {
+    return RunOp([&]() { return FileStoreAsync(file, buf, size).get(); });
   });
-  AddOp(std::move(future), file);
+  AddOp(std::move(future), file, size);
 }
 
 }  // namespace tsuba
@@ -45,6 +45,40 @@ tsuba::FileGetAsync(
   return FS(uri)->GetAsync(uri, begin, size, result_buffer);
 }
 
+galois::Result<uint8_t*>
+tsuba::FileMmap(const std::string& uri, uint64_t size) {
+  return FS(uri)->Mmap(uri, size);
+}
+
+galois::Result<std::string>
+tsuba::FileMultipartBegin(const std::string& uri, uint64_t part_size) {
+  return FS(uri)->MultipartBegin(uri, part_size);
+}
+
+std::future<galois::Result<void>>
+tsuba::FileMultipartPutAsync(
+    const std::string& uri, const std::string& upload_id, uint64_t part_number,
+    const uint8_t* data, uint64_t size) {
+  return FS(uri)->MultipartPutAsync(uri, upload_id, part_number, data, size);
+}
+
+galois::Result<void>
+tsuba::FileMultipartComplete(
+    const std::string& uri, const std::string& upload_id, uint64_t num_parts) {
+  return FS(uri)->MultipartComplete(uri, upload_id, num_parts);
+}
+
+galois::Result<void>
+tsuba::FileMultipartAbort(
+    const std::string& uri, const std::string& upload_id) {
+  return FS(uri)->MultipartAbort(uri, upload_id);
+}
+
+uint8_t
+tsuba::FilePageShift(const std::string& uri) {
+  return FS(uri)->PageShift();
+}
+
 galois::Result<void>
 tsuba::FileStat(const std::string& uri, StatBuf* s_buf) {
   return FS(uri)->Stat(uri, s_buf);
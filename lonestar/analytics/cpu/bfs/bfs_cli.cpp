@@ -141,14 +141,19 @@ main(int argc, char** argv) {
   }
 
   if (output) {
-    auto r = pfg->NodePropertyTyped<uint32_t>("level");
+    std::shared_ptr<arrow::ChunkedArray> levels = pfg->NodeProperty("level");
+    if (!levels) {
+      GALOIS_LOG_FATAL("Failed to get node property level");
+    }
+    auto r =
+        galois::ConstructPropertyView<galois::UInt32Property>(levels.get());
     if (!r) {
       GALOIS_LOG_FATAL("Failed to get node property {}", r.error());
     }
     auto results = r.value();
-    assert(uint64_t(results->length()) == graph.size());
+    assert(uint64_t(results.size()) == graph.size());
 
-    writeOutput(outputLocation, results->raw_values(), results->length());
+    writeOutput(outputLocation, results, results.size());
   }
 
   totalTime.stop();
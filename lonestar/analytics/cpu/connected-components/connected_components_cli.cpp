@@ -230,14 +230,20 @@ main(int argc, char** argv) {
   }
 
   if (output) {
-    auto r = pfg->NodePropertyTyped<uint64_t>("component");
+    std::shared_ptr<arrow::ChunkedArray> components =
+        pfg->NodeProperty("component");
+    if (!components) {
+      GALOIS_LOG_FATAL("Failed to get node property component");
+    }
+    auto r = galois::ConstructPropertyView<galois::UInt64Property>(
+        components.get());
     if (!r) {
       GALOIS_LOG_FATAL("Failed to get node property {}", r.error());
     }
     auto results = r.value();
-    assert(uint64_t(results->length()) == pfg->topology().num_nodes());
+    assert(uint64_t(results.size()) == pfg->topology().num_nodes());
 
-    writeOutput(outputLocation, results->raw_values(), results->length());
+    writeOutput(outputLocation, results, results.size());
   }
 
   totalTime.stop();
@@ -103,14 +103,20 @@ AlgorithmName(SsspPlan::Algorithm algorithm) {
 template <typename Weight>
 static void
 OutputResults(galois::graphs::PropertyFileGraph* pfg) {
-  auto r = pfg->NodePropertyTyped<Weight>("distance");
+  std::shared_ptr<arrow::ChunkedArray> distances =
+      pfg->NodeProperty("distance");
+  if (!distances) {
+    GALOIS_LOG_FATAL("Error getting results");
+  }
+  auto r = galois::ConstructPropertyView<galois::PODProperty<Weight>>(
+      distances.get());
   if (!r) {
     GALOIS_LOG_FATAL("Error getting results: {}", r.error().message());
   }
   auto results = r.value();
-  assert(uint64_t(results->length()) == pfg->topology().num_nodes());
+  assert(uint64_t(results.size()) == pfg->topology().num_nodes());
 
-  writeOutput(outputLocation, results->raw_values(), results->length());
+  writeOutput(outputLocation, results, results.size());
 }
 
 int
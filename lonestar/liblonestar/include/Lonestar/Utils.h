@@ -43,9 +43,12 @@ MakeFileGraph(
   return std::move(pfg_result.value());
 }
 
-template <typename T>
+/// Write values[0] through values[length - 1] to outputDir. values is a
+/// pointer or a property view.
+template <typename Values>
 void
-writeOutput(const std::string& outputDir, T* values, size_t length) {
+writeOutput(
+    const std::string& outputDir, const Values& values, size_t length) {
   namespace fs = boost::filesystem;
   fs::path filename{outputDir};
   filename = filename.append("output");
@@ -57,7 +60,7 @@ writeOutput(const std::string& outputDir, T* values, size_t length) {
   }
 
   for (size_t i = 0; i < length; i++) {
-    outputFile << i << " " << *(values++) << "\n";
+    outputFile << i << " " << values[i] << "\n";
   }
 
   if (!outputFile) {